@@ -0,0 +1,175 @@
+#include "binlog.h"
+#include "frame_codec.h"
+
+static_assert((BINLOG_BUFFER_SIZE & (BINLOG_BUFFER_SIZE - 1)) == 0,
+              "BINLOG_BUFFER_SIZE must be a power of two");
+static_assert(BINLOG_RECORD_HEADER_SIZE + BINLOG_MAX_ARG_BYTES + 3 <= BINLOG_FRAME_PAYLOAD,
+              "BINLOG_FRAME_PAYLOAD must hold the largest record");
+
+static const uint16_t INDEX_MASK = BINLOG_BUFFER_SIZE - 1;
+
+// Frame header: kind u8 | dropped u16
+static const uint8_t FRAME_HEADER_SIZE = 3;
+
+// Writers advance head with interrupts off (tasks and ISRs log), the single
+// reader in binlog_flush() advances tail
+static uint8_t ring[BINLOG_BUFFER_SIZE];
+static volatile uint16_t ringHead = 0;
+static volatile uint16_t ringTail = 0;
+static volatile uint16_t droppedRecords = 0;
+
+static BinlogWrite frameWrite = nullptr;
+static void* frameContext = nullptr;
+
+// Staging buffers of the reader; static to keep them off task stacks
+static uint8_t payload[BINLOG_FRAME_PAYLOAD];
+static uint8_t frame[FRAME_MAX_ENCODED(BINLOG_FRAME_PAYLOAD)];
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+/**
+ * Disable interrupts, keeping the previous state for unlockRing()
+ * (safe inside ISRs, where interrupts are already off)
+ */
+static inline uint8_t lockRing() {
+#ifdef __AVR__
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+#else
+    noInterrupts();
+    return 0;
+#endif
+}
+
+static inline void unlockRing(uint8_t state) {
+#ifdef __AVR__
+    SREG = state;
+#else
+    (void) state;
+    interrupts();
+#endif
+}
+
+static void ringPut(uint16_t& index, const uint8_t* data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        ring[index] = data[i];
+        index = (index + 1) & INDEX_MASK;
+    }
+}
+
+static void ringGet(uint16_t& index, uint8_t* data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = ring[index];
+        index = (index + 1) & INDEX_MASK;
+    }
+}
+
+static void sendFrame(size_t length) {
+    frameWrite(frame, frame_encode(payload, length, frame), frameContext);
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void binlog_init(BinlogWrite write, void* context) {
+    uint8_t state = lockRing();
+    ringHead = 0;
+    ringTail = 0;
+    droppedRecords = 0;
+    unlockRing(state);
+
+    frameWrite = write;
+    frameContext = context;
+}
+
+bool binlog_record(const char* format, const uint8_t* args, uint8_t argLength) {
+    uint8_t header[BINLOG_RECORD_HEADER_SIZE];
+    uint32_t timestamp = micros();
+    uint16_t id = static_cast<uint16_t>(reinterpret_cast<uintptr_t>(format));
+    memcpy(&header[0], &timestamp, sizeof(timestamp));
+    memcpy(&header[4], &id, sizeof(id));
+    header[6] = argLength;
+
+    uint16_t total = BINLOG_RECORD_HEADER_SIZE + argLength;
+
+    uint8_t state = lockRing();
+    uint16_t head = ringHead;
+    uint16_t used = (head - ringTail) & INDEX_MASK;
+    if (used + total > BINLOG_BUFFER_SIZE - 1) {
+        droppedRecords++;
+        unlockRing(state);
+        return false;
+    }
+    ringPut(head, header, sizeof(header));
+    ringPut(head, args, argLength);
+    ringHead = head;
+    unlockRing(state);
+    return true;
+}
+
+uint16_t binlog_flush() {
+    if (frameWrite == nullptr) {
+        return 0;
+    }
+
+    uint16_t sent = 0;
+    size_t length = 0;
+
+    for (;;) {
+        uint8_t state = lockRing();
+        uint16_t head = ringHead;
+        uint16_t dropped = droppedRecords;
+        unlockRing(state);
+
+        // Records between tail and head are complete and only read here
+        uint16_t tail = ringTail;
+        if (tail == head) {
+            break;
+        }
+
+        uint8_t header[BINLOG_RECORD_HEADER_SIZE];
+        uint16_t peek = tail;
+        ringGet(peek, header, sizeof(header));
+        size_t recordSize = BINLOG_RECORD_HEADER_SIZE + header[6];
+
+        if (length > 0 && length + recordSize > BINLOG_FRAME_PAYLOAD) {
+            sendFrame(length);
+            length = 0;
+        }
+        if (length == 0) {
+            payload[0] = BINLOG_FRAME_KIND;
+            payload[1] = static_cast<uint8_t>(dropped & 0xFF);
+            payload[2] = static_cast<uint8_t>(dropped >> 8);
+            length = FRAME_HEADER_SIZE;
+        }
+
+        memcpy(&payload[length], header, sizeof(header));
+        ringGet(peek, &payload[length + sizeof(header)], header[6]);
+        length += recordSize;
+
+        state = lockRing();
+        ringTail = peek;
+        unlockRing(state);
+        sent++;
+    }
+
+    if (length > 0) {
+        sendFrame(length);
+    }
+    return sent;
+}
+
+uint16_t binlog_dropped() {
+    uint8_t state = lockRing();
+    uint16_t dropped = droppedRecords;
+    unlockRing(state);
+    return dropped;
+}
+
+void binlog_write_print(const uint8_t* data, size_t length, void* context) {
+    static_cast<Print*>(context)->write(data, length);
+}
@@ -0,0 +1,165 @@
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * Deferred binary logging
+ *
+ *   BINLOG("Task2: N = %d, queue %u free", n, spaces);
+ *
+ * stores the flash address of the format string and the raw argument bytes
+ * in a RAM ring instead of formatting on the spot. A call costs a few
+ * microseconds with interrupts briefly disabled, so it is safe in ISRs and
+ * fast paths. binlog_flush() (or the binlog_task.h streaming task) sends
+ * buffered records as frame_codec frames; tools/binlog_decode.py reads the
+ * format strings from the firmware ELF and prints the text on the host.
+ *
+ * Frames are 0x00-delimited and carry a CRC, so they can share the serial
+ * port with ordinary text output; the decoder passes text through.
+ *
+ * Arguments follow printf promotion on the AVR: char, short, int and bool
+ * are sent as int (use %d/%u/%x/%c), long as 4 bytes (%ld/%lu/%lx), float
+ * and double as 4-byte float (%f/%e/%g). Strings cannot be deferred and do
+ * not compile; the format string itself must be a literal.
+ *
+ * Logging is compiled out (arguments are not evaluated) unless
+ * BINLOG_ENABLED is 1, which is the default on the AVR.
+ *
+ * Frame payload (little-endian):
+ *   'L' | dropped u16 (records lost so far, wraps)
+ *   per record: timestamp u32 (micros) | format address u16 | argLength u8 | args
+ */
+
+#ifndef BINLOG_ENABLED
+#ifdef __AVR__
+#define BINLOG_ENABLED 1
+#else
+#define BINLOG_ENABLED 0
+#endif
+#endif
+
+// Ring buffer capacity in bytes (power of two)
+#ifndef BINLOG_BUFFER_SIZE
+#define BINLOG_BUFFER_SIZE 256
+#endif
+
+// Largest argument block of one record
+#ifndef BINLOG_MAX_ARG_BYTES
+#define BINLOG_MAX_ARG_BYTES 16
+#endif
+
+// Largest frame payload sent by binlog_flush()
+#ifndef BINLOG_FRAME_PAYLOAD
+#define BINLOG_FRAME_PAYLOAD 64
+#endif
+
+#define BINLOG_FRAME_KIND 'L'
+#define BINLOG_RECORD_HEADER_SIZE 7
+
+/**
+ * Output sink for finished frames (one call per frame, delimiters included)
+ */
+typedef void (*BinlogWrite)(const uint8_t* data, size_t length, void* context);
+
+/**
+ * Set the frame sink and clear the ring
+ */
+void binlog_init(BinlogWrite write, void* context);
+
+/**
+ * Append one record (use the BINLOG macro)
+ * @param format Format string in PROGMEM
+ * @return false if the ring was full and the record was dropped
+ */
+bool binlog_record(const char* format, const uint8_t* args, uint8_t argLength);
+
+/**
+ * Send every buffered record; call from one task or loop() only
+ * @return Number of records sent
+ */
+uint16_t binlog_flush();
+
+/**
+ * Records lost because the ring was full
+ */
+uint16_t binlog_dropped();
+
+/**
+ * Frame sink that writes to a Print (context = Print*, e.g. &Serial)
+ */
+void binlog_write_print(const uint8_t* data, size_t length, void* context);
+
+// -----------------------------------------------------------------------------
+// Argument packing
+// -----------------------------------------------------------------------------
+
+// Sizes and byte layout of each supported argument type; using any other
+// type (pointers, strings, 64-bit values) fails to compile here
+template <typename T> struct BinlogArg;
+
+template <typename T, typename Wire>
+struct BinlogPromoted {
+    static const uint8_t size = sizeof(Wire);
+    static uint8_t* pack(uint8_t* out, T value) {
+        Wire wire = static_cast<Wire>(value);
+        memcpy(out, &wire, sizeof(Wire));
+        return out + sizeof(Wire);
+    }
+};
+
+template <> struct BinlogArg<bool> : BinlogPromoted<bool, int> {};
+template <> struct BinlogArg<char> : BinlogPromoted<char, int> {};
+template <> struct BinlogArg<signed char> : BinlogPromoted<signed char, int> {};
+template <> struct BinlogArg<unsigned char> : BinlogPromoted<unsigned char, int> {};
+template <> struct BinlogArg<short> : BinlogPromoted<short, int> {};
+template <> struct BinlogArg<unsigned short> : BinlogPromoted<unsigned short, unsigned int> {};
+template <> struct BinlogArg<int> : BinlogPromoted<int, int> {};
+template <> struct BinlogArg<unsigned int> : BinlogPromoted<unsigned int, unsigned int> {};
+template <> struct BinlogArg<long> : BinlogPromoted<long, long> {};
+template <> struct BinlogArg<unsigned long> : BinlogPromoted<unsigned long, unsigned long> {};
+template <> struct BinlogArg<float> : BinlogPromoted<float, float> {};
+template <> struct BinlogArg<double> : BinlogPromoted<double, float> {};
+
+template <typename... Args> struct BinlogArgsSize;
+template <> struct BinlogArgsSize<> {
+    static const uint8_t value = 0;
+};
+template <typename T, typename... Rest> struct BinlogArgsSize<T, Rest...> {
+    static const uint8_t value = BinlogArg<T>::size + BinlogArgsSize<Rest...>::value;
+};
+
+inline uint8_t* binlog_pack(uint8_t* out) {
+    return out;
+}
+
+template <typename T, typename... Rest>
+inline uint8_t* binlog_pack(uint8_t* out, T value, Rest... rest) {
+    return binlog_pack(BinlogArg<T>::pack(out, value), rest...);
+}
+
+template <typename... Args>
+inline bool binlog_log(const char* format, Args... args) {
+    static_assert(BinlogArgsSize<Args...>::value <= BINLOG_MAX_ARG_BYTES,
+                  "Too many BINLOG argument bytes (raise BINLOG_MAX_ARG_BYTES)");
+    uint8_t packed[BinlogArgsSize<Args...>::value + 1];
+    binlog_pack(packed, args...);
+    return binlog_record(format, packed, BinlogArgsSize<Args...>::value);
+}
+
+#if BINLOG_ENABLED
+
+#define BINLOG(format, ...)                                              \
+    do {                                                                 \
+        static const char binlogFormat_[] PROGMEM = format;              \
+        binlog_log(binlogFormat_, ##__VA_ARGS__);                        \
+    } while (0)
+
+#else
+
+#define BINLOG(format, ...) ((void)0)
+
+#endif // BINLOG_ENABLED
+
+#endif // BINLOG_H
@@ -0,0 +1,19 @@
+#include "binlog_task.h"
+#include <task.h>
+
+static TickType_t flushPeriod = 1;
+
+static void binlogTask(void* pvParameters) {
+    (void) pvParameters;
+    TickType_t lastWakeTime = xTaskGetTickCount();
+
+    for (;;) {
+        binlog_flush();
+        vTaskDelayUntil(&lastWakeTime, flushPeriod);
+    }
+}
+
+bool binlog_start_task(UBaseType_t priority, uint16_t stackDepth, TickType_t period) {
+    flushPeriod = period > 0 ? period : 1;
+    return xTaskCreate(binlogTask, "BinLog", stackDepth, nullptr, priority, nullptr) == pdPASS;
+}
@@ -0,0 +1,17 @@
+#ifndef BINLOG_TASK_H
+#define BINLOG_TASK_H
+
+#include <Arduino_FreeRTOS.h>
+#include "binlog.h"
+
+/**
+ * Stream buffered records from a low-priority FreeRTOS task
+ *
+ * The task calls binlog_flush() every period, so loggers never wait for the
+ * serial port; pick a period short enough that the ring cannot fill up at
+ * the expected log rate.
+ * @return false if the task could not be created
+ */
+bool binlog_start_task(UBaseType_t priority, uint16_t stackDepth, TickType_t period);
+
+#endif // BINLOG_TASK_H
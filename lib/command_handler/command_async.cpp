@@ -0,0 +1,373 @@
+#include "command_async.h"
+#include <queue.h>
+#include <task.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert(COMMAND_ASYNC_JOBS < 255, "Job slot indices are 8-bit");
+
+struct CommandJob {
+    uint8_t id;                       // 0 while the slot was never used
+    CommandJobState state;
+    bool inQueue;                     // Index still in the queue (slot not reusable)
+    bool cancelRequested;
+    TaskHandle_t worker;              // Running worker, nullptr otherwise
+    const CommandEntry* entry;
+    FILE* out;                        // Sink of the input that queued the job
+    CommandArg typedArgs[COMMAND_MAX_ARGS];
+    char args[COMMAND_ASYNC_ARGS_LENGTH];
+    bool hasArgs;
+};
+
+// Job slots are shared by the command task and the workers; every access to
+// state, inQueue, cancelRequested and worker happens in a critical section
+static CommandJob jobs[COMMAND_ASYNC_JOBS];
+static QueueHandle_t jobQueue = nullptr;
+static uint8_t nextJobId = 1;
+
+static const char* const JOB_STATE_NAMES[] = {
+    "free", "queued", "running", "done", "failed", "cancelled"
+};
+
+static const CommandArgSpec JOB_ID_ARGS[] = {
+    COMMAND_ARG_INT("id", 1, 255),
+};
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+static CommandJob* findJob(uint8_t id) {
+    for (uint8_t i = 0; i < COMMAND_ASYNC_JOBS; i++) {
+        if (jobs[i].id == id && jobs[i].state != CMD_JOB_FREE) {
+            return &jobs[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Job run by the calling worker, or nullptr (call in a critical section)
+ */
+static CommandJob* currentJob() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (uint8_t i = 0; i < COMMAND_ASYNC_JOBS; i++) {
+        if (jobs[i].state == CMD_JOB_RUNNING && jobs[i].worker == self) {
+            return &jobs[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Claim a slot that is neither queued nor running (call in a critical section)
+ */
+static int8_t claimSlot() {
+    int8_t finished = -1;
+    for (uint8_t i = 0; i < COMMAND_ASYNC_JOBS; i++) {
+        if (jobs[i].inQueue || jobs[i].state == CMD_JOB_QUEUED || jobs[i].state == CMD_JOB_RUNNING) {
+            continue;
+        }
+        if (jobs[i].state == CMD_JOB_FREE) {
+            return static_cast<int8_t>(i);
+        }
+        if (finished < 0) {
+            finished = static_cast<int8_t>(i);
+        }
+    }
+    return finished;
+}
+
+/**
+ * Copy the validated arguments into the job (they point into the line buffer)
+ */
+static bool copyArgs(CommandJob* job, const char* args, const CommandArg* typedArgs) {
+    job->hasArgs = false;
+
+    if (job->entry->typedCallback != nullptr) {
+        size_t used = 0;
+        for (uint8_t i = 0; i < job->entry->argCount; i++) {
+            job->typedArgs[i] = typedArgs[i];
+            if (typedArgs[i].text == nullptr) {
+                continue;
+            }
+            if (used + typedArgs[i].length > COMMAND_ASYNC_ARGS_LENGTH) {
+                return false;
+            }
+            memcpy(&job->args[used], typedArgs[i].text, typedArgs[i].length);
+            job->typedArgs[i].text = &job->args[used];
+            used += typedArgs[i].length;
+        }
+        return true;
+    }
+
+    if (args != nullptr) {
+        if (strlen(args) >= COMMAND_ASYNC_ARGS_LENGTH) {
+            return false;
+        }
+        strcpy(job->args, args);
+        job->hasArgs = true;
+    }
+    return true;
+}
+
+static CommandDispatch dispatchHook(void* context, const CommandEntry* entry,
+                                    const char* args, const CommandArg* typedArgs) {
+    (void) context;
+
+    // Urgent inline command: clear the way, then run it right here
+    if (!(entry->flags & COMMAND_FLAG_ASYNC)) {
+        commandAsyncCancelAll();
+        return CMD_DISPATCH_INLINE;
+    }
+
+    taskENTER_CRITICAL();
+    int8_t index = claimSlot();
+    if (index >= 0) {
+        // IDs wrap, so forget a finished job that still holds this one
+        CommandJob* stale = findJob(nextJobId);
+        if (stale != nullptr) {
+            stale->state = CMD_JOB_FREE;
+        }
+        jobs[index].id = nextJobId;
+        jobs[index].state = CMD_JOB_QUEUED;
+        jobs[index].inQueue = true;
+        nextJobId = (nextJobId == 255) ? 1 : nextJobId + 1;
+    }
+    taskEXIT_CRITICAL();
+
+    if (index < 0) {
+        commandHandlerPrintf("Error: job queue full\r\n");
+        return CMD_DISPATCH_REJECTED;
+    }
+
+    CommandJob* job = &jobs[index];
+    job->entry = entry;
+    job->out = commandHandlerOutput();
+    job->cancelRequested = false;
+    job->worker = nullptr;
+
+    bool queued = copyArgs(job, args, typedArgs);
+    if (!queued) {
+        commandHandlerPrintf("Error: arguments too long for a job\r\n");
+    } else {
+        uint8_t slot = static_cast<uint8_t>(index);
+        BaseType_t sent = (entry->flags & COMMAND_FLAG_URGENT)
+                              ? xQueueSendToFront(jobQueue, &slot, 0)
+                              : xQueueSendToBack(jobQueue, &slot, 0);
+        queued = (sent == pdTRUE);
+        if (!queued) {
+            commandHandlerPrintf("Error: job queue full\r\n");
+        }
+    }
+
+    if (!queued) {
+        taskENTER_CRITICAL();
+        job->state = CMD_JOB_FREE;
+        job->inQueue = false;
+        taskEXIT_CRITICAL();
+        return CMD_DISPATCH_REJECTED;
+    }
+
+    commandHandlerPrintf("Job %u queued\r\n", job->id);
+    return CMD_DISPATCH_QUEUED;
+}
+
+/**
+ * A job prints to the input that queued it, whatever the command task is
+ * dispatching meanwhile
+ */
+static FILE* jobOutput() {
+    taskENTER_CRITICAL();
+    CommandJob* job = currentJob();
+    FILE* out = job != nullptr ? job->out : nullptr;
+    taskEXIT_CRITICAL();
+    return out;
+}
+
+static void workerTask(void* pvParameters) {
+    (void) pvParameters;
+    uint8_t index;
+
+    for (;;) {
+        if (xQueueReceive(jobQueue, &index, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        CommandJob* job = &jobs[index];
+
+        // Jobs cancelled while queued are only dropped here
+        taskENTER_CRITICAL();
+        job->inQueue = false;
+        bool run = (job->state == CMD_JOB_QUEUED);
+        if (run) {
+            job->state = CMD_JOB_RUNNING;
+            job->worker = xTaskGetCurrentTaskHandle();
+        }
+        taskEXIT_CRITICAL();
+        if (!run) {
+            continue;
+        }
+
+        // Drop wakeups left over from a previous job
+        ulTaskNotifyTake(pdTRUE, 0);
+
+        bool result = commandHandlerRun(job->entry, job->hasArgs ? job->args : nullptr, job->typedArgs);
+
+        taskENTER_CRITICAL();
+        job->state = job->cancelRequested ? CMD_JOB_CANCELLED : (result ? CMD_JOB_DONE : CMD_JOB_FAILED);
+        job->worker = nullptr;
+        taskEXIT_CRITICAL();
+
+        fprintf(job->out, "Job %u %s\r\n", job->id, JOB_STATE_NAMES[job->state]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Command callbacks
+// -----------------------------------------------------------------------------
+
+static void printJob(const CommandJob* job) {
+    commandHandlerPrintf("  #%u ", job->id);
+    commandHandlerPrintName(job->entry);
+    commandHandlerPrintf(" - %s\r\n", JOB_STATE_NAMES[job->state]);
+}
+
+static bool cmdJobList(void* context, const char* args) {
+    (void) context;
+    (void) args;
+
+    uint8_t shown = 0;
+    commandHandlerPrintf("\r\nJobs:\r\n");
+    for (uint8_t i = 0; i < COMMAND_ASYNC_JOBS; i++) {
+        if (jobs[i].state != CMD_JOB_FREE) {
+            printJob(&jobs[i]);
+            shown++;
+        }
+    }
+    if (shown == 0) {
+        commandHandlerPrintf("  (none)\r\n");
+    }
+    commandHandlerPrintf("\r\n");
+    return true;
+}
+
+static bool cmdJobStatus(void* context, const CommandArg* args, uint8_t argCount) {
+    (void) context;
+    (void) argCount;
+
+    uint8_t id = static_cast<uint8_t>(args[0].value);
+    CommandJob* job = findJob(id);
+    if (job == nullptr) {
+        commandHandlerPrintf("Error: no job %u\r\n", id);
+        return false;
+    }
+    printJob(job);
+    return true;
+}
+
+static bool cmdJobCancel(void* context, const CommandArg* args, uint8_t argCount) {
+    (void) context;
+    (void) argCount;
+
+    uint8_t id = static_cast<uint8_t>(args[0].value);
+    if (!commandAsyncCancel(id)) {
+        commandHandlerPrintf("Error: job %u is not queued or running\r\n", id);
+        return false;
+    }
+    commandHandlerPrintf("Job %u cancelling\r\n", id);
+    return true;
+}
+
+static const char NAME_JOB_LIST[] PROGMEM = "job list";
+static const char NAME_JOB_STATUS[] PROGMEM = "job status";
+static const char NAME_JOB_CANCEL[] PROGMEM = "job cancel";
+static const char DESC_JOB_LIST[] PROGMEM = "List jobs";
+static const char DESC_JOB_STATUS[] PROGMEM = "Show one job";
+static const char DESC_JOB_CANCEL[] PROGMEM = "Cancel a queued or running job";
+
+static const CommandTableEntry JOB_COMMANDS[] PROGMEM = {
+    COMMAND_TABLE_ENTRY(NAME_JOB_LIST, cmdJobList, DESC_JOB_LIST),
+    COMMAND_TABLE_TYPED(NAME_JOB_STATUS, cmdJobStatus, JOB_ID_ARGS, 1, DESC_JOB_STATUS),
+    COMMAND_TABLE_TYPED(NAME_JOB_CANCEL, cmdJobCancel, JOB_ID_ARGS, 1, DESC_JOB_CANCEL),
+};
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool commandAsyncInit(CommandHandler* handler, UBaseType_t priority, uint16_t stackDepth) {
+    memset(jobs, 0, sizeof(jobs));
+    jobQueue = xQueueCreate(COMMAND_ASYNC_QUEUE_LENGTH, sizeof(uint8_t));
+    if (jobQueue == nullptr) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < COMMAND_ASYNC_WORKERS; i++) {
+        if (xTaskCreate(workerTask, "CmdJob", stackDepth, nullptr, priority, nullptr) != pdPASS) {
+            return false;
+        }
+    }
+
+    commandHandlerRegisterTable(handler, JOB_COMMANDS, sizeof(JOB_COMMANDS) / sizeof(JOB_COMMANDS[0]), nullptr);
+    commandHandlerSetDispatchHook(handler, dispatchHook, nullptr);
+    commandHandlerSetOutputHook(jobOutput);
+    return true;
+}
+
+bool commandAsyncCancel(uint8_t id) {
+    TaskHandle_t wake = nullptr;
+    bool cancelled = false;
+
+    taskENTER_CRITICAL();
+    CommandJob* job = findJob(id);
+    if (job != nullptr && job->state == CMD_JOB_QUEUED) {
+        job->state = CMD_JOB_CANCELLED;
+        cancelled = true;
+    } else if (job != nullptr && job->state == CMD_JOB_RUNNING && !job->cancelRequested) {
+        job->cancelRequested = true;
+        wake = job->worker;
+        cancelled = true;
+    }
+    taskEXIT_CRITICAL();
+
+    // Cut a commandAsyncDelay() short
+    if (wake != nullptr) {
+        xTaskNotifyGive(wake);
+    }
+    return cancelled;
+}
+
+uint8_t commandAsyncCancelAll() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < COMMAND_ASYNC_JOBS; i++) {
+        if (jobs[i].id != 0 && commandAsyncCancel(jobs[i].id)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+CommandJobState commandAsyncStatus(uint8_t id) {
+    taskENTER_CRITICAL();
+    CommandJob* job = findJob(id);
+    CommandJobState state = job != nullptr ? job->state : CMD_JOB_FREE;
+    taskEXIT_CRITICAL();
+    return state;
+}
+
+bool commandAsyncCancelled() {
+    taskENTER_CRITICAL();
+    CommandJob* job = currentJob();
+    bool cancelled = job != nullptr && job->cancelRequested;
+    taskEXIT_CRITICAL();
+    return cancelled;
+}
+
+bool commandAsyncDelay(TickType_t ticks) {
+    if (commandAsyncCancelled()) {
+        return false;
+    }
+    // A cancel notifies the worker; other wakeups just end the wait early
+    ulTaskNotifyTake(pdTRUE, ticks);
+    return !commandAsyncCancelled();
+}
@@ -0,0 +1,96 @@
+#ifndef COMMAND_ASYNC_H
+#define COMMAND_ASYNC_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include <stdint.h>
+#include "command_handler.h"
+
+/**
+ * FreeRTOS worker pool for long-running commands
+ *
+ * Commands flagged COMMAND_FLAG_ASYNC are validated on the command task as
+ * usual, then copied into a job and queued for a worker task; the command
+ * task prints the job ID and goes back to parsing input. Commands flagged
+ * COMMAND_FLAG_URGENT bypass queued work:
+ *   - ASYNC | URGENT jobs are queued at the front of the queue
+ *   - URGENT inline commands (e.g. "motor stop") first cancel every queued
+ *     and running job, then run immediately on the command task
+ *
+ * Cancellation is cooperative: a running callback polls
+ * commandAsyncCancelled() or sleeps with commandAsyncDelay(), which returns
+ * early once the job is cancelled.
+ *
+ * The completion line ("Job 3 done") and everything the callback prints
+ * with commandHandlerPrintf() go to the sink of the input that queued the
+ * job, even while the command task dispatches input from another port.
+ *
+ * Registered commands: "job list", "job status <id>", "job cancel <id>"
+ * (ids are typed, 1-255).
+ */
+
+#ifndef COMMAND_ASYNC_WORKERS
+#define COMMAND_ASYNC_WORKERS 1
+#endif
+
+#ifndef COMMAND_ASYNC_QUEUE_LENGTH
+#define COMMAND_ASYNC_QUEUE_LENGTH 3
+#endif
+
+// Copied argument text per job (STRING tokens or untyped argument text)
+#ifndef COMMAND_ASYNC_ARGS_LENGTH
+#define COMMAND_ASYNC_ARGS_LENGTH 24
+#endif
+
+// Every queued or running job needs a slot; finished jobs keep theirs for
+// "job list"/"job status" until the slot is reused
+#define COMMAND_ASYNC_JOBS (COMMAND_ASYNC_QUEUE_LENGTH + COMMAND_ASYNC_WORKERS)
+
+enum CommandJobState : uint8_t {
+    CMD_JOB_FREE,         // Unknown ID or slot never used
+    CMD_JOB_QUEUED,
+    CMD_JOB_RUNNING,
+    CMD_JOB_DONE,         // Callback returned true
+    CMD_JOB_FAILED,       // Callback returned false
+    CMD_JOB_CANCELLED     // Cancelled while queued or running
+};
+
+/**
+ * Start the workers, register the job commands and install the dispatch hook
+ * @param handler Command handler whose flagged commands become jobs
+ * @param priority Worker task priority (below the command task keeps input responsive)
+ * @param stackDepth Worker task stack size
+ * @return false if the queue or a worker could not be created
+ */
+bool commandAsyncInit(CommandHandler* handler, UBaseType_t priority, uint16_t stackDepth);
+
+/**
+ * Cancel a queued job or ask a running job to stop
+ * @return false if the job is not queued or running
+ */
+bool commandAsyncCancel(uint8_t id);
+
+/**
+ * Cancel every queued and running job
+ * @return Number of jobs cancelled
+ */
+uint8_t commandAsyncCancelAll();
+
+/**
+ * State of a job by ID
+ */
+CommandJobState commandAsyncStatus(uint8_t id);
+
+/**
+ * For job callbacks: true once the calling job has been cancelled
+ * (always false outside a worker)
+ */
+bool commandAsyncCancelled();
+
+/**
+ * For job callbacks: sleep, waking early if the job is cancelled
+ * @return false if the job was cancelled
+ */
+bool commandAsyncDelay(TickType_t ticks);
+
+#endif
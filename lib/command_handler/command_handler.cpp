@@ -2,50 +2,679 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdarg.h>
 
-static int strcasecmp_arduino(const char* s1, const char* s2) {
-    while (*s1 && *s2) {
-        char c1 = tolower(*s1);
-        char c2 = tolower(*s2);
-        if (c1 != c2) {
-            return c1 - c2;
+static_assert(MAX_COMMANDS <= 127, "MAX_COMMANDS must keep trie node indices below COMMAND_TRIE_NONE");
+static_assert(MAX_COMMAND_NAME_LENGTH <= 255, "Trie labels use 8-bit offsets");
+
+// Sink of the input being dispatched (nullptr: stdout)
+static FILE* currentOutput = nullptr;
+static CommandOutputHook outputHook = nullptr;
+
+// -----------------------------------------------------------------------------
+// Command name trie
+// -----------------------------------------------------------------------------
+
+static char entryChar(const CommandEntry* entry, const char* text, size_t offset) {
+    return (entry->flags & COMMAND_FLAG_PROGMEM) ? static_cast<char>(pgm_read_byte(text + offset)) : text[offset];
+}
+
+static char trieNameChar(const CommandHandler* handler, uint8_t command, uint8_t offset) {
+    const CommandEntry* entry = &handler->commands[command];
+    return tolower(entryChar(entry, entry->name, offset));
+}
+
+static uint8_t trieNewNode(CommandHandler* handler, uint8_t labelCommand,
+                           uint8_t labelStart, uint8_t labelLength) {
+    uint8_t index = handler->trieNodeCount++;
+    CommandTrieNode* node = &handler->trie[index];
+    node->labelCommand = labelCommand;
+    node->labelStart = labelStart;
+    node->labelLength = labelLength;
+    node->firstChild = COMMAND_TRIE_NONE;
+    node->nextSibling = COMMAND_TRIE_NONE;
+    node->command = COMMAND_TRIE_NONE;
+    return index;
+}
+
+/**
+ * Child of `parent` whose edge label starts with c (already lowercase)
+ */
+static uint8_t trieFindChild(const CommandHandler* handler, uint8_t parent, char c) {
+    uint8_t child = handler->trie[parent].firstChild;
+    while (child != COMMAND_TRIE_NONE) {
+        const CommandTrieNode* node = &handler->trie[child];
+        if (trieNameChar(handler, node->labelCommand, node->labelStart) == c) {
+            return child;
+        }
+        child = node->nextSibling;
+    }
+    return COMMAND_TRIE_NONE;
+}
+
+/**
+ * Insert commands[command] into the trie
+ * @return false if an identical name is already registered
+ */
+static bool trieInsert(CommandHandler* handler, uint8_t command, uint8_t nameLen) {
+    uint8_t parent = 0;
+    uint8_t pos = 0;
+
+    for (;;) {
+        if (pos == nameLen) {
+            if (handler->trie[parent].command != COMMAND_TRIE_NONE) {
+                return false;  // Duplicate command
+            }
+            handler->trie[parent].command = command;
+            return true;
+        }
+
+        uint8_t child = trieFindChild(handler, parent, trieNameChar(handler, command, pos));
+        if (child == COMMAND_TRIE_NONE) {
+            // New leaf holding the rest of the name
+            uint8_t leaf = trieNewNode(handler, command, pos, nameLen - pos);
+            handler->trie[leaf].command = command;
+            handler->trie[leaf].nextSibling = handler->trie[parent].firstChild;
+            handler->trie[parent].firstChild = leaf;
+            return true;
+        }
+
+        CommandTrieNode* node = &handler->trie[child];
+        uint8_t common = 1;
+        while (common < node->labelLength && pos + common < nameLen &&
+               trieNameChar(handler, node->labelCommand, node->labelStart + common) ==
+               trieNameChar(handler, command, pos + common)) {
+            common++;
+        }
+
+        if (common < node->labelLength) {
+            // Split the edge: parent -> middle -> child
+            uint8_t middle = trieNewNode(handler, node->labelCommand, node->labelStart, common);
+            node = &handler->trie[child];
+            handler->trie[middle].firstChild = child;
+            handler->trie[middle].nextSibling = node->nextSibling;
+            node->nextSibling = COMMAND_TRIE_NONE;
+            node->labelStart += common;
+            node->labelLength -= common;
+
+            // Relink middle in place of child
+            uint8_t* link = &handler->trie[parent].firstChild;
+            while (*link != child) {
+                link = &handler->trie[*link].nextSibling;
+            }
+            *link = middle;
+            child = middle;
         }
-        s1++;
-        s2++;
+
+        parent = child;
+        pos += common;
     }
-    return tolower(*s1) - tolower(*s2);
 }
 
-static int strncasecmp_arduino(const char* s1, const char* s2, size_t n) {
-    size_t i = 0;
-    while (i < n && *s1 && *s2) {
-        char c1 = tolower(*s1);
-        char c2 = tolower(*s2);
-        if (c1 != c2) {
-            return c1 - c2;
+/**
+ * Walk the trie along input
+ * @param exact Only accept a name equal to the whole input; otherwise accept
+ *              the longest name followed by end of input or whitespace
+ * @param matchLen Receives the matched name length
+ * @return Command index or COMMAND_TRIE_NONE
+ */
+static uint8_t trieMatch(const CommandHandler* handler, const char* input, bool exact, size_t* matchLen) {
+    uint8_t node = 0;
+    size_t pos = 0;
+    uint8_t best = COMMAND_TRIE_NONE;
+
+    for (;;) {
+        const CommandTrieNode* n = &handler->trie[node];
+        char next = input[pos];
+        if (n->command != COMMAND_TRIE_NONE && (next == '\0' || (!exact && isspace(next)))) {
+            best = n->command;
+            *matchLen = pos;
+        }
+        if (next == '\0') {
+            break;
+        }
+
+        node = trieFindChild(handler, node, tolower(next));
+        if (node == COMMAND_TRIE_NONE) {
+            break;
+        }
+
+        // First label character matched in trieFindChild
+        n = &handler->trie[node];
+        for (uint8_t i = 1; i < n->labelLength; i++) {
+            if (input[pos + i] == '\0' ||
+                tolower(input[pos + i]) != trieNameChar(handler, n->labelCommand, n->labelStart + i)) {
+                return best;
+            }
         }
-        s1++;
-        s2++;
+        pos += n->labelLength;
+    }
+
+    return best;
+}
+
+// -----------------------------------------------------------------------------
+// Typed argument parsing
+// -----------------------------------------------------------------------------
+
+static void printFixed(int32_t value, uint8_t decimals) {
+    int32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    uint32_t magnitude = value < 0 ? static_cast<uint32_t>(-(value + 1)) + 1 : static_cast<uint32_t>(value);
+    commandHandlerPrintf("%s%lu", value < 0 ? "-" : "", static_cast<unsigned long>(magnitude / scale));
+    if (decimals > 0) {
+        commandHandlerPrintf(".%0*lu", decimals, static_cast<unsigned long>(magnitude % scale));
+    }
+}
+
+static void printArgSpec(const CommandArgSpec* spec) {
+    commandHandlerPrintf("<%s", spec->name);
+    switch (spec->type) {
+        case CMD_ARG_INT:
+            commandHandlerPrintf(":%ld..%ld", static_cast<long>(spec->min), static_cast<long>(spec->max));
+            break;
+        case CMD_ARG_FIXED:
+            commandHandlerPrintf(":");
+            printFixed(spec->min, spec->decimals);
+            commandHandlerPrintf("..");
+            printFixed(spec->max, spec->decimals);
+            break;
+        case CMD_ARG_ENUM:
+            for (int32_t i = 0; i <= spec->max; i++) {
+                commandHandlerPrintf("%c%s", i == 0 ? ':' : '|', spec->choices[i]);
+            }
+            break;
+        case CMD_ARG_STRING:
+            break;
+    }
+    commandHandlerPrintf(">");
+}
+
+/**
+ * Print a name or description from RAM or flash
+ */
+static size_t printEntryText(const CommandEntry* entry, const char* text) {
+    FILE* out = commandHandlerOutput();
+    char c;
+    size_t i;
+    for (i = 0; (c = entryChar(entry, text, i)) != '\0'; i++) {
+        fputc(c, out);
+    }
+    return i;
+}
+
+static void printUsage(const CommandEntry* entry) {
+    commandHandlerPrintf("Usage: ");
+    printEntryText(entry, entry->name);
+    for (uint8_t i = 0; i < entry->argCount; i++) {
+        commandHandlerPrintf(" ");
+        printArgSpec(&entry->argSpecs[i]);
+    }
+    commandHandlerPrintf("\r\n");
+}
+
+/**
+ * Parse [sign]digits[.digits] into a value scaled by 10^decimals
+ * @return false on syntax error, excess decimals or overflow
+ */
+static bool parseNumber(const char* text, uint8_t length, uint8_t decimals, int32_t* value) {
+    uint8_t i = 0;
+    bool negative = false;
+    if (i < length && (text[i] == '-' || text[i] == '+')) {
+        negative = (text[i] == '-');
         i++;
     }
-    if (i >= n) {
-        return 0;
+
+    // 32-bit accumulation with explicit overflow checks (no 64-bit math on AVR)
+    uint32_t magnitude = 0;
+    uint8_t digits = 0;
+    uint8_t fraction = 0;
+    bool point = false;
+    for (; i < length; i++) {
+        char c = text[i];
+        if (c == '.' && decimals > 0 && !point) {
+            point = true;
+            continue;
+        }
+        if (!isdigit(c) || (point && fraction >= decimals)) {
+            return false;
+        }
+        uint8_t digit = c - '0';
+        if (magnitude > static_cast<uint32_t>(INT32_MAX - digit) / 10) {
+            return false;
+        }
+        magnitude = magnitude * 10 + digit;
+        digits++;
+        if (point) {
+            fraction++;
+        }
+    }
+    if (digits == 0) {
+        return false;
+    }
+
+    for (; fraction < decimals; fraction++) {
+        if (magnitude > INT32_MAX / 10) {
+            return false;
+        }
+        magnitude *= 10;
+    }
+
+    *value = negative ? -static_cast<int32_t>(magnitude) : static_cast<int32_t>(magnitude);
+    return true;
+}
+
+static bool tokenEqualsIgnoreCase(const char* text, uint8_t length, const char* word) {
+    for (uint8_t i = 0; i < length; i++) {
+        if (word[i] == '\0' || tolower(text[i]) != tolower(word[i])) {
+            return false;
+        }
+    }
+    return word[length] == '\0';
+}
+
+/**
+ * Check a parsed value against its schema entry
+ */
+static bool argInRange(const CommandArgSpec* spec, const CommandArg* arg) {
+    if (spec->type == CMD_ARG_STRING) {
+        return arg->length >= spec->min && arg->length <= spec->max;
+    }
+    return arg->value >= spec->min && arg->value <= spec->max;
+}
+
+/**
+ * Tokenize args in place and validate them against the entry's schema
+ * @return true if every argument is present and valid
+ */
+static bool parseTypedArgs(const CommandEntry* entry, const char* args, CommandArg* out) {
+    const char* p = args != nullptr ? args : "";
+
+    for (uint8_t i = 0; i < entry->argCount; i++) {
+        const CommandArgSpec* spec = &entry->argSpecs[i];
+
+        while (isspace(*p)) {
+            p++;
+        }
+        const char* start = p;
+        while (*p != '\0' && !isspace(*p)) {
+            p++;
+        }
+        if (p == start) {
+            commandHandlerPrintf("Error: missing %s\r\n", spec->name);
+            return false;
+        }
+        if (p - start > 255) {
+            commandHandlerPrintf("Error: %s too long\r\n", spec->name);
+            return false;
+        }
+
+        CommandArg* arg = &out[i];
+        arg->text = start;
+        arg->length = static_cast<uint8_t>(p - start);
+
+        bool valid = true;
+        switch (spec->type) {
+            case CMD_ARG_INT:
+            case CMD_ARG_FIXED:
+                valid = parseNumber(arg->text, arg->length,
+                                    spec->type == CMD_ARG_FIXED ? spec->decimals : 0, &arg->value);
+                break;
+            case CMD_ARG_ENUM:
+                valid = false;
+                for (int32_t c = 0; c <= spec->max && !valid; c++) {
+                    if (tokenEqualsIgnoreCase(arg->text, arg->length, spec->choices[c])) {
+                        arg->value = c;
+                        valid = true;
+                    }
+                }
+                break;
+            case CMD_ARG_STRING:
+                arg->value = arg->length;
+                break;
+        }
+
+        if (!valid || !argInRange(spec, arg)) {
+            commandHandlerPrintf("Error: invalid %s '%.*s', expected ", spec->name, arg->length, arg->text);
+            printArgSpec(spec);
+            commandHandlerPrintf("\r\n");
+            return false;
+        }
+    }
+
+    while (isspace(*p)) {
+        p++;
+    }
+    if (*p != '\0') {
+        commandHandlerPrintf("Error: unexpected '%s'\r\n", p);
+        return false;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Command resolution and batches
+// -----------------------------------------------------------------------------
+
+/**
+ * Match the command at the start of a line
+ * @param line Command line without leading whitespace
+ * @param args Receives the argument text or nullptr if there is none
+ * @return Matching entry or nullptr
+ */
+static const CommandEntry* resolveCommand(const CommandHandler* handler, const char* line, const char** args) {
+    // Longest registered name that prefixes the input and ends at a word
+    // boundary (supports multi-word commands like "relay on")
+    size_t matchLen = 0;
+    uint8_t match = trieMatch(handler, line, false, &matchLen);
+    if (match == COMMAND_TRIE_NONE) {
+        return nullptr;
+    }
+
+    // Extract arguments (everything after the command name)
+    const char* p = line + matchLen;
+    while (isspace(*p)) {
+        p++;
+    }
+    *args = (*p == '\0') ? nullptr : p;
+    return &handler->commands[match];
+}
+
+/**
+ * Split a batch in place at separators outside double quotes, trimming
+ * whitespace and dropping empty commands
+ * @return Number of commands, COMMAND_BATCH_MAX + 1 if there are too many
+ */
+static uint8_t splitBatch(char* line, char** segments) {
+    uint8_t count = 0;
+    bool quoted = false;
+    char* start = line;
+
+    for (char* p = line;; p++) {
+        if (*p == '"') {
+            quoted = !quoted;
+            continue;
+        }
+        if (*p != '\0' && (*p != COMMAND_BATCH_SEPARATOR || quoted)) {
+            continue;
+        }
+
+        bool last = (*p == '\0');
+        *p = '\0';
+
+        while (isspace(*start)) {
+            start++;
+        }
+        char* end = p;
+        while (end > start && isspace(end[-1])) {
+            *--end = '\0';
+        }
+        if (*start != '\0') {
+            if (count == COMMAND_BATCH_MAX) {
+                return COMMAND_BATCH_MAX + 1;
+            }
+            segments[count++] = start;
+        }
+
+        if (last) {
+            return count;
+        }
+        start = p + 1;
     }
-    return tolower(*s1) - tolower(*s2);
 }
 
+// -----------------------------------------------------------------------------
+// Binary frames
+// -----------------------------------------------------------------------------
+
+static void frameWriteOutput(uint8_t value, void* context) {
+    fputc(value, static_cast<FILE*>(context));
+}
+
+static void sendFrameResponse(uint8_t command, CommandFrameStatus status) {
+    uint8_t response[2] = {command, status};
+    frame_write(response, sizeof(response), frameWriteOutput, commandHandlerOutput());
+}
+
+/**
+ * Unpack binary arguments in place and validate them against the schema
+ */
+static bool parseFrameArgs(const CommandEntry* entry, const uint8_t* data, size_t length, CommandArg* out) {
+    size_t pos = 0;
+
+    for (uint8_t i = 0; i < entry->argCount; i++) {
+        const CommandArgSpec* spec = &entry->argSpecs[i];
+        CommandArg* arg = &out[i];
+        arg->text = nullptr;
+        arg->length = 0;
+
+        switch (spec->type) {
+            case CMD_ARG_INT:
+            case CMD_ARG_FIXED:
+                if (pos + 4 > length) {
+                    return false;
+                }
+                arg->value = static_cast<int32_t>(static_cast<uint32_t>(data[pos]) |
+                                                  (static_cast<uint32_t>(data[pos + 1]) << 8) |
+                                                  (static_cast<uint32_t>(data[pos + 2]) << 16) |
+                                                  (static_cast<uint32_t>(data[pos + 3]) << 24));
+                pos += 4;
+                break;
+            case CMD_ARG_ENUM:
+                if (pos + 1 > length) {
+                    return false;
+                }
+                arg->value = data[pos++];
+                break;
+            case CMD_ARG_STRING:
+                if (pos + 1 > length || pos + 1 + data[pos] > length) {
+                    return false;
+                }
+                arg->length = data[pos];
+                arg->value = arg->length;
+                arg->text = reinterpret_cast<const char*>(&data[pos + 1]);
+                pos += 1 + arg->length;
+                break;
+        }
+
+        if (!argInRange(spec, arg)) {
+            return false;
+        }
+    }
+
+    return pos == length;
+}
+
+/**
+ * Enter a dispatch for an input: take the lock and route output to its sink
+ * @return Previous sink, restored by endDispatch()
+ */
+static FILE* beginDispatch(CommandHandler* handler, const CommandInput* input) {
+    if (handler->lock != nullptr) {
+        handler->lock(handler->lockContext);
+    }
+    FILE* previous = currentOutput;
+    currentOutput = input->out;
+    return previous;
+}
+
+static void endDispatch(CommandHandler* handler, FILE* previous) {
+    currentOutput = previous;
+    if (handler->unlock != nullptr) {
+        handler->unlock(handler->lockContext);
+    }
+}
+
+static void clearInput(CommandInput* input) {
+    memset(input->buffer, 0, COMMAND_BUFFER_SIZE);
+    input->bufferIndex = 0;
+    input->commandReady = false;
+}
+
+static void enterFrameMode(CommandInput* input) {
+    clearInput(input);
+    frame_decoder_reset(&input->frame);
+    input->frameMode = true;
+    input->frameText = true;
+    input->frameBytes = 0;
+    input->frameLastByteMs = millis();
+}
+
+static void leaveFrameMode(CommandInput* input) {
+    input->frameMode = false;
+    frame_decoder_reset(&input->frame);
+    clearInput(input);
+}
+
+static bool frameIdle(const CommandInput* input) {
+    return millis() - input->frameLastByteMs >= COMMAND_FRAME_IDLE_MS;
+}
+
+/**
+ * Feed one byte of a binary frame
+ */
+static bool processFrameByte(CommandHandler* handler, CommandInput* input, uint8_t value) {
+    input->frameLastByteMs = millis();
+
+    if ((value == '\r' || value == '\n') && input->frameText && input->frameBytes > 0) {
+        // Typed text after a stray 0x00: drop that line, back to text
+        leaveFrameMode(input);
+        return false;
+    }
+    if (!isprint(value)) {
+        input->frameText = false;
+    }
+
+    FrameDecodeStatus status = frame_decoder_push(&input->frame, value);
+    if (status == FRAME_DECODE_EMPTY) {
+        // Empty frames only resync, stay in frame mode
+        input->frameText = true;
+        input->frameBytes = 0;
+        return false;
+    }
+    if (status == FRAME_DECODE_PENDING) {
+        input->frameBytes++;
+        if (!input->frame.overflow && input->frameBytes <= COMMAND_FRAME_MAX_BYTES) {
+            return false;
+        }
+        status = FRAME_DECODE_MALFORMED;  // Cannot fit: give up now, not at the delimiter
+    }
+
+    input->frameMode = false;
+    bool result = false;
+    FILE* previous = beginDispatch(handler, input);
+    switch (status) {
+        case FRAME_DECODE_OK:
+            result = commandHandlerProcessFrame(handler, input->frame.buffer, input->frame.length);
+            break;
+        case FRAME_DECODE_BAD_CRC:
+            sendFrameResponse(COMMAND_FRAME_NO_COMMAND, CMD_FRAME_BAD_CRC);
+            break;
+        default:
+            sendFrameResponse(COMMAND_FRAME_NO_COMMAND, CMD_FRAME_MALFORMED);
+            break;
+    }
+    endDispatch(handler, previous);
+
+    frame_decoder_reset(&input->frame);
+    clearInput(input);
+    return result;
+}
+
+/**
+ * Store a new command entry and index its name
+ * @return Entry to fill in, or nullptr if full/invalid/duplicate
+ */
+static CommandEntry* registerEntry(CommandHandler* handler, const char* name, bool progmem,
+                                   void* context, const char* description) {
+    if (handler->commandCount >= MAX_COMMANDS || name == nullptr) {
+        return nullptr;
+    }
+
+    size_t nameLen = progmem ? strlen_P(name) : strlen(name);
+    if (nameLen == 0 || nameLen >= MAX_COMMAND_NAME_LENGTH) {
+        return nullptr;
+    }
+
+    // Add new command (the trie references the caller's name)
+    CommandEntry* entry = &handler->commands[handler->commandCount];
+    memset(entry, 0, sizeof(CommandEntry));
+    entry->name = name;
+    entry->flags = progmem ? COMMAND_FLAG_PROGMEM : 0;
+
+    if (!trieInsert(handler, handler->commandCount, static_cast<uint8_t>(nameLen))) {
+        return nullptr;  // Duplicate command
+    }
+
+    entry->context = context;
+    entry->description = description;
+
+    handler->commandCount++;
+    return entry;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
 void commandHandlerInit(CommandHandler* handler,
                         CommandCallback defaultCallback,
                         void* defaultContext) {
     memset(handler->commands, 0, sizeof(handler->commands));
     handler->commandCount = 0;
+    handler->trieNodeCount = 0;
+    trieNewNode(handler, 0, 0, 0);  // Root
     handler->defaultCallback = defaultCallback;
     handler->defaultContext = defaultContext;
-    
-    // Initialize character buffer
-    memset(handler->buffer, 0, COMMAND_BUFFER_SIZE);
-    handler->bufferIndex = 0;
-    handler->commandReady = false;
+    handler->dispatchHook = nullptr;
+    handler->dispatchContext = nullptr;
+    handler->lock = nullptr;
+    handler->unlock = nullptr;
+    handler->lockContext = nullptr;
+
+    commandInputInit(&handler->input, nullptr);
+}
+
+void commandInputInit(CommandInput* input, FILE* out) {
+    clearInput(input);
+    // Binary frames decode into the same buffer
+    frame_decoder_init(&input->frame, reinterpret_cast<uint8_t*>(input->buffer), COMMAND_BUFFER_SIZE);
+    input->frameMode = false;
+    input->frameText = false;
+    input->frameBytes = 0;
+    input->frameLastByteMs = 0;
+    input->out = out;
+}
+
+void commandHandlerSetLock(CommandHandler* handler,
+                           CommandLockCallback lock,
+                           CommandLockCallback unlock,
+                           void* context) {
+    handler->lock = lock;
+    handler->unlock = unlock;
+    handler->lockContext = context;
+}
+
+void commandHandlerSetOutputHook(CommandOutputHook hook) {
+    outputHook = hook;
+}
+
+FILE* commandHandlerOutput() {
+    FILE* out = outputHook != nullptr ? outputHook() : nullptr;
+    if (out != nullptr) {
+        return out;
+    }
+    return currentOutput != nullptr ? currentOutput : stdout;
+}
+
+int commandHandlerPrintf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vfprintf(commandHandlerOutput(), format, args);
+    va_end(args);
+    return written;
 }
 
 bool commandHandlerRegister(CommandHandler* handler,
@@ -53,43 +682,201 @@ bool commandHandlerRegister(CommandHandler* handler,
                              CommandCallback callback,
                              void* context,
                              const char* description) {
-    if (handler->commandCount >= MAX_COMMANDS) {
+    if (callback == nullptr) {
         return false;
     }
 
-    if (name == nullptr || callback == nullptr) {
+    CommandEntry* entry = registerEntry(handler, name, false, context, description);
+    if (entry == nullptr) {
         return false;
     }
 
-    size_t nameLen = strlen(name);
-    if (nameLen == 0 || nameLen >= MAX_COMMAND_NAME_LENGTH) {
+    entry->callback = callback;
+    return true;
+}
+
+bool commandHandlerRegisterTyped(CommandHandler* handler,
+                                 const char* name,
+                                 CommandTypedCallback callback,
+                                 const CommandArgSpec* argSpecs,
+                                 uint8_t argCount,
+                                 void* context,
+                                 const char* description) {
+    if (callback == nullptr || argCount > COMMAND_MAX_ARGS || (argCount > 0 && argSpecs == nullptr)) {
         return false;
     }
 
-    // Check for duplicate command names
-    for (uint8_t i = 0; i < handler->commandCount; i++) {
-        if (strcasecmp_arduino(handler->commands[i].name, name) == 0) {
-            return false;  // Duplicate command
-        }
+    CommandEntry* entry = registerEntry(handler, name, false, context, description);
+    if (entry == nullptr) {
+        return false;
     }
 
-    // Add new command
-    CommandEntry* entry = &handler->commands[handler->commandCount];
-    strncpy(entry->name, name, MAX_COMMAND_NAME_LENGTH - 1);
-    entry->name[MAX_COMMAND_NAME_LENGTH - 1] = '\0';
-    entry->callback = callback;
-    entry->context = context;
-    entry->description = description ? description : "";
+    entry->typedCallback = callback;
+    entry->argSpecs = argSpecs;
+    entry->argCount = argCount;
+    return true;
+}
 
-    handler->commandCount++;
+uint8_t commandHandlerRegisterTable(CommandHandler* handler,
+                                    const CommandTableEntry* table,
+                                    uint8_t count,
+                                    void* context) {
+    if (handler == nullptr || table == nullptr) {
+        return 0;
+    }
+
+    uint8_t registered = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        CommandTableEntry row;
+        memcpy_P(&row, &table[i], sizeof(row));
+
+        // Exactly one callback; typed rows need a schema that fits
+        bool typed = row.typedCallback != nullptr;
+        if (typed == (row.callback != nullptr) ||
+            row.argCount > COMMAND_MAX_ARGS || (row.argCount > 0 && row.argSpecs == nullptr)) {
+            continue;
+        }
+
+        CommandEntry* entry = registerEntry(handler, row.name, true, context, row.description);
+        if (entry == nullptr) {
+            continue;
+        }
+        entry->callback = row.callback;
+        entry->typedCallback = row.typedCallback;
+        entry->argSpecs = typed ? row.argSpecs : nullptr;
+        entry->argCount = typed ? row.argCount : 0;
+        entry->flags |= row.flags & (COMMAND_FLAG_ASYNC | COMMAND_FLAG_URGENT);
+        registered++;
+    }
+    return registered;
+}
+
+bool commandHandlerSetFlags(CommandHandler* handler, const char* name, uint8_t flags) {
+    CommandEntry* entry = const_cast<CommandEntry*>(commandHandlerFindCommand(handler, name));
+    if (entry == nullptr) {
+        return false;
+    }
+    entry->flags = (entry->flags & COMMAND_FLAG_PROGMEM) | (flags & (COMMAND_FLAG_ASYNC | COMMAND_FLAG_URGENT));
     return true;
 }
 
-bool commandHandlerProcess(CommandHandler* handler, const char* commandString) {
-    if (handler == nullptr || commandString == nullptr) {
+void commandHandlerSetDispatchHook(CommandHandler* handler, CommandDispatchHook hook, void* context) {
+    handler->dispatchHook = hook;
+    handler->dispatchContext = context;
+}
+
+bool commandHandlerInvoke(CommandHandler* handler, const CommandEntry* entry,
+                          const char* args, const CommandArg* typedArgs) {
+    if (handler->dispatchHook != nullptr && (entry->flags & (COMMAND_FLAG_ASYNC | COMMAND_FLAG_URGENT))) {
+        switch (handler->dispatchHook(handler->dispatchContext, entry, args, typedArgs)) {
+            case CMD_DISPATCH_QUEUED:
+                return true;
+            case CMD_DISPATCH_REJECTED:
+                return false;
+            case CMD_DISPATCH_INLINE:
+                break;
+        }
+    }
+
+    return commandHandlerRun(entry, args, typedArgs);
+}
+
+bool commandHandlerRun(const CommandEntry* entry, const char* args, const CommandArg* typedArgs) {
+#if COMMAND_HANDLER_STATS
+    uint32_t start = micros();
+#endif
+
+    bool result = true;
+    if (entry->typedCallback) {
+        result = entry->typedCallback(entry->context, typedArgs, entry->argCount);
+    } else if (entry->callback) {
+        result = entry->callback(entry->context, args);
+    }
+
+#if COMMAND_HANDLER_STATS
+    uint32_t elapsed = micros() - start;
+    // Statistics are bookkeeping, not part of the command's identity
+    CommandStats* stats = &const_cast<CommandEntry*>(entry)->stats;
+    if (stats->calls == 0 || elapsed < stats->minUs) {
+        stats->minUs = elapsed;
+    }
+    if (elapsed > stats->maxUs) {
+        stats->maxUs = elapsed;
+    }
+    stats->totalUs += elapsed;
+    stats->calls++;
+    if (!result && stats->failures < UINT16_MAX) {
+        stats->failures++;
+    }
+#endif
+
+    return result;
+}
+
+#if COMMAND_HANDLER_STATS
+static bool cmdStats(void* context, const char* args) {
+    CommandHandler* handler = static_cast<CommandHandler*>(context);
+    if (args == nullptr) {
+        commandHandlerPrintStats(handler);
+        return true;
+    }
+    if (!tokenEqualsIgnoreCase(args, static_cast<uint8_t>(strlen(args)), "reset")) {
+        commandHandlerPrintf("Usage: stats [reset]\r\n");
         return false;
     }
+    for (uint8_t i = 0; i < handler->commandCount; i++) {
+        memset(&handler->commands[i].stats, 0, sizeof(CommandStats));
+    }
+    commandHandlerPrintf("Command stats cleared\r\n");
+    return true;
+}
+
+static const char NAME_STATS[] PROGMEM = "stats";
+static const char DESC_STATS[] PROGMEM = "Command timing [reset]";
+
+static const CommandTableEntry STATS_COMMANDS[] PROGMEM = {
+    COMMAND_TABLE_ENTRY(NAME_STATS, cmdStats, DESC_STATS),
+};
+#endif
 
+bool commandHandlerRegisterStats(CommandHandler* handler) {
+#if COMMAND_HANDLER_STATS
+    return commandHandlerRegisterTable(handler, STATS_COMMANDS, 1, handler) == 1;
+#else
+    (void) handler;
+    return false;
+#endif
+}
+
+void commandHandlerPrintStats(const CommandHandler* handler) {
+#if COMMAND_HANDLER_STATS
+    commandHandlerPrintf("\r\n  Command           calls  fail  min_us  avg_us  max_us\r\n");
+    for (uint8_t i = 0; i < handler->commandCount; i++) {
+        const CommandEntry* entry = &handler->commands[i];
+        const CommandStats* stats = &entry->stats;
+
+        commandHandlerPrintf("  ");
+        for (size_t width = printEntryText(entry, entry->name); width < 16; width++) {
+            fputc(' ', commandHandlerOutput());
+        }
+        uint32_t avg = stats->calls > 0 ? stats->totalUs / stats->calls : 0;
+        commandHandlerPrintf(" %5lu %5u %7lu %7lu %7lu\r\n",
+               static_cast<unsigned long>(stats->calls), stats->failures,
+               static_cast<unsigned long>(stats->minUs), static_cast<unsigned long>(avg),
+               static_cast<unsigned long>(stats->maxUs));
+    }
+    commandHandlerPrintf("\r\n");
+#else
+    (void) handler;
+    commandHandlerPrintf("Command stats disabled (COMMAND_HANDLER_STATS=0)\r\n");
+#endif
+}
+
+/**
+ * Process a command line; batches are split in batchBuffer (in place if the
+ * line already lives there)
+ */
+static bool processLine(CommandHandler* handler, const char* commandString, char* batchBuffer) {
     // Skip leading whitespace
     while (isspace(*commandString)) {
         commandString++;
@@ -99,43 +886,35 @@ bool commandHandlerProcess(CommandHandler* handler, const char* commandString) {
         return false;
     }
 
-    // Try to match commands (supporting multi-word commands like "relay on")
-    // We need to check if the command string starts with any registered command name
-    const CommandEntry* bestMatch = nullptr;
-    size_t bestMatchLen = 0;
-
-    for (uint8_t j = 0; j < handler->commandCount; j++) {
-        size_t cmdNameLen = strlen(handler->commands[j].name);
-        
-        // Check if command string starts with this command name
-        if (strncasecmp_arduino(commandString, handler->commands[j].name, cmdNameLen) == 0) {
-            // Check if it's a complete match (end of string or followed by space)
-            char nextChar = commandString[cmdNameLen];
-            if (nextChar == '\0' || isspace(nextChar)) {
-                // This is a match, check if it's longer (more specific) than previous match
-                if (cmdNameLen > bestMatchLen) {
-                    bestMatch = &handler->commands[j];
-                    bestMatchLen = cmdNameLen;
-                }
-            }
+    // Several ';'-separated commands: split in the line buffer
+    if (strchr(commandString, COMMAND_BATCH_SEPARATOR) != nullptr) {
+        char* line = batchBuffer;
+        if (commandString >= batchBuffer && commandString < batchBuffer + COMMAND_BUFFER_SIZE) {
+            line = const_cast<char*>(commandString);
+        } else if (strlen(commandString) < COMMAND_BUFFER_SIZE) {
+            strcpy(batchBuffer, commandString);
+        } else {
+            commandHandlerPrintf("Error: batch too long\r\n");
+            return false;
         }
+        return commandHandlerProcessBatch(handler, line);
     }
 
+    const char* args;
+    const CommandEntry* bestMatch = resolveCommand(handler, commandString, &args);
+
     if (bestMatch != nullptr) {
-        // Extract arguments (everything after the command name)
-        const char* args = commandString + bestMatchLen;
-        while (isspace(*args)) {
-            args++;
-        }
-        if (*args == '\0') {
-            args = nullptr;
+        // Typed commands only run with a validated argument array
+        if (bestMatch->typedCallback) {
+            CommandArg typedArgs[COMMAND_MAX_ARGS];
+            if (!parseTypedArgs(bestMatch, args, typedArgs)) {
+                printUsage(bestMatch);
+                return false;
+            }
+            return commandHandlerInvoke(handler, bestMatch, args, typedArgs);
         }
 
-        // Execute callback
-        if (bestMatch->callback) {
-            return bestMatch->callback(bestMatch->context, args);
-        }
-        return true;
+        return commandHandlerInvoke(handler, bestMatch, args, nullptr);
     }
 
     // Command not found, call default callback if available
@@ -146,25 +925,169 @@ bool commandHandlerProcess(CommandHandler* handler, const char* commandString) {
     return false;
 }
 
+bool commandHandlerProcess(CommandHandler* handler, const char* commandString) {
+    if (handler == nullptr || commandString == nullptr) {
+        return false;
+    }
+    return processLine(handler, commandString, handler->input.buffer);
+}
+
+/**
+ * Split a batch and resolve and validate every command in it
+ * @return Number of commands, or -1 (error printed) if any is invalid
+ */
+static int8_t prepareBatch(CommandHandler* handler, char* line,
+                           const CommandEntry** entries, const char** args) {
+    char* segments[COMMAND_BATCH_MAX];
+    uint8_t count = splitBatch(line, segments);
+    if (count > COMMAND_BATCH_MAX) {
+        commandHandlerPrintf("Error: more than %d commands in batch\r\n", COMMAND_BATCH_MAX);
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        entries[i] = resolveCommand(handler, segments[i], &args[i]);
+        if (entries[i] == nullptr) {
+            commandHandlerPrintf("Error: unknown command '%s', batch not run\r\n", segments[i]);
+            return -1;
+        }
+        if (entries[i]->typedCallback) {
+            CommandArg typedArgs[COMMAND_MAX_ARGS];
+            if (!parseTypedArgs(entries[i], args[i], typedArgs)) {
+                printUsage(entries[i]);
+                return -1;
+            }
+        }
+    }
+    return static_cast<int8_t>(count);
+}
+
+int8_t commandHandlerCheckBatch(CommandHandler* handler, char* line, const CommandEntry** entries) {
+    if (handler == nullptr || line == nullptr) {
+        return -1;
+    }
+
+    const CommandEntry* resolved[COMMAND_BATCH_MAX];
+    const char* args[COMMAND_BATCH_MAX];
+    int8_t count = prepareBatch(handler, line, entries != nullptr ? entries : resolved, args);
+    return count > 0 ? count : -1;
+}
+
+bool commandHandlerProcessBatch(CommandHandler* handler, char* line) {
+    if (handler == nullptr || line == nullptr) {
+        return false;
+    }
+
+    // Validate every command before running any of them
+    const CommandEntry* entries[COMMAND_BATCH_MAX];
+    const char* args[COMMAND_BATCH_MAX];
+    int8_t count = prepareBatch(handler, line, entries, args);
+    if (count < 0) {
+        return false;
+    }
+
+    for (int8_t i = 0; i < count; i++) {
+        bool result;
+        if (entries[i]->typedCallback) {
+            CommandArg typedArgs[COMMAND_MAX_ARGS];
+            parseTypedArgs(entries[i], args[i], typedArgs);
+            result = commandHandlerInvoke(handler, entries[i], args[i], typedArgs);
+        } else {
+            result = commandHandlerInvoke(handler, entries[i], args[i], nullptr);
+        }
+        if (!result) {
+            commandHandlerPrintf("Batch stopped at '");
+            printEntryText(entries[i], entries[i]->name);
+            commandHandlerPrintf("' (%u of %u)\r\n", static_cast<unsigned>(i + 1), static_cast<unsigned>(count));
+            return false;
+        }
+    }
+
+    return count > 0;
+}
+
+bool commandHandlerProcessFrame(CommandHandler* handler, uint8_t* payload, size_t length) {
+    if (handler == nullptr || payload == nullptr || length == 0) {
+        sendFrameResponse(COMMAND_FRAME_NO_COMMAND, CMD_FRAME_MALFORMED);
+        return false;
+    }
+
+    uint8_t command = payload[0];
+    if (command >= handler->commandCount) {
+        sendFrameResponse(command, CMD_FRAME_UNKNOWN);
+        return false;
+    }
+
+    const CommandEntry* entry = &handler->commands[command];
+    bool result;
+    if (entry->typedCallback) {
+        CommandArg typedArgs[COMMAND_MAX_ARGS];
+        if (!parseFrameArgs(entry, payload + 1, length - 1, typedArgs)) {
+            sendFrameResponse(command, CMD_FRAME_BAD_ARGS);
+            return false;
+        }
+        result = commandHandlerInvoke(handler, entry, nullptr, typedArgs);
+    } else {
+        // Text arguments are terminated in place
+        payload[length] = '\0';
+        const char* args = length > 1 ? reinterpret_cast<const char*>(payload + 1) : nullptr;
+        result = commandHandlerInvoke(handler, entry, args, nullptr);
+    }
+
+    sendFrameResponse(command, result ? CMD_FRAME_OK : CMD_FRAME_FAILED);
+    return result;
+}
+
+bool commandHandlerInFrame(const CommandHandler* handler) {
+    return handler != nullptr && commandInputInFrame(&handler->input);
+}
+
+bool commandInputInFrame(const CommandInput* input) {
+    return input != nullptr && input->frameMode && !frameIdle(input);
+}
+
 bool commandHandlerProcessChar(CommandHandler* handler, char c) {
     if (handler == nullptr) {
         return false;
     }
+    return commandHandlerProcessInputChar(handler, &handler->input, c);
+}
+
+bool commandHandlerProcessInputChar(CommandHandler* handler, CommandInput* input, char c) {
+    if (handler == nullptr || input == nullptr) {
+        return false;
+    }
 
     // If command was already processed, clear buffer
-    if (handler->commandReady) {
-        commandHandlerClear(handler);
+    if (input->commandReady) {
+        clearInput(input);
+    }
+
+    if (input->frameMode) {
+        if (!frameIdle(input)) {
+            return processFrameByte(handler, input, static_cast<uint8_t>(c));
+        }
+        // Nothing arrived for a while: no frame in flight, this byte is text
+        leaveFrameMode(input);
+    }
+
+    // Frame escape: a partial text line cannot be completed anymore
+    if (static_cast<uint8_t>(c) == FRAME_DELIMITER) {
+        enterFrameMode(input);
+        return false;
     }
 
     // Handle newline/carriage return - command complete
     if (c == '\r' || c == '\n') {
-        if (handler->bufferIndex > 0) {
-            handler->buffer[handler->bufferIndex] = '\0';
-            handler->commandReady = true;
-            
-            // Process the command immediately
-            bool result = commandHandlerProcess(handler, handler->buffer);
-            commandHandlerClear(handler);
+        if (input->bufferIndex > 0) {
+            input->buffer[input->bufferIndex] = '\0';
+            input->commandReady = true;
+
+            // Process the command immediately, splitting batches in place
+            FILE* previous = beginDispatch(handler, input);
+            bool result = processLine(handler, input->buffer, input->buffer);
+            endDispatch(handler, previous);
+            clearInput(input);
             return result;
         }
         return false;
@@ -172,17 +1095,17 @@ bool commandHandlerProcessChar(CommandHandler* handler, char c) {
 
     // Handle backspace/delete
     if (c == '\b' || c == 127) {
-        if (handler->bufferIndex > 0) {
-            handler->bufferIndex--;
-            handler->buffer[handler->bufferIndex] = '\0';
+        if (input->bufferIndex > 0) {
+            input->bufferIndex--;
+            input->buffer[input->bufferIndex] = '\0';
         }
         return false;
     }
 
     // Add printable character to buffer
-    if (handler->bufferIndex < COMMAND_BUFFER_SIZE - 1 && isprint(c)) {
-        handler->buffer[handler->bufferIndex++] = tolower(c);
-        handler->buffer[handler->bufferIndex] = '\0';
+    if (input->bufferIndex < COMMAND_BUFFER_SIZE - 1 && isprint(c)) {
+        input->buffer[input->bufferIndex++] = tolower(c);
+        input->buffer[input->bufferIndex] = '\0';
     }
 
     return false;
@@ -192,16 +1115,14 @@ bool commandHandlerIsReady(const CommandHandler* handler) {
     if (handler == nullptr) {
         return false;
     }
-    return handler->commandReady;
+    return handler->input.commandReady;
 }
 
 void commandHandlerClear(CommandHandler* handler) {
     if (handler == nullptr) {
         return;
     }
-    memset(handler->buffer, 0, COMMAND_BUFFER_SIZE);
-    handler->bufferIndex = 0;
-    handler->commandReady = false;
+    clearInput(&handler->input);
 }
 
 void commandHandlerPrintHelp(CommandHandler* handler) {
@@ -209,15 +1130,22 @@ void commandHandlerPrintHelp(CommandHandler* handler) {
         return;
     }
 
-    printf("\r\nAvailable commands:\r\n");
+    commandHandlerPrintf("\r\nAvailable commands:\r\n");
     for (uint8_t i = 0; i < handler->commandCount; i++) {
-        printf("  %s", handler->commands[i].name);
-        if (handler->commands[i].description && strlen(handler->commands[i].description) > 0) {
-            printf(" - %s", handler->commands[i].description);
+        const CommandEntry* entry = &handler->commands[i];
+        commandHandlerPrintf("  ");
+        printEntryText(entry, entry->name);
+        if (entry->description != nullptr && entryChar(entry, entry->description, 0) != '\0') {
+            commandHandlerPrintf(" - ");
+            printEntryText(entry, entry->description);
         }
-        printf("\r\n");
+        commandHandlerPrintf("\r\n");
     }
-    printf("\r\n");
+    commandHandlerPrintf("\r\n");
+}
+
+void commandHandlerPrintName(const CommandEntry* entry) {
+    printEntryText(entry, entry->name);
 }
 
 const CommandEntry* commandHandlerFindCommand(CommandHandler* handler, const char* name) {
@@ -225,12 +1153,8 @@ const CommandEntry* commandHandlerFindCommand(CommandHandler* handler, const cha
         return nullptr;
     }
 
-    for (uint8_t i = 0; i < handler->commandCount; i++) {
-        if (strcasecmp_arduino(handler->commands[i].name, name) == 0) {
-            return &handler->commands[i];
-        }
-    }
-
-    return nullptr;
+    size_t matchLen;
+    uint8_t match = trieMatch(handler, name, true, &matchLen);
+    return match != COMMAND_TRIE_NONE ? &handler->commands[match] : nullptr;
 }
 
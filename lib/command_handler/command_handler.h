@@ -2,35 +2,247 @@
 #define COMMAND_HANDLER_H
 
 #include <Arduino.h>
+#include <avr/pgmspace.h>
 #include <stdint.h>
+#include <stdio.h>
+#include "frame_codec.h"
 
-#define MAX_COMMANDS 16
-#define MAX_COMMAND_NAME_LENGTH 32
+#ifndef MAX_COMMANDS
+#define MAX_COMMANDS 24
+#endif
+#define MAX_COMMAND_NAME_LENGTH 32      // Including terminator
+
+// Command names are indexed by a compact radix trie built at registration,
+// so lookup cost depends on the input length, not on the command count.
+// Every registration adds at most two nodes (a split and a leaf).
+#define COMMAND_TRIE_MAX_NODES (2 * MAX_COMMANDS + 1)
+#define COMMAND_TRIE_NONE 0xFF
 
 // Command handler callback function type
 // Returns true if command was handled successfully
 // args can be nullptr if no arguments provided
 typedef bool (*CommandCallback)(void* context, const char* args);
 
+// -----------------------------------------------------------------------------
+// Typed arguments
+// -----------------------------------------------------------------------------
+// Commands registered with an argument schema get their arguments tokenized
+// in place and validated by the handler; the callback only sees values that
+// passed the schema.
+#ifndef COMMAND_MAX_ARGS
+#define COMMAND_MAX_ARGS 4
+#endif
+
+enum CommandArgType : uint8_t {
+    CMD_ARG_INT,      // Signed integer in [min..max]
+    CMD_ARG_FIXED,    // Decimal number, value scaled by 10^decimals, range in scaled units
+    CMD_ARG_ENUM,     // One of choices[] (case-insensitive), value is the index
+    CMD_ARG_STRING    // Single token, length in [min..max]
+};
+
+struct CommandArgSpec {
+    CommandArgType type;
+    const char* name;             // Shown in usage/error messages
+    int32_t min;
+    int32_t max;
+    uint8_t decimals;             // CMD_ARG_FIXED only
+    const char* const* choices;   // CMD_ARG_ENUM only
+};
+
+#define COMMAND_ARG_INT(name, min, max)              {CMD_ARG_INT, name, min, max, 0, nullptr}
+#define COMMAND_ARG_FIXED(name, min, max, decimals)  {CMD_ARG_FIXED, name, min, max, decimals, nullptr}
+#define COMMAND_ARG_ENUM(name, choices, count)       {CMD_ARG_ENUM, name, 0, (count) - 1, 0, choices}
+#define COMMAND_ARG_STRING(name, minLen, maxLen)     {CMD_ARG_STRING, name, minLen, maxLen, 0, nullptr}
+
+// Parsed argument; text points into the command line (not NUL-terminated)
+struct CommandArg {
+    int32_t value;        // INT value, FIXED scaled value, ENUM index, STRING length
+    const char* text;     // Token start
+    uint8_t length;       // Token length
+};
+
+// Typed command callback, args has one entry per schema entry
+typedef bool (*CommandTypedCallback)(void* context, const CommandArg* args, uint8_t argCount);
+
+// Per-command call counts and execution times (micros()), dumped by the
+// "stats" command. Off by default: enabling costs 18 bytes of RAM per
+// command slot and two micros() calls per command.
+#ifndef COMMAND_HANDLER_STATS
+#define COMMAND_HANDLER_STATS 0
+#endif
+
+#if COMMAND_HANDLER_STATS
+struct CommandStats {
+    uint32_t calls;
+    uint16_t failures;      // Callback returned false
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t totalUs;       // Wraps after ~71 minutes of accumulated run time
+};
+#endif
+
+// Command flags
+#define COMMAND_FLAG_PROGMEM 0x01   // Name and description are in flash (set by the table path)
+#define COMMAND_FLAG_ASYNC   0x02   // Handed to the dispatch hook instead of running inline
+#define COMMAND_FLAG_URGENT  0x04   // Async: jumps queued work; inline: preempts async work
+
+// Names and descriptions are referenced, not copied: they live either in RAM
+// (string literals) or in flash for entries registered from a PROGMEM table.
 struct CommandEntry {
-    char name[MAX_COMMAND_NAME_LENGTH];
+    const char* name;
     CommandCallback callback;
+    CommandTypedCallback typedCallback;   // Set instead of callback for typed commands
+    const CommandArgSpec* argSpecs;
+    uint8_t argCount;
     void* context;
-    const char* description;
+    const char* description;              // nullptr if none
+    uint8_t flags;                        // COMMAND_FLAG_*
+#if COMMAND_HANDLER_STATS
+    CommandStats stats;
+#endif
+};
+
+// -----------------------------------------------------------------------------
+// Flash command tables
+// -----------------------------------------------------------------------------
+// A table row lives in flash together with its strings, so a command costs
+// only its CommandEntry in RAM. Strings must be PROGMEM arrays:
+//
+//   static const char NAME_STOP[] PROGMEM = "motor stop";
+//   static const char DESC_STOP[] PROGMEM = "Stop motor immediately";
+//   static const CommandTableEntry MOTOR_COMMANDS[] PROGMEM = {
+//       COMMAND_TABLE_ENTRY(NAME_STOP, cmdMotorStop, DESC_STOP),
+//   };
+struct CommandTableEntry {
+    const char* name;                     // PROGMEM string
+    CommandCallback callback;             // Untyped commands
+    CommandTypedCallback typedCallback;   // Typed commands
+    const CommandArgSpec* argSpecs;       // RAM, typed commands only
+    uint8_t argCount;
+    const char* description;              // PROGMEM string or nullptr
+    uint8_t flags;                        // COMMAND_FLAG_ASYNC / COMMAND_FLAG_URGENT
+};
+
+#define COMMAND_TABLE_ENTRY(name, callback, description) \
+    {name, callback, nullptr, nullptr, 0, description, 0}
+#define COMMAND_TABLE_TYPED(name, callback, argSpecs, argCount, description) \
+    {name, nullptr, callback, argSpecs, argCount, description, 0}
+#define COMMAND_TABLE_ENTRY_FLAGS(name, callback, description, flags) \
+    {name, callback, nullptr, nullptr, 0, description, flags}
+#define COMMAND_TABLE_TYPED_FLAGS(name, callback, argSpecs, argCount, description, flags) \
+    {name, nullptr, callback, argSpecs, argCount, description, flags}
+
+// -----------------------------------------------------------------------------
+// Dispatch hook
+// -----------------------------------------------------------------------------
+// Commands flagged ASYNC or URGENT are offered to the dispatch hook after
+// their arguments were validated (see command_async.h for a FreeRTOS worker
+// pool). args and typedArgs point into the line buffer, so a hook that defers
+// the call must copy what it needs before returning.
+enum CommandDispatch : uint8_t {
+    CMD_DISPATCH_INLINE,      // Run the callback now on the calling task
+    CMD_DISPATCH_QUEUED,      // Deferred, counts as success
+    CMD_DISPATCH_REJECTED     // Not run (hook printed why), counts as failure
+};
+
+typedef CommandDispatch (*CommandDispatchHook)(void* context, const CommandEntry* entry,
+                                               const char* args, const CommandArg* typedArgs);
+
+// Trie node; edge labels are slices of a registered command name
+struct CommandTrieNode {
+    uint8_t labelCommand;   // Command whose name holds the edge label
+    uint8_t labelStart;     // Label offset within that name
+    uint8_t labelLength;    // Label length (0 for the root)
+    uint8_t firstChild;     // COMMAND_TRIE_NONE if none
+    uint8_t nextSibling;    // COMMAND_TRIE_NONE if none
+    uint8_t command;        // Command ending at this node, or COMMAND_TRIE_NONE
 };
 
 #define COMMAND_BUFFER_SIZE 64
 
+// A line may hold several commands separated by ';' (outside double quotes).
+// All of them are resolved and validated before the first one runs, and
+// they run back to back in one dispatch pass.
+#define COMMAND_BATCH_SEPARATOR ';'
+#ifndef COMMAND_BATCH_MAX
+#define COMMAND_BATCH_MAX 8
+#endif
+
+// -----------------------------------------------------------------------------
+// Binary frames
+// -----------------------------------------------------------------------------
+// Binary frames (COBS + CRC-16, see frame_codec.h) share the input with text
+// commands: 0x00 never occurs in typed text, so it switches the handler into
+// frame mode until the closing delimiter. Frames reuse the text line buffer,
+// so a payload can be up to COMMAND_BUFFER_SIZE - 2 bytes.
+//
+// A stray 0x00 (line noise, a break, a terminal sending NUL) must not swallow
+// typed commands, so frame mode is also left when
+//   - the decoder overflows or more than COMMAND_FRAME_MAX_BYTES arrive
+//     (answered with CMD_FRAME_MALFORMED)
+//   - no byte arrives for COMMAND_FRAME_IDLE_MS (the byte after the gap is
+//     taken as text)
+//   - '\r' or '\n' ends a run of printable bytes; a real frame always has a
+//     non-printable COBS code or command index among its first bytes
+//
+// Request payload:  [command index][arguments]
+//   command index = registration order (0 = first registered command)
+//   typed commands: INT/FIXED int32 LE, ENUM uint8 index, STRING uint8 length + bytes
+//   text commands:  raw argument text (as typed after the name)
+// Response payload: [command index][CommandFrameStatus]
+enum CommandFrameStatus : uint8_t {
+    CMD_FRAME_OK = 0,          // Callback returned true
+    CMD_FRAME_FAILED = 1,      // Callback returned false
+    CMD_FRAME_UNKNOWN = 2,     // No command with that index
+    CMD_FRAME_BAD_ARGS = 3,    // Arguments do not match the schema
+    CMD_FRAME_BAD_CRC = 4,     // CRC mismatch (index is COMMAND_FRAME_NO_COMMAND)
+    CMD_FRAME_MALFORMED = 5    // Bad COBS, empty or oversized frame
+};
+
+#define COMMAND_FRAME_NO_COMMAND 0xFF
+
+#ifndef COMMAND_FRAME_IDLE_MS
+#define COMMAND_FRAME_IDLE_MS 100
+#endif
+#define COMMAND_FRAME_MAX_BYTES FRAME_COBS_MAX_ENCODED(COMMAND_BUFFER_SIZE)
+
+// -----------------------------------------------------------------------------
+// Input contexts
+// -----------------------------------------------------------------------------
+// Every transport (a UART, the keypad, ...) feeds its own CommandInput, so
+// lines arriving on different ports at the same time never interleave. All
+// inputs share the handler's command table; while a command from an input
+// runs, handler messages and commandHandlerPrintf() go to that input's sink.
+struct CommandInput {
+    char buffer[COMMAND_BUFFER_SIZE];   // Line accumulation
+    size_t bufferIndex;
+    bool commandReady;
+    FrameDecoder frame;                 // Binary frame decoding (uses buffer)
+    bool frameMode;
+    bool frameText;                     // Only printable bytes since the delimiter
+    uint8_t frameBytes;                 // Bytes since the delimiter
+    unsigned long frameLastByteMs;      // For COMMAND_FRAME_IDLE_MS
+    FILE* out;                          // Response sink, nullptr for stdout
+};
+
+// Serializes dispatch when inputs are fed from different tasks
+typedef void (*CommandLockCallback)(void* context);
+
 struct CommandHandler {
     CommandEntry commands[MAX_COMMANDS];
     uint8_t commandCount;
+    CommandTrieNode trie[COMMAND_TRIE_MAX_NODES];
+    uint8_t trieNodeCount;
     CommandCallback defaultCallback;  // Called for unknown commands
     void* defaultContext;
-    
-    // Character accumulation buffer (internal use)
-    char buffer[COMMAND_BUFFER_SIZE];
-    size_t bufferIndex;
-    bool commandReady;
+    CommandDispatchHook dispatchHook; // Async/urgent commands (nullptr: run inline)
+    void* dispatchContext;
+    CommandLockCallback lock;         // Optional, around every input dispatch
+    CommandLockCallback unlock;
+    void* lockContext;
+
+    // Default input (commandHandlerProcessChar), responds on stdout
+    CommandInput input;
 };
 
 /**
@@ -46,10 +258,11 @@ void commandHandlerInit(CommandHandler* handler,
 /**
  * Register a command with the handler
  * @param handler Command handler instance
- * @param name Command name (case-insensitive, can contain spaces like "relay on")
+ * @param name Command name (case-insensitive, can contain spaces like "relay on");
+ *             must stay valid, typically a string literal
  * @param callback Function to call when command is received
  * @param context User context passed to callback
- * @param description Help text for this command
+ * @param description Help text for this command (must stay valid)
  * @return true if command was registered successfully
  */
 bool commandHandlerRegister(CommandHandler* handler,
@@ -58,10 +271,90 @@ bool commandHandlerRegister(CommandHandler* handler,
                              void* context,
                              const char* description);
 
+/**
+ * Register a command with a typed argument schema
+ * @param handler Command handler instance
+ * @param name Command name (case-insensitive, can contain spaces, must stay valid)
+ * @param callback Function called with validated arguments
+ * @param argSpecs Argument schema (must stay valid, typically static const)
+ * @param argCount Number of schema entries (all arguments are required)
+ * @param context User context passed to callback
+ * @param description Help text for this command
+ * @return true if command was registered successfully
+ */
+bool commandHandlerRegisterTyped(CommandHandler* handler,
+                                 const char* name,
+                                 CommandTypedCallback callback,
+                                 const CommandArgSpec* argSpecs,
+                                 uint8_t argCount,
+                                 void* context,
+                                 const char* description);
+
+/**
+ * Register every command of a flash-resident table
+ * @param handler Command handler instance
+ * @param table PROGMEM array of table rows (strings in PROGMEM as well)
+ * @param count Number of rows
+ * @param context User context passed to every callback of the table
+ * @return Number of commands registered (less than count if the handler is
+ *         full or a row is invalid or duplicate)
+ */
+uint8_t commandHandlerRegisterTable(CommandHandler* handler,
+                                    const CommandTableEntry* table,
+                                    uint8_t count,
+                                    void* context);
+
+/**
+ * Set flags on a registered command
+ * @param handler Command handler instance
+ * @param name Exact command name
+ * @param flags COMMAND_FLAG_ASYNC and/or COMMAND_FLAG_URGENT
+ * @return false if no command has that name
+ */
+bool commandHandlerSetFlags(CommandHandler* handler, const char* name, uint8_t flags);
+
+/**
+ * Install the hook that receives ASYNC and URGENT commands
+ */
+void commandHandlerSetDispatchHook(CommandHandler* handler, CommandDispatchHook hook, void* context);
+
+/**
+ * Run a resolved command with validated arguments (through the dispatch hook
+ * if the command is flagged)
+ * @param args Argument text or nullptr
+ * @param typedArgs Validated arguments for typed commands, nullptr otherwise
+ * @return Callback result; true if the hook queued the command
+ */
+bool commandHandlerInvoke(CommandHandler* handler, const CommandEntry* entry,
+                          const char* args, const CommandArg* typedArgs);
+
+/**
+ * Call an entry's callback now, bypassing the dispatch hook (used by job
+ * workers); records statistics when enabled
+ * @return Callback result
+ */
+bool commandHandlerRun(const CommandEntry* entry, const char* args, const CommandArg* typedArgs);
+
+/**
+ * Register the "stats" command ("stats" prints, "stats reset" clears)
+ *
+ * Register it after every other fixed command: it only exists when
+ * COMMAND_HANDLER_STATS is 1, and frame command indices follow
+ * registration order.
+ * @return false if statistics are compiled out or the handler is full
+ */
+bool commandHandlerRegisterStats(CommandHandler* handler);
+
+/**
+ * Print call counts and min/avg/max execution times of every command
+ */
+void commandHandlerPrintStats(const CommandHandler* handler);
+
 /**
  * Process a command string
  * @param handler Command handler instance
- * @param commandString Full command string (may include arguments after command name)
+ * @param commandString Full command string (may include arguments after command name,
+ *                      or several commands separated by ';')
  * @return true if command was handled
  */
 bool commandHandlerProcess(CommandHandler* handler, const char* commandString);
@@ -71,6 +364,11 @@ bool commandHandlerProcess(CommandHandler* handler, const char* commandString);
  */
 void commandHandlerPrintHelp(CommandHandler* handler);
 
+/**
+ * Print a command's name (from RAM or flash) to stdout
+ */
+void commandHandlerPrintName(const CommandEntry* entry);
+
 /**
  * Find command entry by name (case-insensitive)
  */
@@ -85,6 +383,85 @@ const CommandEntry* commandHandlerFindCommand(CommandHandler* handler, const cha
  */
 bool commandHandlerProcessChar(CommandHandler* handler, char c);
 
+/**
+ * Validate and run a ';'-separated batch, splitting the line in place
+ * @param handler Command handler instance
+ * @param line Writable command line (modified)
+ * @return true if every command ran and succeeded; nothing runs if any
+ *         command is unknown or has invalid arguments
+ */
+bool commandHandlerProcessBatch(CommandHandler* handler, char* line);
+
+/**
+ * Validate a ';'-separated batch without running it (errors are printed)
+ * @param handler Command handler instance
+ * @param line Writable command line (split in place)
+ * @param entries Receives the resolved commands (COMMAND_BATCH_MAX slots), can be nullptr
+ * @return Number of commands, or -1 if the batch is empty or any command would be rejected
+ */
+int8_t commandHandlerCheckBatch(CommandHandler* handler, char* line, const CommandEntry** entries);
+
+/**
+ * Dispatch a decoded binary frame payload and send the response frame
+ * @param handler Command handler instance
+ * @param payload [command index][arguments]; one byte past length must be writable
+ * @param length Payload length
+ * @return true if the command ran and succeeded
+ */
+bool commandHandlerProcessFrame(CommandHandler* handler, uint8_t* payload, size_t length);
+
+/**
+ * Check if a binary frame is being received (e.g. to suspend echo)
+ */
+bool commandHandlerInFrame(const CommandHandler* handler);
+
+/**
+ * Initialize an additional input context
+ * @param input Input instance (must stay valid while in use)
+ * @param out Response sink for commands from this input (nullptr for stdout)
+ */
+void commandInputInit(CommandInput* input, FILE* out);
+
+/**
+ * Process a single character from an input context
+ * @return true if a complete command was processed and succeeded
+ */
+bool commandHandlerProcessInputChar(CommandHandler* handler, CommandInput* input, char c);
+
+/**
+ * Check if an input context is receiving a binary frame (e.g. to suspend echo)
+ */
+bool commandInputInFrame(const CommandInput* input);
+
+/**
+ * Install lock callbacks taken around each dispatch from an input, needed
+ * when inputs are fed from different tasks (e.g. a FreeRTOS mutex)
+ */
+void commandHandlerSetLock(CommandHandler* handler,
+                           CommandLockCallback lock,
+                           CommandLockCallback unlock,
+                           void* context);
+
+// Sink for callers outside an input dispatch (e.g. a worker running a
+// queued command), nullptr to fall back to the dispatching input's sink
+typedef FILE* (*CommandOutputHook)();
+
+/**
+ * Install the output hook consulted first by commandHandlerOutput()
+ */
+void commandHandlerSetOutputHook(CommandOutputHook hook);
+
+/**
+ * Sink of the input whose command is being dispatched (stdout otherwise)
+ */
+FILE* commandHandlerOutput();
+
+/**
+ * printf to commandHandlerOutput(); use it in callbacks that may be invoked
+ * from several inputs
+ */
+int commandHandlerPrintf(const char* format, ...);
+
 /**
  * Check if a command is ready to be processed
  */
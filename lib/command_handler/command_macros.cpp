@@ -0,0 +1,308 @@
+#include "command_macros.h"
+#include <avr/eeprom.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert(COMMAND_MACRO_BODY_LENGTH <= COMMAND_BUFFER_SIZE, "Macro bodies must fit the line buffer");
+
+constexpr uint8_t MACRO_EEPROM_MAGIC = 'M';
+constexpr uint8_t MACRO_EEPROM_VERSION = 1;
+constexpr uint16_t MACRO_RECORD_SIZE = COMMAND_MACRO_NAME_LENGTH + COMMAND_MACRO_BODY_LENGTH;
+
+static const char MACRO_DESCRIPTION[] = "Stored macro";
+
+static const CommandArgSpec MACRO_DEL_ARGS[] = {
+    COMMAND_ARG_STRING("name", 1, COMMAND_MACRO_NAME_LENGTH - 1),
+};
+
+// -----------------------------------------------------------------------------
+// EEPROM records
+// -----------------------------------------------------------------------------
+
+static uint8_t* recordAddress(const CommandMacros* macros, uint8_t index, uint8_t offset) {
+    return reinterpret_cast<uint8_t*>(macros->eepromAddress + 2 + index * MACRO_RECORD_SIZE + offset);
+}
+
+static void readName(const CommandMacros* macros, uint8_t index, char* name) {
+    eeprom_read_block(name, recordAddress(macros, index, 0), COMMAND_MACRO_NAME_LENGTH);
+    // Erased (0xFF) or unterminated records count as empty
+    if (static_cast<uint8_t>(name[0]) == 0xFF || name[COMMAND_MACRO_NAME_LENGTH - 1] != '\0') {
+        name[0] = '\0';
+    }
+}
+
+static void readBody(const CommandMacros* macros, uint8_t index, char* body) {
+    eeprom_read_block(body, recordAddress(macros, index, COMMAND_MACRO_NAME_LENGTH), COMMAND_MACRO_BODY_LENGTH);
+    body[COMMAND_MACRO_BODY_LENGTH - 1] = '\0';
+}
+
+static void writeRecord(const CommandMacros* macros, uint8_t index, const char* name, const char* body) {
+    char record[MACRO_RECORD_SIZE];
+    memset(record, 0, sizeof(record));
+    strncpy(record, name, COMMAND_MACRO_NAME_LENGTH - 1);
+    strncpy(record + COMMAND_MACRO_NAME_LENGTH, body, COMMAND_MACRO_BODY_LENGTH - 1);
+    // Only changed bytes are written to save EEPROM cycles
+    eeprom_update_block(record, recordAddress(macros, index, 0), sizeof(record));
+}
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+static bool macroCallback(void* context, const char* args);
+
+static bool validName(const char* name, size_t length) {
+    if (length == 0 || length >= COMMAND_MACRO_NAME_LENGTH) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (!isalnum(name[i]) && name[i] != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Slot currently bound to name, or nullptr
+ */
+static CommandMacroSlot* findSlot(CommandMacros* macros, const char* name) {
+    const CommandEntry* entry = commandHandlerFindCommand(macros->handler, name);
+    if (entry == nullptr || entry->callback != macroCallback) {
+        return nullptr;
+    }
+    CommandMacroSlot* slot = static_cast<CommandMacroSlot*>(entry->context);
+    return slot->owner == macros ? slot : nullptr;
+}
+
+static bool runSlot(CommandMacroSlot* slot) {
+    CommandMacros* macros = slot->owner;
+    if (macros->expanding) {
+        commandHandlerPrintf("Error: macros cannot call macros\r\n");
+        return false;
+    }
+
+    readBody(macros, slot->index, macros->line);
+    if (macros->line[0] == '\0') {
+        commandHandlerPrintf("Error: macro not defined\r\n");
+        return false;
+    }
+
+    macros->expanding = true;
+    bool result = commandHandlerProcessBatch(macros->handler, macros->line);
+    macros->expanding = false;
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Command callbacks
+// -----------------------------------------------------------------------------
+
+static bool macroCallback(void* context, const char* args) {
+    (void) args;
+    return runSlot(static_cast<CommandMacroSlot*>(context));
+}
+
+static bool cmdMacroSet(void* context, const char* args) {
+    CommandMacros* macros = static_cast<CommandMacros*>(context);
+    if (args == nullptr) {
+        commandHandlerPrintf("Usage: macro set <name> <commands>\r\n");
+        return false;
+    }
+
+    // Name is the first token, the rest of the line is the body
+    const char* body = args;
+    while (*body != '\0' && !isspace(*body)) {
+        body++;
+    }
+    size_t nameLen = body - args;
+    while (isspace(*body)) {
+        body++;
+    }
+
+    char name[COMMAND_MACRO_NAME_LENGTH];
+    if (!validName(args, nameLen)) {
+        commandHandlerPrintf("Error: macro name must be 1-%d letters, digits or '_'\r\n", COMMAND_MACRO_NAME_LENGTH - 1);
+        return false;
+    }
+    memcpy(name, args, nameLen);
+    name[nameLen] = '\0';
+
+    if (!commandMacrosDefine(macros, name, body)) {
+        return false;
+    }
+    commandHandlerPrintf("Macro '%s' saved\r\n", name);
+    return true;
+}
+
+static bool cmdMacroDel(void* context, const CommandArg* args, uint8_t argCount) {
+    (void) argCount;
+    char name[COMMAND_MACRO_NAME_LENGTH];
+    memcpy(name, args[0].text, args[0].length);
+    name[args[0].length] = '\0';
+
+    if (!commandMacrosDelete(static_cast<CommandMacros*>(context), name)) {
+        commandHandlerPrintf("Error: no macro '%s'\r\n", name);
+        return false;
+    }
+    commandHandlerPrintf("Macro '%s' deleted\r\n", name);
+    return true;
+}
+
+static bool cmdMacroList(void* context, const char* args) {
+    (void) args;
+    commandMacrosPrint(static_cast<const CommandMacros*>(context));
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool commandMacrosInit(CommandMacros* macros, CommandHandler* handler, uint16_t eepromAddress) {
+    memset(macros, 0, sizeof(CommandMacros));
+    macros->handler = handler;
+    macros->eepromAddress = eepromAddress;
+
+    // Unformatted EEPROM: start with no macros
+    uint8_t header[2];
+    eeprom_read_block(header, reinterpret_cast<const void*>(eepromAddress), sizeof(header));
+    if (header[0] != MACRO_EEPROM_MAGIC || header[1] != MACRO_EEPROM_VERSION) {
+        for (uint8_t i = 0; i < COMMAND_MACRO_COUNT; i++) {
+            writeRecord(macros, i, "", "");
+        }
+        header[0] = MACRO_EEPROM_MAGIC;
+        header[1] = MACRO_EEPROM_VERSION;
+        eeprom_update_block(header, reinterpret_cast<void*>(eepromAddress), sizeof(header));
+    }
+
+    bool ok = commandHandlerRegister(handler, "macro set", cmdMacroSet, macros,
+                                     "Store macro: macro set <name> \"cmd; cmd\"");
+    ok &= commandHandlerRegisterTyped(handler, "macro del", cmdMacroDel, MACRO_DEL_ARGS, 1, macros,
+                                      "Delete macro");
+    ok &= commandHandlerRegister(handler, "macro list", cmdMacroList, macros, "List macros");
+
+    for (uint8_t i = 0; i < COMMAND_MACRO_COUNT; i++) {
+        CommandMacroSlot* slot = &macros->slots[i];
+        slot->owner = macros;
+        slot->index = i;
+
+        readName(macros, i, slot->name);
+        if (slot->name[0] != '\0') {
+            slot->registered = commandHandlerRegister(handler, slot->name, macroCallback, slot, MACRO_DESCRIPTION);
+        }
+    }
+
+    return ok;
+}
+
+bool commandMacrosDefine(CommandMacros* macros, const char* name, const char* body) {
+    if (macros->expanding) {
+        commandHandlerPrintf("Error: macros cannot define macros\r\n");
+        return false;
+    }
+
+    // Quotes only protect ';' while the definition itself is parsed
+    size_t bodyLen = strlen(body);
+    if (bodyLen >= 2 && body[0] == '"' && body[bodyLen - 1] == '"') {
+        body++;
+        bodyLen -= 2;
+    }
+    if (bodyLen == 0 || bodyLen >= COMMAND_MACRO_BODY_LENGTH) {
+        commandHandlerPrintf("Error: macro body must be 1-%d characters\r\n", COMMAND_MACRO_BODY_LENGTH - 1);
+        return false;
+    }
+
+    CommandMacroSlot* slot = findSlot(macros, name);
+    if (slot == nullptr) {
+        if (commandHandlerFindCommand(macros->handler, name) != nullptr) {
+            commandHandlerPrintf("Error: '%s' is already a command\r\n", name);
+            return false;
+        }
+        // Deleted names stay registered until reboot, so only never-used slots are free
+        for (uint8_t i = 0; i < COMMAND_MACRO_COUNT && slot == nullptr; i++) {
+            if (!macros->slots[i].registered) {
+                slot = &macros->slots[i];
+            }
+        }
+        if (slot == nullptr) {
+            commandHandlerPrintf("Error: no free macro slot\r\n");
+            return false;
+        }
+    }
+
+    // Reject bodies that would fail at run time, before any of it has run
+    memcpy(macros->line, body, bodyLen);
+    macros->line[bodyLen] = '\0';
+    const CommandEntry* entries[COMMAND_BATCH_MAX];
+    int8_t count = commandHandlerCheckBatch(macros->handler, macros->line, entries);
+    if (count < 0) {
+        return false;
+    }
+    for (int8_t i = 0; i < count; i++) {
+        if (entries[i]->callback == macroCallback || entries[i]->callback == cmdMacroSet ||
+            entries[i]->typedCallback == cmdMacroDel) {
+            commandHandlerPrintf("Error: macros cannot run or change macros\r\n");
+            return false;
+        }
+    }
+
+    if (!slot->registered) {
+        strcpy(slot->name, name);
+        slot->registered = commandHandlerRegister(macros->handler, slot->name, macroCallback, slot, MACRO_DESCRIPTION);
+        if (!slot->registered) {
+            commandHandlerPrintf("Error: command table full\r\n");
+            return false;
+        }
+    }
+
+    memcpy(macros->line, body, bodyLen);
+    macros->line[bodyLen] = '\0';
+    writeRecord(macros, slot->index, name, macros->line);
+    return true;
+}
+
+bool commandMacrosDelete(CommandMacros* macros, const char* name) {
+    CommandMacroSlot* slot = findSlot(macros, name);
+    if (slot == nullptr) {
+        return false;
+    }
+    // Keep the name so it can be redefined in place
+    char stored[COMMAND_MACRO_NAME_LENGTH];
+    readName(macros, slot->index, stored);
+    if (stored[0] == '\0') {
+        return false;
+    }
+    writeRecord(macros, slot->index, "", "");
+    return true;
+}
+
+bool commandMacrosRun(CommandMacros* macros, const char* name) {
+    CommandMacroSlot* slot = findSlot(macros, name);
+    if (slot == nullptr) {
+        return false;
+    }
+    return runSlot(slot);
+}
+
+void commandMacrosPrint(const CommandMacros* macros) {
+    char name[COMMAND_MACRO_NAME_LENGTH];
+    char body[COMMAND_MACRO_BODY_LENGTH];
+    uint8_t shown = 0;
+
+    commandHandlerPrintf("\r\nMacros:\r\n");
+    for (uint8_t i = 0; i < COMMAND_MACRO_COUNT; i++) {
+        readName(macros, i, name);
+        if (name[0] == '\0') {
+            continue;
+        }
+        readBody(macros, i, body);
+        commandHandlerPrintf("  %s = %s\r\n", name, body);
+        shown++;
+    }
+    if (shown == 0) {
+        commandHandlerPrintf("  (none)\r\n");
+    }
+    commandHandlerPrintf("\r\n");
+}
@@ -0,0 +1,82 @@
+#ifndef COMMAND_MACROS_H
+#define COMMAND_MACROS_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "command_handler.h"
+
+/**
+ * Named command macros stored in EEPROM
+ *
+ * A macro is a short name bound to a command line, usually a ';' batch:
+ *
+ *   macro set go "motor set 50; motor inc"
+ *   go
+ *
+ * Each stored macro is registered as a command of its own, so invoking it
+ * costs one short token on the link and expands on the device. Bodies are
+ * validated when defined and run through commandHandlerProcessBatch(), like
+ * a typed batch: every command is resolved and validated before any runs;
+ * execution stops at the first failure.
+ *
+ * Registered commands: "macro set <name> <body>", "macro del <name>",
+ * "macro list". Every macro name also takes one command slot (MAX_COMMANDS).
+ */
+
+#ifndef COMMAND_MACRO_COUNT
+#define COMMAND_MACRO_COUNT 4
+#endif
+
+#define COMMAND_MACRO_NAME_LENGTH 8      // Including terminator
+#define COMMAND_MACRO_BODY_LENGTH 56     // Including terminator
+
+// EEPROM bytes used starting at the configured address
+#define COMMAND_MACRO_EEPROM_SIZE (2 + COMMAND_MACRO_COUNT * (COMMAND_MACRO_NAME_LENGTH + COMMAND_MACRO_BODY_LENGTH))
+
+struct CommandMacros;
+
+struct CommandMacroSlot {
+    CommandMacros* owner;
+    uint8_t index;
+    bool registered;                     // Name registered with the handler
+    char name[COMMAND_MACRO_NAME_LENGTH];  // Registered name (the handler keeps a pointer)
+};
+
+struct CommandMacros {
+    CommandHandler* handler;
+    uint16_t eepromAddress;
+    CommandMacroSlot slots[COMMAND_MACRO_COUNT];
+    char line[COMMAND_BUFFER_SIZE];      // Expansion buffer
+    bool expanding;                      // Macros do not nest
+};
+
+/**
+ * Load stored macros and register the macro commands
+ * @param macros Macro storage instance (must stay valid)
+ * @param handler Command handler the macros run on
+ * @param eepromAddress First EEPROM byte (needs COMMAND_MACRO_EEPROM_SIZE bytes)
+ * @return false if the management commands could not be registered
+ */
+bool commandMacrosInit(CommandMacros* macros, CommandHandler* handler, uint16_t eepromAddress);
+
+/**
+ * Define or replace a macro (validated and written to EEPROM)
+ */
+bool commandMacrosDefine(CommandMacros* macros, const char* name, const char* body);
+
+/**
+ * Delete a macro (its name stays registered but does nothing until redefined)
+ */
+bool commandMacrosDelete(CommandMacros* macros, const char* name);
+
+/**
+ * Run a macro by name
+ */
+bool commandMacrosRun(CommandMacros* macros, const char* name);
+
+/**
+ * Print all stored macros
+ */
+void commandMacrosPrint(const CommandMacros* macros);
+
+#endif
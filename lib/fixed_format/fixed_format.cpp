@@ -0,0 +1,193 @@
+#include <Arduino.h>
+
+#include "fixed_format.h"
+
+namespace {
+
+// Sign, 10 digits and a decimal point
+constexpr uint8_t MAX_DIGITS = 12;
+
+const uint32_t POWERS_OF_TEN[fixed_format::MAX_DECIMALS + 1] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL,
+    100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+// Destination of one formatted value: a buffer or a stream
+struct Writer {
+    char *buffer;
+    size_t size;
+    FILE *stream;
+    size_t length;
+};
+
+void put(Writer &writer, char c) {
+    if (writer.stream != nullptr) {
+        fputc(c, writer.stream);
+    } else if (writer.length + 1 < writer.size) {
+        writer.buffer[writer.length] = c;
+    }
+    writer.length++;
+}
+
+void repeat(Writer &writer, char c, uint8_t count) {
+    for (uint8_t i = 0; i < count; ++i) {
+        put(writer, c);
+    }
+}
+
+/**
+ * Write magnitude / 10^decimals with sign and padding
+ */
+void emit(Writer &writer, bool negative, uint32_t magnitude, uint8_t decimals,
+          uint8_t width, uint8_t flags) {
+    if (decimals > fixed_format::MAX_DECIMALS) {
+        decimals = fixed_format::MAX_DECIMALS;
+    }
+
+    // Digits are produced least significant first
+    char digits[MAX_DIGITS];
+    uint8_t count = 0;
+    do {
+        if (count == decimals && decimals > 0) {
+            digits[count++] = '.';
+        }
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 || count <= decimals);
+
+    char sign = 0;
+    if (negative) {
+        sign = '-';
+    } else if (flags & fixed_format::FORCE_SIGN) {
+        sign = '+';
+    }
+
+    uint8_t used = count + (sign != 0 ? 1 : 0);
+    uint8_t padding = width > used ? width - used : 0;
+    bool left = (flags & fixed_format::ALIGN_LEFT) != 0;
+    bool zero = !left && (flags & fixed_format::PAD_ZERO) != 0;
+
+    if (!left && !zero) {
+        repeat(writer, ' ', padding);
+    }
+    if (sign != 0) {
+        put(writer, sign);
+    }
+    if (zero) {
+        repeat(writer, '0', padding);
+    }
+    while (count > 0) {
+        put(writer, digits[--count]);
+    }
+    if (left) {
+        repeat(writer, ' ', padding);
+    }
+}
+
+Writer bufferWriter(char *buffer, size_t size) {
+    Writer writer = {buffer, size, nullptr, 0};
+    return writer;
+}
+
+Writer streamWriter(FILE *stream) {
+    Writer writer = {nullptr, 0, stream, 0};
+    return writer;
+}
+
+size_t finish(Writer &writer) {
+    if (writer.stream == nullptr && writer.size > 0) {
+        size_t end = writer.length < writer.size ? writer.length : writer.size - 1;
+        writer.buffer[end] = '\0';
+    }
+    return writer.length;
+}
+
+// Magnitude of a signed value, correct for INT32_MIN
+uint32_t magnitudeOf(int32_t value) {
+    return value < 0 ? 0UL - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+}
+
+}  // namespace
+
+namespace fixed_format {
+
+// -----------------------------------------------------------------------------
+// Conversion
+// -----------------------------------------------------------------------------
+
+int32_t toFixed(float value, uint8_t decimals) {
+    if (decimals > MAX_DECIMALS) {
+        decimals = MAX_DECIMALS;
+    }
+    bool negative = value < 0.0f;
+    float magnitude = negative ? -value : value;
+    if (!(magnitude < 2147483648.0f)) {
+        return negative ? INT32_MIN : INT32_MAX;  // Also NaN
+    }
+
+    // Scaling the whole value would round away digits once value * 10^d
+    // passes 2^24; the integer part and the fraction are both exact in float
+    uint32_t whole = static_cast<uint32_t>(magnitude);
+    float fraction = magnitude - static_cast<float>(whole);
+    uint32_t power = POWERS_OF_TEN[decimals];
+    uint32_t fractionScaled = static_cast<uint32_t>(fraction * static_cast<float>(power) + 0.5f);
+
+    uint32_t limit = negative ? 0x80000000UL : 0x7FFFFFFFUL;
+    if (whole > (limit - fractionScaled) / power) {
+        return negative ? INT32_MIN : INT32_MAX;
+    }
+    uint32_t scaled = whole * power + fractionScaled;
+    return negative ? static_cast<int32_t>(0UL - scaled) : static_cast<int32_t>(scaled);
+}
+
+// -----------------------------------------------------------------------------
+// Buffer output
+// -----------------------------------------------------------------------------
+
+size_t formatInt(char *buffer, size_t size, int32_t value, uint8_t width, uint8_t flags) {
+    return formatFixed(buffer, size, value, 0, width, flags);
+}
+
+size_t formatUint(char *buffer, size_t size, uint32_t value, uint8_t width, uint8_t flags) {
+    Writer writer = bufferWriter(buffer, size);
+    emit(writer, false, value, 0, width, flags);
+    return finish(writer);
+}
+
+size_t formatFixed(char *buffer, size_t size, int32_t scaled, uint8_t decimals,
+                   uint8_t width, uint8_t flags) {
+    Writer writer = bufferWriter(buffer, size);
+    emit(writer, scaled < 0, magnitudeOf(scaled), decimals, width, flags);
+    return finish(writer);
+}
+
+size_t formatFloat(char *buffer, size_t size, float value, uint8_t decimals,
+                   uint8_t width, uint8_t flags) {
+    return formatFixed(buffer, size, toFixed(value, decimals), decimals, width, flags);
+}
+
+// -----------------------------------------------------------------------------
+// Stream output
+// -----------------------------------------------------------------------------
+
+size_t printInt(FILE *stream, int32_t value, uint8_t width, uint8_t flags) {
+    return printFixed(stream, value, 0, width, flags);
+}
+
+size_t printUint(FILE *stream, uint32_t value, uint8_t width, uint8_t flags) {
+    Writer writer = streamWriter(stream);
+    emit(writer, false, value, 0, width, flags);
+    return finish(writer);
+}
+
+size_t printFixed(FILE *stream, int32_t scaled, uint8_t decimals, uint8_t width, uint8_t flags) {
+    Writer writer = streamWriter(stream);
+    emit(writer, scaled < 0, magnitudeOf(scaled), decimals, width, flags);
+    return finish(writer);
+}
+
+size_t printFloat(FILE *stream, float value, uint8_t decimals, uint8_t width, uint8_t flags) {
+    return printFixed(stream, toFixed(value, decimals), decimals, width, flags);
+}
+
+}  // namespace fixed_format
@@ -0,0 +1,71 @@
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <Arduino.h>
+#include <stdio.h>
+
+/**
+ * Integer and fixed-point formatting without printf's float support
+ *
+ * avr-libc's default vfprintf prints '?' for %f, and the float-capable one
+ * costs about 1.5 KB of flash and a slow conversion per call. These helpers
+ * cover what the labs need from %f: a value with a fixed number of
+ * decimals, a minimum width and space, zero or left padding.
+ *
+ * Each function formats into a caller buffer (always NUL-terminated,
+ * truncated to fit) or straight into a stream, and returns the full
+ * formatted length like snprintf. A fixed-point value is an integer scaled
+ * by 10^decimals: formatFixed(buf, n, 314, 2) gives "3.14".
+ */
+
+namespace fixed_format {
+
+// Padding flags (combine with |), matching printf's '-', '0' and '+'
+constexpr uint8_t ALIGN_LEFT = 0x01;
+constexpr uint8_t PAD_ZERO = 0x02;
+constexpr uint8_t FORCE_SIGN = 0x04;
+
+// Most decimals a fixed-point value may carry (10^9 fits 32 bits)
+constexpr uint8_t MAX_DECIMALS = 9;
+
+// -----------------------------------------------------------------------------
+// Conversion
+// -----------------------------------------------------------------------------
+
+/**
+ * Scale and round a float to fixed point, half away from zero
+ * (saturates at the int32_t range)
+ */
+int32_t toFixed(float value, uint8_t decimals);
+
+// -----------------------------------------------------------------------------
+// Buffer output
+// -----------------------------------------------------------------------------
+
+size_t formatInt(char *buffer, size_t size, int32_t value, uint8_t width = 0, uint8_t flags = 0);
+size_t formatUint(char *buffer, size_t size, uint32_t value, uint8_t width = 0, uint8_t flags = 0);
+
+/**
+ * Format scaled / 10^decimals, like "%*.*f"
+ */
+size_t formatFixed(char *buffer, size_t size, int32_t scaled, uint8_t decimals,
+                   uint8_t width = 0, uint8_t flags = 0);
+
+/**
+ * Format a float rounded to decimals places, like "%*.*f"
+ */
+size_t formatFloat(char *buffer, size_t size, float value, uint8_t decimals,
+                   uint8_t width = 0, uint8_t flags = 0);
+
+// -----------------------------------------------------------------------------
+// Stream output
+// -----------------------------------------------------------------------------
+
+size_t printInt(FILE *stream, int32_t value, uint8_t width = 0, uint8_t flags = 0);
+size_t printUint(FILE *stream, uint32_t value, uint8_t width = 0, uint8_t flags = 0);
+size_t printFixed(FILE *stream, int32_t scaled, uint8_t decimals, uint8_t width = 0, uint8_t flags = 0);
+size_t printFloat(FILE *stream, float value, uint8_t decimals, uint8_t width = 0, uint8_t flags = 0);
+
+}  // namespace fixed_format
+
+#endif  // FIXED_FORMAT_H
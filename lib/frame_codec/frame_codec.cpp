@@ -0,0 +1,169 @@
+#include "frame_codec.h"
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+
+/**
+ * Byte i of payload followed by its little-endian CRC
+ */
+static uint8_t frame_body_byte(const uint8_t* payload, size_t length, uint16_t crc, size_t i) {
+    if (i < length) {
+        return payload[i];
+    }
+    return i == length ? static_cast<uint8_t>(crc & 0xFF) : static_cast<uint8_t>(crc >> 8);
+}
+
+/**
+ * frame_write sink for frame_encode; context is the output cursor
+ */
+static void frame_append_byte(uint8_t value, void* context) {
+    uint8_t** out = static_cast<uint8_t**>(context);
+    *(*out)++ = value;
+}
+
+// -----------------------------------------------------------------------------
+// Public API Implementation
+// -----------------------------------------------------------------------------
+
+uint16_t frame_crc16_update(uint16_t crc, uint8_t value) {
+    crc ^= static_cast<uint16_t>(value) << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+uint16_t frame_crc16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc = frame_crc16_update(crc, data[i]);
+    }
+    return crc;
+}
+
+size_t frame_cobs_encode(const uint8_t* src, size_t length, uint8_t* dst) {
+    size_t out = 1;
+    size_t codeIndex = 0;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < length; i++) {
+        if (src[i] == 0) {
+            dst[codeIndex] = code;
+            codeIndex = out++;
+            code = 1;
+            continue;
+        }
+        dst[out++] = src[i];
+        if (++code == 0xFF) {
+            dst[codeIndex] = code;
+            codeIndex = out++;
+            code = 1;
+        }
+    }
+    dst[codeIndex] = code;
+    return out;
+}
+
+void frame_write(const uint8_t* payload, size_t length, FrameWriteByte write, void* context) {
+    uint16_t crc = frame_crc16(payload, length);
+    size_t total = length + FRAME_CRC_SIZE;
+
+    write(FRAME_DELIMITER, context);
+
+    // Encode block by block, looking ahead in the source for the next zero
+    size_t i = 0;
+    for (;;) {
+        size_t run = 0;
+        while (i + run < total && run < 254 && frame_body_byte(payload, length, crc, i + run) != 0) {
+            run++;
+        }
+        write(static_cast<uint8_t>(run + 1), context);
+        for (size_t k = 0; k < run; k++) {
+            write(frame_body_byte(payload, length, crc, i + k), context);
+        }
+        i += run;
+
+        if (i >= total) {
+            break;
+        }
+        if (run < 254) {
+            i++; // Skip the zero this block stands in for
+            if (i == total) {
+                write(1, context); // Trailing zero needs an empty final block
+                break;
+            }
+        }
+    }
+
+    write(FRAME_DELIMITER, context);
+}
+
+size_t frame_encode(const uint8_t* payload, size_t length, uint8_t* dst) {
+    uint8_t* out = dst;
+    frame_write(payload, length, frame_append_byte, &out);
+    return static_cast<size_t>(out - dst);
+}
+
+void frame_decoder_init(FrameDecoder* decoder, uint8_t* buffer, size_t capacity) {
+    decoder->buffer = buffer;
+    decoder->capacity = capacity;
+    frame_decoder_reset(decoder);
+}
+
+void frame_decoder_reset(FrameDecoder* decoder) {
+    decoder->length = 0;
+    decoder->code = 0;
+    decoder->remaining = 0;
+    decoder->overflow = false;
+}
+
+FrameDecodeStatus frame_decoder_push(FrameDecoder* decoder, uint8_t value) {
+    if (value == FRAME_DELIMITER) {
+        FrameDecodeStatus status;
+        if (decoder->code == 0) {
+            status = FRAME_DECODE_EMPTY;
+        } else if (decoder->overflow || decoder->remaining != 0 || decoder->length < FRAME_CRC_SIZE) {
+            status = FRAME_DECODE_MALFORMED;
+        } else {
+            size_t payloadLength = decoder->length - FRAME_CRC_SIZE;
+            uint16_t received = decoder->buffer[payloadLength] |
+                                (static_cast<uint16_t>(decoder->buffer[payloadLength + 1]) << 8);
+            status = frame_crc16(decoder->buffer, payloadLength) == received ?
+                     FRAME_DECODE_OK : FRAME_DECODE_BAD_CRC;
+            decoder->length = payloadLength;
+        }
+
+        size_t length = decoder->length;
+        frame_decoder_reset(decoder);
+        decoder->length = length; // Keep the payload length readable
+        return status;
+    }
+
+    if (decoder->code != 0 && decoder->remaining == 0) {
+        // New block: the previous one stood for a zero unless it was full
+        if (decoder->code != 0xFF) {
+            if (decoder->length < decoder->capacity) {
+                decoder->buffer[decoder->length++] = 0;
+            } else {
+                decoder->overflow = true;
+            }
+        }
+        decoder->code = 0;
+    }
+
+    if (decoder->code == 0) {
+        // Length of a new COBS block
+        decoder->code = value;
+        decoder->remaining = value - 1;
+        return FRAME_DECODE_PENDING;
+    }
+
+    if (decoder->length < decoder->capacity) {
+        decoder->buffer[decoder->length++] = value;
+    } else {
+        decoder->overflow = true;
+    }
+    decoder->remaining--;
+    return FRAME_DECODE_PENDING;
+}
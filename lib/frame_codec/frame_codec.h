@@ -0,0 +1,97 @@
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * Binary frame codec (COBS + CRC-16)
+ *
+ * A frame on the wire is
+ *
+ *   0x00  COBS(payload, crc16_lo, crc16_hi)  0x00
+ *
+ * COBS removes every 0x00 from the encoded body, so 0x00 works both as the
+ * frame delimiter and as an escape that can never appear in human-typed
+ * text. This lets binary frames share a serial port with a text protocol.
+ * The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over the payload.
+ *
+ * Decoding is incremental and in place: bytes are pushed one at a time as
+ * they arrive and the payload builds up in a caller-supplied buffer, so no
+ * second copy of the frame is needed.
+ */
+
+#define FRAME_DELIMITER 0x00
+#define FRAME_CRC_SIZE 2
+
+// Worst-case COBS-encoded size of n bytes (one overhead byte per 254)
+#define FRAME_COBS_MAX_ENCODED(n) ((n) + (n) / 254 + 1)
+
+// Worst-case size of a complete frame around an n-byte payload
+#define FRAME_MAX_ENCODED(n) (FRAME_COBS_MAX_ENCODED((n) + FRAME_CRC_SIZE) + 2)
+
+typedef enum {
+    FRAME_DECODE_PENDING,    // Frame still in progress
+    FRAME_DECODE_EMPTY,      // Delimiter with no data (resync / frame start)
+    FRAME_DECODE_OK,         // Complete frame with valid CRC
+    FRAME_DECODE_BAD_CRC,    // Complete frame, CRC mismatch
+    FRAME_DECODE_MALFORMED   // Invalid COBS, too short or buffer overflow
+} FrameDecodeStatus;
+
+typedef struct {
+    uint8_t* buffer;         // Decoded bytes (payload followed by CRC)
+    size_t capacity;
+    size_t length;           // Decoded bytes so far / payload length when OK
+    uint8_t code;            // Current COBS block code
+    uint8_t remaining;       // Data bytes left in the current block
+    bool overflow;
+} FrameDecoder;
+
+// Output sink for frame_write
+typedef void (*FrameWriteByte)(uint8_t value, void* context);
+
+/**
+ * CRC-16/CCITT-FALSE
+ */
+uint16_t frame_crc16_update(uint16_t crc, uint8_t value);
+uint16_t frame_crc16(const uint8_t* data, size_t length);
+
+/**
+ * COBS-encode a buffer (no delimiter is added)
+ * @param dst Needs FRAME_COBS_MAX_ENCODED(length) bytes
+ * @return Encoded length
+ */
+size_t frame_cobs_encode(const uint8_t* src, size_t length, uint8_t* dst);
+
+/**
+ * Write a complete frame (delimiters, COBS body and CRC) byte by byte
+ * without an intermediate buffer
+ */
+void frame_write(const uint8_t* payload, size_t length, FrameWriteByte write, void* context);
+
+/**
+ * Encode a complete frame (delimiters, COBS body and CRC) into a buffer
+ * @param dst Needs FRAME_MAX_ENCODED(length) bytes; may not overlap payload
+ * @return Frame length
+ */
+size_t frame_encode(const uint8_t* payload, size_t length, uint8_t* dst);
+
+/**
+ * Prepare a decoder
+ * @param buffer Receives payload + CRC (capacity >= max payload + 2)
+ */
+void frame_decoder_init(FrameDecoder* decoder, uint8_t* buffer, size_t capacity);
+
+/**
+ * Drop any partial frame
+ */
+void frame_decoder_reset(FrameDecoder* decoder);
+
+/**
+ * Feed one received byte
+ * @return FRAME_DECODE_OK when a frame ended with a valid CRC; the payload is
+ *         then buffer[0..length-1] and the decoder is ready for the next frame
+ */
+FrameDecodeStatus frame_decoder_push(FrameDecoder* decoder, uint8_t value);
+
+#endif // FRAME_CODEC_H
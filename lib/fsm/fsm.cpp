@@ -1,6 +1,12 @@
 #include "fsm.h"
+#include "fsm_snapshot.h"
+#include "fsm_critical.h"
 #include <string.h>
 
+static_assert((FSM_EVENT_QUEUE_SIZE & (FSM_EVENT_QUEUE_SIZE - 1)) == 0,
+              "FSM_EVENT_QUEUE_SIZE must be a power of two");
+static_assert(FSM_EVENT_QUEUE_SIZE <= 128, "FSM_EVENT_QUEUE_SIZE must fit 8-bit counters");
+
 // -----------------------------------------------------------------------------
 // Internal helper functions
 // -----------------------------------------------------------------------------
@@ -17,13 +23,17 @@ static FSMState* fsm_find_state(FSM* fsm, uint8_t stateId) {
     return NULL;
 }
 
+static const FSMState* fsm_find_state_const(const FSM* fsm, uint8_t stateId) {
+    return fsm_find_state(const_cast<FSM*>(fsm), stateId);
+}
+
 /**
- * Find matching transition for current state and event
+ * Find matching transition for a region's current state and event
  */
-static FSMTransition* fsm_find_transition(FSM* fsm, uint8_t event) {
+static FSMTransition* fsm_find_transition(FSM* fsm, uint8_t fromState, uint8_t event) {
     for (uint8_t i = 0; i < fsm->transitionCount; i++) {
         FSMTransition* t = &fsm->transitions[i];
-        if (t->fromState == fsm->currentState && t->event == event) {
+        if (t->fromState == fromState && t->event == event) {
             // Check guard condition if present
             if (t->guard == NULL || t->guard(fsm)) {
                 return t;
@@ -34,35 +44,83 @@ static FSMTransition* fsm_find_transition(FSM* fsm, uint8_t event) {
 }
 
 /**
- * Execute state transition
+ * Switch a region to a new state, running exit/transition/enter callbacks
  */
-static void fsm_execute_transition(FSM* fsm, FSMTransition* transition) {
-    FSMState* fromState = fsm_find_state(fsm, fsm->currentState);
-    FSMState* toState = fsm_find_state(fsm, transition->toState);
-    
-    if (toState == NULL) {
-        return; // Invalid target state
-    }
-    
+static void fsm_enter_state(FSM* fsm, uint8_t region, FSMState* toState,
+                            StateCallback onTransition, uint8_t traceEvent) {
+    FSMRegion* r = &fsm->regions[region];
+    FSMState* fromState = fsm_find_state(fsm, r->currentState);
+
+    fsm->activeRegion = region;
+
     // Exit current state
     if (fromState != NULL && fromState->onExit != NULL) {
         fromState->onExit(fsm);
     }
-    
+
     // Execute transition callback
-    if (transition->onTransition != NULL) {
-        transition->onTransition(fsm);
+    if (onTransition != NULL) {
+        onTransition(fsm);
     }
-    
+
     // Update state tracking
-    fsm->previousState = fsm->currentState;
-    fsm->currentState = transition->toState;
-    fsm->stateEntryTime = millis();
-    
+    r->previousState = r->currentState;
+    r->currentState = toState->id;
+    r->stateEntryTime = millis();
+    fsm_trace_record(fsm, r->previousState, r->currentState, traceEvent);
+
     // Enter new state
     if (toState->onEnter != NULL) {
         toState->onEnter(fsm);
     }
+
+    fsm_snapshot_refresh(fsm);
+}
+
+/**
+ * Offer one event to every active region
+ */
+static bool fsm_dispatch_event(FSM* fsm, uint8_t event) {
+    bool transitioned = false;
+
+    for (uint8_t region = 0; region < fsm->regionCount; region++) {
+        FSMRegion* r = &fsm->regions[region];
+        if (!r->active) {
+            continue;
+        }
+
+        fsm->activeRegion = region;
+        FSMTransition* transition = fsm_find_transition(fsm, r->currentState, event);
+        if (transition == NULL) {
+            continue; // No matching transition in this region
+        }
+
+        FSMState* toState = fsm_find_state(fsm, transition->toState);
+        if (toState == NULL || toState->region != region) {
+            continue; // Invalid target state
+        }
+
+        fsm_enter_state(fsm, region, toState, transition->onTransition, event);
+        transitioned = true;
+    }
+
+    return transitioned;
+}
+
+/**
+ * Remove the oldest queued event (returns false when empty)
+ */
+static bool fsm_pop_event(FSM* fsm, uint8_t* event) {
+    bool popped = false;
+    uint8_t sreg = fsm_critical_enter();
+    if (fsm->eventCount > 0) {
+        uint8_t tail = (fsm->eventHead - fsm->eventCount) & (FSM_EVENT_QUEUE_SIZE - 1);
+        *event = fsm->eventQueue[tail];
+        fsm->eventCount--;
+        popped = true;
+    }
+    fsm_critical_exit(sreg);
+    return popped;
 }
 
 // -----------------------------------------------------------------------------
@@ -72,33 +130,53 @@ static void fsm_execute_transition(FSM* fsm, FSMTransition* transition) {
 void fsm_init(FSM* fsm, const char* name) {
     memset(fsm, 0, sizeof(FSM));
     fsm->name = name;
-    fsm->currentState = 0;
-    fsm->previousState = 0;
     fsm->stateCount = 0;
     fsm->transitionCount = 0;
     fsm->initialized = false;
     fsm->userData = NULL;
-    fsm->stateEntryTime = 0;
+
+    // Region 0 always exists and carries the FSM name
+    fsm->regionCount = 1;
+    fsm->regions[0].name = name;
+
+    fsm->traceId = fsm_trace_register(fsm);
+}
+
+uint8_t fsm_add_region(FSM* fsm, const char* name) {
+    if (fsm->regionCount >= FSM_MAX_REGIONS) {
+        return FSM_NO_REGION;
+    }
+
+    FSMRegion* r = &fsm->regions[fsm->regionCount];
+    memset(r, 0, sizeof(FSMRegion));
+    r->name = name;
+    return fsm->regionCount++;
 }
 
 bool fsm_add_state(FSM* fsm, uint8_t id, const char* name,
                    StateCallback onEnter, StateCallback onExit, StateCallback onUpdate) {
-    if (fsm->stateCount >= FSM_MAX_STATES) {
+    return fsm_add_region_state(fsm, 0, id, name, onEnter, onExit, onUpdate);
+}
+
+bool fsm_add_region_state(FSM* fsm, uint8_t region, uint8_t id, const char* name,
+                          StateCallback onEnter, StateCallback onExit, StateCallback onUpdate) {
+    if (fsm->stateCount >= FSM_MAX_STATES || region >= fsm->regionCount) {
         return false;
     }
-    
+
     // Check for duplicate state ID
     if (fsm_find_state(fsm, id) != NULL) {
         return false;
     }
-    
+
     FSMState* state = &fsm->states[fsm->stateCount];
     state->id = id;
+    state->region = region;
     state->name = name;
     state->onEnter = onEnter;
     state->onExit = onExit;
     state->onUpdate = onUpdate;
-    
+
     fsm->stateCount++;
     return true;
 }
@@ -108,14 +186,21 @@ bool fsm_add_transition(FSM* fsm, uint8_t fromState, uint8_t toState,
     if (fsm->transitionCount >= FSM_MAX_TRANSITIONS) {
         return false;
     }
-    
+
+    // Transitions never cross regions
+    FSMState* from = fsm_find_state(fsm, fromState);
+    FSMState* to = fsm_find_state(fsm, toState);
+    if (from != NULL && to != NULL && from->region != to->region) {
+        return false;
+    }
+
     FSMTransition* t = &fsm->transitions[fsm->transitionCount];
     t->fromState = fromState;
     t->toState = toState;
     t->event = event;
     t->guard = guard;
     t->onTransition = onTransition;
-    
+
     fsm->transitionCount++;
     return true;
 }
@@ -125,17 +210,26 @@ bool fsm_start(FSM* fsm, uint8_t initialState) {
     if (state == NULL) {
         return false;
     }
-    
-    fsm->currentState = initialState;
-    fsm->previousState = initialState;
-    fsm->stateEntryTime = millis();
+
+    FSMRegion* r = &fsm->regions[state->region];
+    r->currentState = initialState;
+    r->previousState = initialState;
+    r->stateEntryTime = millis();
+    r->active = true;
     fsm->initialized = true;
-    
+    fsm->activeRegion = state->region;
+    fsm_trace_record(fsm, initialState, initialState, FSM_TRACE_EVENT_START);
+
     // Call onEnter for initial state
     if (state->onEnter != NULL) {
         state->onEnter(fsm);
     }
-    
+
+    // Tables are complete once started; re-sign the attached snapshot
+    if (fsm->snapshotTarget != NULL) {
+        fsm_snapshot_attach(fsm, fsm->snapshotTarget);
+    }
+
     return true;
 }
 
@@ -143,68 +237,111 @@ bool fsm_process_event(FSM* fsm, uint8_t event) {
     if (!fsm->initialized) {
         return false;
     }
-    
-    FSMTransition* transition = fsm_find_transition(fsm, event);
-    if (transition == NULL) {
-        return false; // No matching transition
+
+    // Raised from a callback: finish the current event first
+    if (fsm->dispatching) {
+        return fsm_post_event(fsm, event);
     }
-    
-    fsm_execute_transition(fsm, transition);
-    return true;
+
+    fsm->dispatching = true;
+    bool transitioned = fsm_dispatch_event(fsm, event);
+
+    uint8_t pending;
+    while (fsm_pop_event(fsm, &pending)) {
+        transitioned |= fsm_dispatch_event(fsm, pending);
+    }
+    fsm->dispatching = false;
+
+    return transitioned;
+}
+
+bool fsm_post_event(FSM* fsm, uint8_t event) {
+    bool queued = false;
+    uint8_t sreg = fsm_critical_enter();
+    if (fsm->eventCount < FSM_EVENT_QUEUE_SIZE) {
+        fsm->eventQueue[fsm->eventHead] = event;
+        fsm->eventHead = (fsm->eventHead + 1) & (FSM_EVENT_QUEUE_SIZE - 1);
+        fsm->eventCount++;
+        queued = true;
+    }
+    fsm_critical_exit(sreg);
+    return queued;
+}
+
+bool fsm_process_pending(FSM* fsm) {
+    if (!fsm->initialized || fsm->dispatching) {
+        return false;
+    }
+
+    bool transitioned = false;
+    uint8_t event;
+    fsm->dispatching = true;
+    while (fsm_pop_event(fsm, &event)) {
+        transitioned |= fsm_dispatch_event(fsm, event);
+    }
+    fsm->dispatching = false;
+
+    return transitioned;
 }
 
 void fsm_update(FSM* fsm) {
     if (!fsm->initialized) {
         return;
     }
-    
-    FSMState* state = fsm_find_state(fsm, fsm->currentState);
-    if (state != NULL && state->onUpdate != NULL) {
-        state->onUpdate(fsm);
+
+    for (uint8_t region = 0; region < fsm->regionCount; region++) {
+        if (!fsm->regions[region].active) {
+            continue;
+        }
+        FSMState* state = fsm_find_state(fsm, fsm->regions[region].currentState);
+        if (state != NULL && state->onUpdate != NULL) {
+            fsm->activeRegion = region;
+            state->onUpdate(fsm);
+        }
+    }
+
+    // Keep time-in-state of an attached snapshot fresh
+    if (fsm->snapshotTarget != NULL && millis() - fsm->snapshotTime >= FSM_SNAPSHOT_REFRESH_MS) {
+        fsm_snapshot_refresh(fsm);
     }
 }
 
 bool fsm_force_state(FSM* fsm, uint8_t stateId) {
-    FSMState* fromState = fsm_find_state(fsm, fsm->currentState);
     FSMState* toState = fsm_find_state(fsm, stateId);
-    
+
     if (toState == NULL) {
         return false;
     }
-    
-    // Exit current state
-    if (fromState != NULL && fromState->onExit != NULL) {
-        fromState->onExit(fsm);
-    }
-    
-    // Update state tracking
-    fsm->previousState = fsm->currentState;
-    fsm->currentState = stateId;
-    fsm->stateEntryTime = millis();
-    
-    // Enter new state
-    if (toState->onEnter != NULL) {
-        toState->onEnter(fsm);
-    }
-    
+
+    fsm_enter_state(fsm, toState->region, toState, NULL, FSM_TRACE_EVENT_FORCE);
     return true;
 }
 
 uint8_t fsm_get_current_state(const FSM* fsm) {
-    return fsm->currentState;
+    return fsm->regions[0].currentState;
 }
 
-const char* fsm_get_current_state_name(const FSM* fsm) {
-    for (uint8_t i = 0; i < fsm->stateCount; i++) {
-        if (fsm->states[i].id == fsm->currentState) {
-            return fsm->states[i].name;
-        }
+uint8_t fsm_get_region_state(const FSM* fsm, uint8_t region) {
+    if (region >= fsm->regionCount) {
+        return 0;
     }
-    return "UNKNOWN";
+    return fsm->regions[region].currentState;
+}
+
+const char* fsm_get_current_state_name(const FSM* fsm) {
+    const FSMState* state = fsm_find_state_const(fsm, fsm->regions[0].currentState);
+    return state != NULL ? state->name : "UNKNOWN";
 }
 
 unsigned long fsm_get_time_in_state(const FSM* fsm) {
-    return millis() - fsm->stateEntryTime;
+    return millis() - fsm->regions[0].stateEntryTime;
+}
+
+unsigned long fsm_get_region_time_in_state(const FSM* fsm, uint8_t region) {
+    if (region >= fsm->regionCount) {
+        return 0;
+    }
+    return millis() - fsm->regions[region].stateEntryTime;
 }
 
 void fsm_set_user_data(FSM* fsm, void* userData) {
@@ -216,18 +353,30 @@ void* fsm_get_user_data(const FSM* fsm) {
 }
 
 bool fsm_is_in_state(const FSM* fsm, uint8_t stateId) {
-    return fsm->currentState == stateId;
+    const FSMState* state = fsm_find_state_const(fsm, stateId);
+    if (state == NULL) {
+        return false;
+    }
+    return fsm->regions[state->region].currentState == stateId;
 }
 
 void fsm_print_status(const FSM* fsm) {
-    Serial.print(F("[FSM:"));
-    Serial.print(fsm->name);
-    Serial.print(F("] State: "));
-    Serial.print(fsm_get_current_state_name(fsm));
-    Serial.print(F(" (ID: "));
-    Serial.print(fsm->currentState);
-    Serial.print(F(") | Time: "));
-    Serial.print(fsm_get_time_in_state(fsm));
-    Serial.println(F("ms"));
-}
+    for (uint8_t region = 0; region < fsm->regionCount; region++) {
+        const FSMRegion* r = &fsm->regions[region];
+        const FSMState* state = fsm_find_state_const(fsm, r->currentState);
 
+        Serial.print(F("[FSM:"));
+        Serial.print(fsm->name);
+        if (region > 0) {
+            Serial.print('/');
+            Serial.print(r->name);
+        }
+        Serial.print(F("] State: "));
+        Serial.print(state != NULL ? state->name : "UNKNOWN");
+        Serial.print(F(" (ID: "));
+        Serial.print(r->currentState);
+        Serial.print(F(") | Time: "));
+        Serial.print(millis() - r->stateEntryTime);
+        Serial.println(F("ms"));
+    }
+}
@@ -3,13 +3,32 @@
 
 #include <Arduino.h>
 #include <stdint.h>
+#include "fsm_trace.h"
 
 // Maximum number of states and transitions per FSM
+#ifndef FSM_MAX_STATES
 #define FSM_MAX_STATES 16
+#endif
+
+#ifndef FSM_MAX_TRANSITIONS
 #define FSM_MAX_TRANSITIONS 32
+#endif
+
+// Maximum number of orthogonal regions per FSM (region 0 always exists)
+#ifndef FSM_MAX_REGIONS
+#define FSM_MAX_REGIONS 4
+#endif
+
+// Pending event queue capacity (power of two, checked at compile time)
+#ifndef FSM_EVENT_QUEUE_SIZE
+#define FSM_EVENT_QUEUE_SIZE 8
+#endif
 
-// Forward declaration
+#define FSM_NO_REGION 0xFF
+
+// Forward declarations
 struct FSM;
+struct FSMSnapshot;
 
 // Callback function types
 typedef void (*StateCallback)(struct FSM* fsm);
@@ -19,7 +38,8 @@ typedef bool (*GuardCallback)(struct FSM* fsm);
 // State definition
 // -----------------------------------------------------------------------------
 typedef struct FSMState {
-    uint8_t id;                    // Unique state ID
+    uint8_t id;                    // Unique state ID (unique across all regions)
+    uint8_t region;                // Region this state belongs to
     const char* name;              // State name for debugging
     StateCallback onEnter;         // Called when entering this state
     StateCallback onExit;          // Called when exiting this state
@@ -37,6 +57,21 @@ typedef struct FSMTransition {
     StateCallback onTransition;    // Optional callback during transition
 } FSMTransition;
 
+// -----------------------------------------------------------------------------
+// Region definition
+// -----------------------------------------------------------------------------
+// A region is an independent sub-machine with its own active state. All
+// regions of an FSM receive every event in the same dispatch pass, so
+// concerns like motor mode and display mode can live in one FSM behind one
+// lock instead of several FSMs with separate mutexes.
+typedef struct FSMRegion {
+    const char* name;              // Region name for debugging
+    uint8_t currentState;          // Current state ID
+    uint8_t previousState;         // Previous state ID
+    bool active;                   // Region has been started
+    unsigned long stateEntryTime;  // Time when current state was entered
+} FSMRegion;
+
 // -----------------------------------------------------------------------------
 // FSM instance structure
 // -----------------------------------------------------------------------------
@@ -44,13 +79,23 @@ typedef struct FSM {
     const char* name;                              // FSM name for debugging
     FSMState states[FSM_MAX_STATES];               // Array of states
     FSMTransition transitions[FSM_MAX_TRANSITIONS]; // Array of transitions
+    FSMRegion regions[FSM_MAX_REGIONS];            // Region 0 is the default region
     uint8_t stateCount;                            // Number of registered states
     uint8_t transitionCount;                       // Number of registered transitions
-    uint8_t currentState;                          // Current state ID
-    uint8_t previousState;                         // Previous state ID
+    uint8_t regionCount;                           // Number of regions (>= 1)
+    uint8_t activeRegion;                          // Region whose callback is running
     bool initialized;                              // FSM initialized flag
+    bool dispatching;                              // Event dispatch in progress
     void* userData;                                // User data pointer for callbacks
-    unsigned long stateEntryTime;                  // Time when current state was entered
+    uint8_t traceId;                               // Trace ID (FSM_TRACE_NO_ID if untraced)
+    struct FSMSnapshot* snapshotTarget;            // Auto-refreshed snapshot (can be NULL)
+    uint16_t snapshotLayout;                       // Table signature, taken on attach/start
+    unsigned long snapshotTime;                    // millis() of the last refresh
+
+    // Pending events (run-to-completion queue shared by all regions)
+    uint8_t eventQueue[FSM_EVENT_QUEUE_SIZE];
+    volatile uint8_t eventHead;
+    volatile uint8_t eventCount;
 } FSM;
 
 // -----------------------------------------------------------------------------
@@ -65,7 +110,15 @@ typedef struct FSM {
 void fsm_init(FSM* fsm, const char* name);
 
 /**
- * Add a state to the FSM
+ * Add an orthogonal region to the FSM
+ * @param fsm Pointer to FSM structure
+ * @param name Region name (for debugging)
+ * @return Region index or FSM_NO_REGION if the region table is full
+ */
+uint8_t fsm_add_region(FSM* fsm, const char* name);
+
+/**
+ * Add a state to the FSM (default region 0)
  * @param fsm Pointer to FSM structure
  * @param id Unique state ID (0-255)
  * @param name State name (for debugging)
@@ -77,8 +130,19 @@ void fsm_init(FSM* fsm, const char* name);
 bool fsm_add_state(FSM* fsm, uint8_t id, const char* name,
                    StateCallback onEnter, StateCallback onExit, StateCallback onUpdate);
 
+/**
+ * Add a state to a specific region
+ * @param fsm Pointer to FSM structure
+ * @param region Region index returned by fsm_add_region (0 = default)
+ * @param id Unique state ID (0-255, unique across all regions)
+ * @return true if state added successfully
+ */
+bool fsm_add_region_state(FSM* fsm, uint8_t region, uint8_t id, const char* name,
+                          StateCallback onEnter, StateCallback onExit, StateCallback onUpdate);
+
 /**
  * Add a transition to the FSM
+ * Both states must belong to the same region
  * @param fsm Pointer to FSM structure
  * @param fromState Source state ID
  * @param toState Target state ID
@@ -92,6 +156,7 @@ bool fsm_add_transition(FSM* fsm, uint8_t fromState, uint8_t toState,
 
 /**
  * Start the FSM with initial state
+ * Starts the region the initial state belongs to
  * @param fsm Pointer to FSM structure
  * @param initialState Initial state ID
  * @return true if started successfully
@@ -100,21 +165,39 @@ bool fsm_start(FSM* fsm, uint8_t initialState);
 
 /**
  * Process an event
+ * Every active region sees the event in one pass. Events raised from inside
+ * a callback are queued and handled after the current event completes.
  * @param fsm Pointer to FSM structure
  * @param event Event ID to process
- * @return true if a transition occurred
+ * @return true if a transition occurred in any region
  */
 bool fsm_process_event(FSM* fsm, uint8_t event);
 
+/**
+ * Queue an event without dispatching it (safe from other tasks and ISRs)
+ * @param fsm Pointer to FSM structure
+ * @param event Event ID to queue
+ * @return false if the queue is full
+ */
+bool fsm_post_event(FSM* fsm, uint8_t event);
+
+/**
+ * Dispatch all queued events
+ * @param fsm Pointer to FSM structure
+ * @return true if any transition occurred
+ */
+bool fsm_process_pending(FSM* fsm);
+
 /**
  * Update the FSM (call periodically)
- * Calls the onUpdate callback of current state
+ * Calls the onUpdate callback of the current state of every region
  * @param fsm Pointer to FSM structure
  */
 void fsm_update(FSM* fsm);
 
 /**
  * Force transition to a specific state (bypasses normal transitions)
+ * Only the region owning the state is affected
  * @param fsm Pointer to FSM structure
  * @param stateId Target state ID
  * @return true if transition occurred
@@ -122,26 +205,42 @@ void fsm_update(FSM* fsm);
 bool fsm_force_state(FSM* fsm, uint8_t stateId);
 
 /**
- * Get current state ID
+ * Get current state ID (region 0)
  * @param fsm Pointer to FSM structure
  * @return Current state ID
  */
 uint8_t fsm_get_current_state(const FSM* fsm);
 
 /**
- * Get current state name
+ * Get current state ID of a region
+ * @param fsm Pointer to FSM structure
+ * @param region Region index
+ * @return Current state ID of the region
+ */
+uint8_t fsm_get_region_state(const FSM* fsm, uint8_t region);
+
+/**
+ * Get current state name (region 0)
  * @param fsm Pointer to FSM structure
  * @return Current state name or "UNKNOWN"
  */
 const char* fsm_get_current_state_name(const FSM* fsm);
 
 /**
- * Get time spent in current state (milliseconds)
+ * Get time spent in current state of region 0 (milliseconds)
  * @param fsm Pointer to FSM structure
  * @return Time in milliseconds since entering current state
  */
 unsigned long fsm_get_time_in_state(const FSM* fsm);
 
+/**
+ * Get time spent in current state of a region (milliseconds)
+ * @param fsm Pointer to FSM structure
+ * @param region Region index
+ * @return Time in milliseconds since the region entered its current state
+ */
+unsigned long fsm_get_region_time_in_state(const FSM* fsm, uint8_t region);
+
 /**
  * Set user data pointer
  * @param fsm Pointer to FSM structure
@@ -158,6 +257,7 @@ void* fsm_get_user_data(const FSM* fsm);
 
 /**
  * Check if FSM is in a specific state
+ * Checks the region the state belongs to
  * @param fsm Pointer to FSM structure
  * @param stateId State ID to check
  * @return true if currently in that state
@@ -166,6 +266,7 @@ bool fsm_is_in_state(const FSM* fsm, uint8_t stateId);
 
 /**
  * Print FSM status (for debugging via Serial)
+ * Too slow for per-transition logging; use the trace recorder in fsm_trace.h
  * @param fsm Pointer to FSM structure
  */
 void fsm_print_status(const FSM* fsm);
@@ -0,0 +1,34 @@
+#ifndef FSM_CRITICAL_H
+#define FSM_CRITICAL_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * Critical sections shared by the FSM sources
+ *
+ * The interrupt flag is saved on entry and restored on exit rather than
+ * set, so a section taken from an ISR or inside taskENTER_CRITICAL() leaves
+ * interrupts disabled for its caller.
+ */
+static inline uint8_t fsm_critical_enter() {
+#ifdef __AVR__
+    uint8_t sreg = SREG;
+    cli();
+    return sreg;
+#else
+    noInterrupts();
+    return 0;
+#endif
+}
+
+static inline void fsm_critical_exit(uint8_t state) {
+#ifdef __AVR__
+    SREG = state;
+#else
+    (void) state;
+    interrupts();
+#endif
+}
+
+#endif // FSM_CRITICAL_H
@@ -0,0 +1,166 @@
+#include "fsm_dispatcher.h"
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+
+/**
+ * Wrap-safe "now >= deadline" for 16- or 32-bit tick counters
+ */
+static bool dispatcher_tick_reached(TickType_t now, TickType_t deadline) {
+    return static_cast<TickType_t>(now - deadline) < static_cast<TickType_t>(portMAX_DELAY >> 1);
+}
+
+/**
+ * Insert an event keeping the batch ordered by machine priority.
+ * Equal priorities keep arrival order.
+ */
+static void dispatcher_insert_sorted(const FsmDispatcher* dispatcher,
+                                     FsmDispatcherEvent* batch, uint8_t count,
+                                     FsmDispatcherEvent event) {
+    uint8_t priority = dispatcher->machines[event.machine].priority;
+    uint8_t i = count;
+    while (i > 0 && dispatcher->machines[batch[i - 1].machine].priority < priority) {
+        batch[i] = batch[i - 1];
+        i--;
+    }
+    batch[i] = event;
+}
+
+/**
+ * Run fsm_update() for due machines and return ticks until the next one
+ */
+static TickType_t dispatcher_run_updates(FsmDispatcher* dispatcher) {
+    TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+
+    for (uint8_t i = 0; i < dispatcher->machineCount; i++) {
+        FsmDispatcherMachine* m = &dispatcher->machines[i];
+        if (m->updatePeriod == 0) {
+            continue;
+        }
+
+        if (dispatcher_tick_reached(now, m->nextUpdate)) {
+            fsm_update(m->fsm);
+            m->nextUpdate += m->updatePeriod;
+            // Skip missed periods instead of bursting to catch up
+            if (dispatcher_tick_reached(now, m->nextUpdate)) {
+                m->nextUpdate = now + m->updatePeriod;
+            }
+        }
+
+        TickType_t remaining = m->nextUpdate - now;
+        if (remaining < wait) {
+            wait = remaining;
+        }
+    }
+
+    return wait;
+}
+
+/**
+ * Dispatcher task: sleep until an event arrives or an update is due
+ */
+static void dispatcher_task(void* pvParameters) {
+    FsmDispatcher* dispatcher = static_cast<FsmDispatcher*>(pvParameters);
+    FsmDispatcherEvent batch[FSM_DISPATCHER_QUEUE_LENGTH];
+
+    TickType_t now = xTaskGetTickCount();
+    for (uint8_t i = 0; i < dispatcher->machineCount; i++) {
+        dispatcher->machines[i].nextUpdate = now + dispatcher->machines[i].updatePeriod;
+    }
+
+    TickType_t wait = dispatcher_run_updates(dispatcher);
+
+    for (;;) {
+        FsmDispatcherEvent event;
+        if (xQueueReceive(dispatcher->eventQueue, &event, wait) == pdTRUE) {
+            // Drain everything already queued so priorities apply across the batch
+            uint8_t count = 0;
+            do {
+                if (event.machine < dispatcher->machineCount) {
+                    dispatcher_insert_sorted(dispatcher, batch, count, event);
+                    count++;
+                }
+            } while (count < FSM_DISPATCHER_QUEUE_LENGTH &&
+                     xQueueReceive(dispatcher->eventQueue, &event, 0) == pdTRUE);
+
+            for (uint8_t i = 0; i < count; i++) {
+                fsm_process_event(dispatcher->machines[batch[i].machine].fsm, batch[i].event);
+            }
+        }
+
+        wait = dispatcher_run_updates(dispatcher);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API Implementation
+// -----------------------------------------------------------------------------
+
+bool fsm_dispatcher_init(FsmDispatcher* dispatcher) {
+    memset(dispatcher, 0, sizeof(FsmDispatcher));
+    dispatcher->eventQueue = xQueueCreate(FSM_DISPATCHER_QUEUE_LENGTH, sizeof(FsmDispatcherEvent));
+    return dispatcher->eventQueue != nullptr;
+}
+
+uint8_t fsm_dispatcher_add(FsmDispatcher* dispatcher, FSM* fsm,
+                           uint8_t priority, TickType_t updatePeriod) {
+    if (dispatcher->task != nullptr || fsm == nullptr ||
+        dispatcher->machineCount >= FSM_DISPATCHER_MAX_MACHINES) {
+        return FSM_DISPATCHER_NO_MACHINE;
+    }
+
+    FsmDispatcherMachine* m = &dispatcher->machines[dispatcher->machineCount];
+    m->fsm = fsm;
+    m->priority = priority;
+    m->updatePeriod = updatePeriod;
+    m->nextUpdate = 0;
+    return dispatcher->machineCount++;
+}
+
+bool fsm_dispatcher_start(FsmDispatcher* dispatcher, uint16_t stackDepth, UBaseType_t taskPriority) {
+    if (dispatcher->eventQueue == nullptr || dispatcher->task != nullptr) {
+        return false;
+    }
+
+    return xTaskCreate(dispatcher_task, "FsmDisp", stackDepth, dispatcher,
+                       taskPriority, &dispatcher->task) == pdPASS;
+}
+
+bool fsm_dispatcher_post(FsmDispatcher* dispatcher, uint8_t machine, uint8_t event, TickType_t timeout) {
+    if (machine >= dispatcher->machineCount) {
+        return false;
+    }
+
+    FsmDispatcherEvent item{machine, event};
+    if (xQueueSendToBack(dispatcher->eventQueue, &item, timeout) != pdTRUE) {
+        // The ISR path also counts drops; keep the 32-bit update whole
+        taskENTER_CRITICAL();
+        dispatcher->droppedEvents++;
+        taskEXIT_CRITICAL();
+        return false;
+    }
+    return true;
+}
+
+bool fsm_dispatcher_post_from_isr(FsmDispatcher* dispatcher, uint8_t machine, uint8_t event,
+                                  BaseType_t* higherPriorityTaskWoken) {
+    if (machine >= dispatcher->machineCount) {
+        return false;
+    }
+
+    FsmDispatcherEvent item{machine, event};
+    if (xQueueSendToBackFromISR(dispatcher->eventQueue, &item, higherPriorityTaskWoken) != pdTRUE) {
+        dispatcher->droppedEvents++;
+        return false;
+    }
+    return true;
+}
+
+uint32_t fsm_dispatcher_dropped(const FsmDispatcher* dispatcher) {
+    taskENTER_CRITICAL();
+    uint32_t dropped = dispatcher->droppedEvents;
+    taskEXIT_CRITICAL();
+    return dropped;
+}
@@ -0,0 +1,118 @@
+#ifndef FSM_DISPATCHER_H
+#define FSM_DISPATCHER_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include <queue.h>
+#include "fsm.h"
+
+/**
+ * Multi-FSM dispatcher
+ *
+ * Hosts several FSM instances in a single FreeRTOS task instead of one
+ * polling task (and stack) per machine. Events are posted to a FreeRTOS
+ * queue from any task or ISR; the dispatcher task sleeps on that queue,
+ * delivers each batch of pending events highest machine priority first
+ * (FIFO within equal priority) and runs fsm_update() only for machines
+ * registered with a non-zero update period, exactly when it is due.
+ *
+ * Hosted machines must only be driven through the dispatcher once it is
+ * started; the dispatcher task is their single owner, so no per-FSM mutex
+ * is needed.
+ */
+
+#ifndef FSM_DISPATCHER_MAX_MACHINES
+#define FSM_DISPATCHER_MAX_MACHINES 8
+#endif
+
+#ifndef FSM_DISPATCHER_QUEUE_LENGTH
+#define FSM_DISPATCHER_QUEUE_LENGTH 16
+#endif
+
+#define FSM_DISPATCHER_NO_MACHINE 0xFF
+
+// -----------------------------------------------------------------------------
+// Queued event
+// -----------------------------------------------------------------------------
+typedef struct FsmDispatcherEvent {
+    uint8_t machine;               // Machine handle returned by fsm_dispatcher_add
+    uint8_t event;                 // Event ID
+} FsmDispatcherEvent;
+
+// -----------------------------------------------------------------------------
+// Hosted machine
+// -----------------------------------------------------------------------------
+typedef struct FsmDispatcherMachine {
+    FSM* fsm;                      // Hosted FSM (already started)
+    uint8_t priority;              // Higher value = events delivered first
+    TickType_t updatePeriod;       // fsm_update() period, 0 = event-driven only
+    TickType_t nextUpdate;         // Tick count of the next due update
+} FsmDispatcherMachine;
+
+// -----------------------------------------------------------------------------
+// Dispatcher instance
+// -----------------------------------------------------------------------------
+typedef struct FsmDispatcher {
+    FsmDispatcherMachine machines[FSM_DISPATCHER_MAX_MACHINES];
+    uint8_t machineCount;
+    QueueHandle_t eventQueue;      // FsmDispatcherEvent items
+    TaskHandle_t task;             // Dispatcher task (nullptr until started)
+    volatile uint32_t droppedEvents;  // Posts rejected because the queue was full
+} FsmDispatcher;
+
+/**
+ * Initialize a dispatcher and create its event queue
+ * @param dispatcher Dispatcher instance
+ * @return true if the queue was created
+ */
+bool fsm_dispatcher_init(FsmDispatcher* dispatcher);
+
+/**
+ * Host an FSM in the dispatcher (call before fsm_dispatcher_start)
+ * @param dispatcher Dispatcher instance
+ * @param fsm FSM to host
+ * @param priority Event delivery priority (higher first)
+ * @param updatePeriod fsm_update() period in ticks, 0 if the FSM has no onUpdate work
+ * @return Machine handle or FSM_DISPATCHER_NO_MACHINE if the table is full
+ */
+uint8_t fsm_dispatcher_add(FsmDispatcher* dispatcher, FSM* fsm,
+                           uint8_t priority, TickType_t updatePeriod);
+
+/**
+ * Start the dispatcher task
+ * @param dispatcher Dispatcher instance
+ * @param stackDepth Task stack size in words
+ * @param taskPriority FreeRTOS task priority
+ * @return true if the task was created
+ */
+bool fsm_dispatcher_start(FsmDispatcher* dispatcher, uint16_t stackDepth, UBaseType_t taskPriority);
+
+/**
+ * Post an event to a hosted machine (task context)
+ * @param dispatcher Dispatcher instance
+ * @param machine Machine handle
+ * @param event Event ID
+ * @param timeout Ticks to wait for queue space
+ * @return true if the event was queued
+ */
+bool fsm_dispatcher_post(FsmDispatcher* dispatcher, uint8_t machine, uint8_t event, TickType_t timeout);
+
+/**
+ * Post an event to a hosted machine from an ISR
+ * @param dispatcher Dispatcher instance
+ * @param machine Machine handle
+ * @param event Event ID
+ * @param higherPriorityTaskWoken Set to pdTRUE if a context switch is needed
+ * @return true if the event was queued
+ */
+bool fsm_dispatcher_post_from_isr(FsmDispatcher* dispatcher, uint8_t machine, uint8_t event,
+                                  BaseType_t* higherPriorityTaskWoken);
+
+/**
+ * Posts rejected so far (task context; tasks and ISRs both update the count)
+ * @param dispatcher Dispatcher instance
+ * @return Dropped event count
+ */
+uint32_t fsm_dispatcher_dropped(const FsmDispatcher* dispatcher);
+
+#endif // FSM_DISPATCHER_H
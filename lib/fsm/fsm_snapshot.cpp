@@ -0,0 +1,202 @@
+#include "fsm_snapshot.h"
+#include <avr/eeprom.h>
+#include <stddef.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Internal helper functions
+// -----------------------------------------------------------------------------
+
+/**
+ * CRC-8 (poly 0x07), small enough to run on every transition
+ */
+static uint8_t snapshot_crc8(const uint8_t* data, size_t length) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void snapshot_hash_mix(uint32_t* hash, uint8_t value) {
+    *hash ^= value;
+    *hash *= 16777619UL;
+}
+
+/**
+ * 16-bit FNV-1a fold over the state and transition tables.
+ * Callbacks are not included so the signature survives relinking.
+ */
+static uint16_t snapshot_layout(const FSM* fsm) {
+    uint32_t hash = 2166136261UL;
+
+    snapshot_hash_mix(&hash, fsm->regionCount);
+    snapshot_hash_mix(&hash, fsm->stateCount);
+    for (uint8_t i = 0; i < fsm->stateCount; i++) {
+        snapshot_hash_mix(&hash, fsm->states[i].id);
+        snapshot_hash_mix(&hash, fsm->states[i].region);
+    }
+    snapshot_hash_mix(&hash, fsm->transitionCount);
+    for (uint8_t i = 0; i < fsm->transitionCount; i++) {
+        snapshot_hash_mix(&hash, fsm->transitions[i].fromState);
+        snapshot_hash_mix(&hash, fsm->transitions[i].toState);
+        snapshot_hash_mix(&hash, fsm->transitions[i].event);
+    }
+    return static_cast<uint16_t>((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+static uint8_t snapshot_checksum(const FSMSnapshot* snapshot) {
+    return snapshot_crc8(reinterpret_cast<const uint8_t*>(snapshot), offsetof(FSMSnapshot, checksum));
+}
+
+static const FSMState* snapshot_find_state(const FSM* fsm, uint8_t stateId) {
+    for (uint8_t i = 0; i < fsm->stateCount; i++) {
+        if (fsm->states[i].id == stateId) {
+            return &fsm->states[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Fill a snapshot of a started FSM with a known layout signature
+ */
+static void snapshot_capture(const FSM* fsm, uint16_t layout, FSMSnapshot* snapshot) {
+    unsigned long now = millis();
+
+    // Build in a local copy so a reset mid-write never leaves a record
+    // that passes the checksum with mixed contents
+    FSMSnapshot record;
+    memset(&record, 0, sizeof(record));
+    record.magic = FSM_SNAPSHOT_MAGIC;
+    record.regionCount = fsm->regionCount;
+    record.layout = layout;
+
+    for (uint8_t i = 0; i < fsm->regionCount; i++) {
+        const FSMRegion* r = &fsm->regions[i];
+        if (!r->active) {
+            // Inactive regions are recorded with an impossible elapsed time
+            record.regions[i].elapsedMs = UINT32_MAX;
+            continue;
+        }
+        record.regions[i].currentState = r->currentState;
+        record.regions[i].previousState = r->previousState;
+        record.regions[i].elapsedMs = now - r->stateEntryTime;
+    }
+    record.checksum = snapshot_checksum(&record);
+
+    *snapshot = record;
+}
+
+// -----------------------------------------------------------------------------
+// Public API Implementation
+// -----------------------------------------------------------------------------
+
+bool fsm_snapshot(const FSM* fsm, FSMSnapshot* snapshot) {
+    if (!fsm->initialized) {
+        return false;
+    }
+    snapshot_capture(fsm, snapshot_layout(fsm), snapshot);
+    return true;
+}
+
+bool fsm_restore(FSM* fsm, const FSMSnapshot* snapshot, bool runOnEnter) {
+    FSMSnapshot record = *snapshot;
+
+    if (record.magic != FSM_SNAPSHOT_MAGIC ||
+        record.checksum != snapshot_checksum(&record) ||
+        record.regionCount != fsm->regionCount ||
+        record.layout != snapshot_layout(fsm)) {
+        return false;
+    }
+
+    // Validate every region before touching the FSM
+    for (uint8_t i = 0; i < record.regionCount; i++) {
+        if (record.regions[i].elapsedMs == UINT32_MAX) {
+            continue;
+        }
+        const FSMState* current = snapshot_find_state(fsm, record.regions[i].currentState);
+        const FSMState* previous = snapshot_find_state(fsm, record.regions[i].previousState);
+        if (current == NULL || previous == NULL || current->region != i || previous->region != i) {
+            return false;
+        }
+    }
+
+    unsigned long now = millis();
+    bool anyActive = false;
+
+    for (uint8_t i = 0; i < record.regionCount; i++) {
+        FSMRegion* r = &fsm->regions[i];
+        if (record.regions[i].elapsedMs == UINT32_MAX) {
+            r->active = false;
+            continue;
+        }
+        r->currentState = record.regions[i].currentState;
+        r->previousState = record.regions[i].previousState;
+        r->stateEntryTime = now - record.regions[i].elapsedMs;
+        r->active = true;
+        anyActive = true;
+    }
+
+    if (!anyActive) {
+        return false;
+    }
+
+    fsm->initialized = true;
+
+    for (uint8_t i = 0; i < record.regionCount; i++) {
+        FSMRegion* r = &fsm->regions[i];
+        if (!r->active) {
+            continue;
+        }
+        fsm_trace_record(fsm, r->previousState, r->currentState, FSM_TRACE_EVENT_RESTORE);
+
+        // Outputs driven from onEnter were reset with the MCU
+        const FSMState* state = snapshot_find_state(fsm, r->currentState);
+        if (runOnEnter && state->onEnter != NULL) {
+            fsm->activeRegion = i;
+            state->onEnter(fsm);
+        }
+    }
+
+    return true;
+}
+
+void fsm_snapshot_attach(FSM* fsm, FSMSnapshot* snapshot) {
+    fsm->snapshotTarget = snapshot;
+    if (snapshot != NULL) {
+        fsm->snapshotLayout = snapshot_layout(fsm);
+        fsm_snapshot_refresh(fsm);
+    }
+}
+
+void fsm_snapshot_refresh(FSM* fsm) {
+    if (fsm->snapshotTarget == NULL || !fsm->initialized) {
+        return;
+    }
+    fsm->snapshotTime = millis();
+    snapshot_capture(fsm, fsm->snapshotLayout, fsm->snapshotTarget);
+}
+
+void fsm_snapshot_invalidate(FSMSnapshot* snapshot) {
+    snapshot->magic = 0;
+}
+
+bool fsm_snapshot_save_eeprom(const FSM* fsm, uint16_t address) {
+    FSMSnapshot record;
+    if (!fsm_snapshot(fsm, &record)) {
+        return false;
+    }
+    // eeprom_update_block skips unchanged bytes to save write cycles
+    eeprom_update_block(&record, reinterpret_cast<void*>(address), sizeof(record));
+    return true;
+}
+
+bool fsm_restore_eeprom(FSM* fsm, uint16_t address, bool runOnEnter) {
+    FSMSnapshot record;
+    eeprom_read_block(&record, reinterpret_cast<const void*>(address), sizeof(record));
+    return fsm_restore(fsm, &record, runOnEnter);
+}
@@ -0,0 +1,109 @@
+#ifndef FSM_SNAPSHOT_H
+#define FSM_SNAPSHOT_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "fsm.h"
+
+/**
+ * FSM snapshot / restore for warm restarts
+ *
+ * A snapshot is a small self-checking record of every region's current
+ * state, previous state and time spent in the current state. It can live in
+ * a .noinit RAM variable (survives watchdog and external resets, not power
+ * loss) or in EEPROM. After a reset, fsm_restore() puts the machine straight
+ * back into the recorded states instead of replaying setup via fsm_start().
+ *
+ * A snapshot is rejected when its checksum fails or when it was taken from a
+ * machine with a different state/transition table (layout signature), so
+ * stale .noinit garbage after power-up or a firmware change falls back to a
+ * normal fsm_start().
+ *
+ * Typical .noinit use:
+ *   static FSMSnapshot gLedSnapshot FSM_SNAPSHOT_NOINIT;
+ *   ...build states and transitions...
+ *   if (!fsm_restore(&gLedFsm, &gLedSnapshot, true)) {
+ *       fsm_start(&gLedFsm, STATE_RED_LED);
+ *   }
+ *   fsm_snapshot_attach(&gLedFsm, &gLedSnapshot);  // keep it current
+ *
+ * An attached snapshot is refreshed on every transition and, to keep the
+ * time in state current, from fsm_update() at most every
+ * FSM_SNAPSHOT_REFRESH_MS. The layout signature is computed once when the
+ * snapshot is attached (and again by fsm_start()), so a refresh costs one
+ * CRC-8 over the record. Attach once the state/transition tables are complete.
+ */
+
+#define FSM_SNAPSHOT_MAGIC 0xF5
+
+// Longest gap between time-in-state refreshes of an attached snapshot
+#ifndef FSM_SNAPSHOT_REFRESH_MS
+#define FSM_SNAPSHOT_REFRESH_MS 100
+#endif
+
+// Place a snapshot variable in RAM that is not cleared at startup
+#define FSM_SNAPSHOT_NOINIT __attribute__((section(".noinit")))
+
+// -----------------------------------------------------------------------------
+// Snapshot record
+// -----------------------------------------------------------------------------
+typedef struct FSMSnapshotRegion {
+    uint8_t currentState;          // Current state ID
+    uint8_t previousState;         // Previous state ID
+    uint32_t elapsedMs;            // Time spent in current state when taken
+} FSMSnapshotRegion;
+
+typedef struct FSMSnapshot {
+    uint8_t magic;                 // FSM_SNAPSHOT_MAGIC
+    uint8_t regionCount;           // Number of valid region entries
+    uint16_t layout;               // Signature of the state/transition table
+    FSMSnapshotRegion regions[FSM_MAX_REGIONS];
+    uint8_t checksum;              // CRC-8 over all preceding bytes
+} FSMSnapshot;
+
+/**
+ * Capture the current state of every region
+ * @param fsm Pointer to a started FSM
+ * @param snapshot Destination record
+ * @return false if the FSM has not been started
+ */
+bool fsm_snapshot(const FSM* fsm, FSMSnapshot* snapshot);
+
+/**
+ * Restore regions from a snapshot (replaces fsm_start after a reset)
+ * @param fsm Pointer to an FSM with the same states/transitions as when captured
+ * @param snapshot Source record
+ * @param runOnEnter Call onEnter of each restored state to re-apply outputs
+ * @return true if the snapshot was valid and has been applied
+ */
+bool fsm_restore(FSM* fsm, const FSMSnapshot* snapshot, bool runOnEnter);
+
+/**
+ * Keep a snapshot current automatically (refreshed on every transition and
+ * periodically from fsm_update). Pass NULL to detach.
+ */
+void fsm_snapshot_attach(FSM* fsm, FSMSnapshot* snapshot);
+
+/**
+ * Re-capture the attached snapshot with the stored layout signature
+ * (called by the FSM core; no-op when nothing is attached)
+ */
+void fsm_snapshot_refresh(FSM* fsm);
+
+/**
+ * Mark a snapshot invalid (e.g. after a deliberate cold start)
+ */
+void fsm_snapshot_invalidate(FSMSnapshot* snapshot);
+
+/**
+ * Capture and store a snapshot in EEPROM (only changed bytes are written)
+ * @param address EEPROM byte address (needs sizeof(FSMSnapshot) bytes)
+ */
+bool fsm_snapshot_save_eeprom(const FSM* fsm, uint16_t address);
+
+/**
+ * Restore from a snapshot stored with fsm_snapshot_save_eeprom
+ */
+bool fsm_restore_eeprom(FSM* fsm, uint16_t address, bool runOnEnter);
+
+#endif // FSM_SNAPSHOT_H
@@ -0,0 +1,172 @@
+#include "fsm_trace.h"
+#include "fsm.h"
+#include "fsm_critical.h"
+
+#if FSM_TRACE_ENABLED
+
+static_assert((FSM_TRACE_BUFFER_SIZE & (FSM_TRACE_BUFFER_SIZE - 1)) == 0,
+              "FSM_TRACE_BUFFER_SIZE must be a power of two");
+static_assert(FSM_TRACE_BUFFER_SIZE <= 256, "FSM_TRACE_BUFFER_SIZE must fit 8-bit indices");
+static_assert(FSM_TRACE_MAX_FSMS < FSM_TRACE_NO_ID, "Too many traced FSMs");
+
+constexpr uint8_t TRACE_INDEX_MASK = FSM_TRACE_BUFFER_SIZE - 1;
+
+// -----------------------------------------------------------------------------
+// Trace state
+// -----------------------------------------------------------------------------
+static FSMTraceRecord gTraceBuffer[FSM_TRACE_BUFFER_SIZE];
+static volatile uint8_t gTraceHead = 0;        // Next slot to write
+static volatile uint16_t gTraceCount = 0;      // Buffered records
+static volatile uint32_t gTraceOverwritten = 0;
+
+static const FSM* gTracedFsms[FSM_TRACE_MAX_FSMS];
+static uint8_t gTracedFsmCount = 0;
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+static void trace_write_u8(Print& out, uint8_t value) {
+    out.write(value);
+}
+
+static void trace_write_u16(Print& out, uint16_t value) {
+    out.write(static_cast<uint8_t>(value & 0xFF));
+    out.write(static_cast<uint8_t>(value >> 8));
+}
+
+static void trace_write_u32(Print& out, uint32_t value) {
+    trace_write_u16(out, static_cast<uint16_t>(value & 0xFFFF));
+    trace_write_u16(out, static_cast<uint16_t>(value >> 16));
+}
+
+static void trace_write_name(Print& out, const char* name) {
+    if (name == NULL) {
+        name = "";
+    }
+    size_t len = strlen(name);
+    if (len > 255) {
+        len = 255;
+    }
+    trace_write_u8(out, static_cast<uint8_t>(len));
+    out.write(reinterpret_cast<const uint8_t*>(name), len);
+}
+
+/**
+ * Remove the oldest record (returns false when empty)
+ */
+static bool trace_pop(FSMTraceRecord* record) {
+    bool popped = false;
+    uint8_t sreg = fsm_critical_enter();
+    if (gTraceCount > 0) {
+        uint8_t tail = static_cast<uint8_t>((gTraceHead - gTraceCount) & TRACE_INDEX_MASK);
+        *record = gTraceBuffer[tail];
+        gTraceCount--;
+        popped = true;
+    }
+    fsm_critical_exit(sreg);
+    return popped;
+}
+
+// -----------------------------------------------------------------------------
+// Public API Implementation
+// -----------------------------------------------------------------------------
+
+uint8_t fsm_trace_register(FSM* fsm) {
+    // Re-initialising an FSM keeps its previous ID
+    for (uint8_t i = 0; i < gTracedFsmCount; i++) {
+        if (gTracedFsms[i] == fsm) {
+            return i;
+        }
+    }
+    if (gTracedFsmCount >= FSM_TRACE_MAX_FSMS) {
+        return FSM_TRACE_NO_ID;
+    }
+    gTracedFsms[gTracedFsmCount] = fsm;
+    return gTracedFsmCount++;
+}
+
+void fsm_trace_record(const FSM* fsm, uint8_t fromState, uint8_t toState, uint8_t event) {
+    if (fsm->traceId == FSM_TRACE_NO_ID) {
+        return;
+    }
+
+    uint32_t now = micros();
+
+    uint8_t sreg = fsm_critical_enter();
+    FSMTraceRecord* record = &gTraceBuffer[gTraceHead];
+    record->timestamp = now;
+    record->fsmId = fsm->traceId;
+    record->fromState = fromState;
+    record->toState = toState;
+    record->event = event;
+    gTraceHead = static_cast<uint8_t>((gTraceHead + 1) & TRACE_INDEX_MASK);
+    if (gTraceCount < FSM_TRACE_BUFFER_SIZE) {
+        gTraceCount++;
+    } else {
+        gTraceOverwritten++;
+    }
+    fsm_critical_exit(sreg);
+}
+
+uint16_t fsm_trace_count() {
+    uint8_t sreg = fsm_critical_enter();
+    uint16_t count = gTraceCount;
+    fsm_critical_exit(sreg);
+    return count;
+}
+
+uint32_t fsm_trace_overwritten() {
+    uint8_t sreg = fsm_critical_enter();
+    uint32_t overwritten = gTraceOverwritten;
+    fsm_critical_exit(sreg);
+    return overwritten;
+}
+
+void fsm_trace_clear() {
+    uint8_t sreg = fsm_critical_enter();
+    gTraceCount = 0;
+    gTraceOverwritten = 0;
+    fsm_critical_exit(sreg);
+}
+
+void fsm_trace_dump(Print& out) {
+    // Header
+    out.write(reinterpret_cast<const uint8_t*>("FTRC"), 4);
+    trace_write_u8(out, FSM_TRACE_FORMAT_VERSION);
+    trace_write_u8(out, gTracedFsmCount);
+
+    // Name table so the host can resolve IDs without the firmware sources
+    for (uint8_t i = 0; i < gTracedFsmCount; i++) {
+        const FSM* fsm = gTracedFsms[i];
+        trace_write_u8(out, i);
+        trace_write_name(out, fsm->name);
+        trace_write_u8(out, fsm->stateCount);
+        for (uint8_t s = 0; s < fsm->stateCount; s++) {
+            trace_write_u8(out, fsm->states[s].id);
+            trace_write_name(out, fsm->states[s].name);
+        }
+    }
+
+    // Records are counted up front; anything recorded while dumping stays
+    // buffered for the next dump
+    uint8_t sreg = fsm_critical_enter();
+    uint16_t count = gTraceCount;
+    uint32_t overwritten = gTraceOverwritten;
+    gTraceOverwritten = 0;
+    fsm_critical_exit(sreg);
+
+    trace_write_u16(out, count);
+    trace_write_u32(out, overwritten);
+
+    FSMTraceRecord record;
+    for (uint16_t i = 0; i < count && trace_pop(&record); i++) {
+        trace_write_u32(out, record.timestamp);
+        trace_write_u8(out, record.fsmId);
+        trace_write_u8(out, record.fromState);
+        trace_write_u8(out, record.toState);
+        trace_write_u8(out, record.event);
+    }
+}
+
+#endif // FSM_TRACE_ENABLED
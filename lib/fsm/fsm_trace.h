@@ -0,0 +1,106 @@
+#ifndef FSM_TRACE_H
+#define FSM_TRACE_H
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/**
+ * FSM transition trace recorder
+ *
+ * Every transition taken by any traced FSM is stored as a fixed 8-byte
+ * binary record in a RAM ring buffer. Recording costs a few stores, so it
+ * can stay enabled during fast state churn where fsm_print_status() would
+ * stall the caller on Serial. The ring is dumped on demand with
+ * fsm_trace_dump() and decoded on the host by tools/fsm_trace_decode.py,
+ * which maps FSM and state IDs back to their names.
+ *
+ * Tracing is compiled out unless FSM_TRACE_ENABLED is set to 1
+ * (e.g. build_flags = -DFSM_TRACE_ENABLED=1 in platformio.ini).
+ *
+ * Dump format (little-endian):
+ *   "FTRC" | version u8 | fsmCount u8
+ *   per FSM:   traceId u8 | nameLen u8 | name | stateCount u8
+ *              per state: stateId u8 | nameLen u8 | name
+ *   recordCount u16 | overwritten u32
+ *   per record: timestamp u32 (micros) | fsmId u8 | from u8 | to u8 | event u8
+ */
+
+#ifndef FSM_TRACE_ENABLED
+#define FSM_TRACE_ENABLED 0
+#endif
+
+// Ring buffer capacity in records (power of two, 8 bytes each)
+#ifndef FSM_TRACE_BUFFER_SIZE
+#define FSM_TRACE_BUFFER_SIZE 64
+#endif
+
+// Maximum number of FSM instances that get a trace ID
+#ifndef FSM_TRACE_MAX_FSMS
+#define FSM_TRACE_MAX_FSMS 8
+#endif
+
+#define FSM_TRACE_FORMAT_VERSION 1
+#define FSM_TRACE_NO_ID 0xFF
+
+// Pseudo event IDs for transitions that are not driven by an event
+#define FSM_TRACE_EVENT_RESTORE 0xFD // fsm_restore()
+#define FSM_TRACE_EVENT_START 0xFE   // fsm_start()
+#define FSM_TRACE_EVENT_FORCE 0xFF   // fsm_force_state()
+
+struct FSM;
+
+// -----------------------------------------------------------------------------
+// Trace record (8 bytes)
+// -----------------------------------------------------------------------------
+typedef struct FSMTraceRecord {
+    uint32_t timestamp;            // micros() when the transition completed
+    uint8_t fsmId;                 // Trace ID assigned by fsm_trace_register
+    uint8_t fromState;             // Source state ID
+    uint8_t toState;               // Target state ID
+    uint8_t event;                 // Triggering event or FSM_TRACE_EVENT_*
+} FSMTraceRecord;
+
+#if FSM_TRACE_ENABLED
+
+/**
+ * Assign a trace ID to an FSM (called by fsm_init)
+ * @param fsm Pointer to FSM structure
+ * @return Assigned trace ID or FSM_TRACE_NO_ID if the table is full
+ */
+uint8_t fsm_trace_register(struct FSM* fsm);
+
+/**
+ * Append one transition record (overwrites the oldest when full)
+ */
+void fsm_trace_record(const struct FSM* fsm, uint8_t fromState, uint8_t toState, uint8_t event);
+
+/**
+ * Number of records currently buffered
+ */
+uint16_t fsm_trace_count();
+
+/**
+ * Number of records overwritten since the last dump/clear
+ */
+uint32_t fsm_trace_overwritten();
+
+/**
+ * Drop all buffered records
+ */
+void fsm_trace_clear();
+
+/**
+ * Write the name table and all buffered records in binary form, then clear
+ * @param out Destination (usually Serial)
+ */
+void fsm_trace_dump(Print& out);
+
+#else
+
+#define fsm_trace_register(fsm) ((void)(fsm), FSM_TRACE_NO_ID)
+#define fsm_trace_record(fsm, fromState, toState, event) \
+    ((void)(fsm), (void)(fromState), (void)(toState), (void)(event))
+
+#endif // FSM_TRACE_ENABLED
+
+#endif // FSM_TRACE_H
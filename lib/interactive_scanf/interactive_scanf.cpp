@@ -1,35 +1,27 @@
 #include "interactive_scanf.h"
-
-bool exitSymbol(char ch, const char* exitChars);
+#include "line_reader.h"
 
 
 void interactiveScanf(char* returnBuffer, int bufferSize, const char* intitMessage, const char* exitMessage,const char* eofMessage,const char* exitChars) 
 {
     printf(intitMessage); // Print initial message
-    int ch; // Variable to hold each character input
-    for (;bufferSize > 1; bufferSize--) { // Leave space for null terminator
-        ch = getchar(); // Read a character from input
+
+    LineReader reader;
+    lineReaderInit(&reader, returnBuffer, bufferSize, stdout, exitChars);
+    for (;;) {
+        int ch = getchar(); // Read a character from input
         if (ch == EOF) { // Handle EOF (e.g., Ctrl+D)
             printf(eofMessage);
             break;
         }
-        // Check for exit characters
-        if (exitSymbol((char)ch, exitChars))
+        if (lineReaderFeed(&reader, (char)ch))
             break;
 
-        *returnBuffer++ = (char)ch; // Store character in buffer
-        printf("%c", ch); // Echo current character
+        // getchar() may block on the next character, so the echo cannot
+        // wait for it (lineReaderPoll() batches a whole burst)
+        lineReaderFlushEcho(&reader);
     }
-    fflush(stdin); // Clear input buffer to avoid residual characters
-    *returnBuffer = '\0'; // Null-terminate the string
+    lineReaderFlushEcho(&reader);
+    returnBuffer[reader.length] = '\0'; // Also terminates a line cut short by EOF
     printf(exitMessage); // Print exit message
 }
-
-inline bool exitSymbol(char ch, const char* exitChars) {
-    // Check if the character is in the set of exit characters
-    for(const char* p = exitChars; *p != '\0'; p++) 
-        if (ch == *p)
-            return true;
-    
-    return false;
-}
\ No newline at end of file
@@ -3,6 +3,12 @@
 
 #include <Arduino.h>
 
+/**
+ * Blocking line input on stdin, built on LineReader (backspace editing).
+ * Characters that do not fit the buffer are dropped until an exit character
+ * arrives. For loops that must keep running while a line is typed, poll a
+ * LineReader directly (see line_reader.h).
+ */
 void interactiveScanf(
         char* returnBuffer, int bufferSize, 
         const char* intitMessage = "Type characters (press [Enter] to exit):\n", 
@@ -10,4 +16,4 @@ void interactiveScanf(
         const char* eofMessage = "WARNING: Unexpected exit...\n",
         const char* exitChars = "\r\n");
 
-#endif // INTERACTIVE_SCANF_H
\ No newline at end of file
+#endif // INTERACTIVE_SCANF_H
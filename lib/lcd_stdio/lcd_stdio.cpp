@@ -5,10 +5,16 @@ uint8_t LCDStdio::lcdCols = 16;
 uint8_t LCDStdio::lcdRows = 2;
 uint8_t LCDStdio::cursorCol = 0;
 uint8_t LCDStdio::cursorRow = 0;
+bool LCDStdio::autoFlush = true;
+char LCDStdio::shadow[LCD_STDIO_MAX_ROWS][LCD_STDIO_MAX_COLS];
+char LCDStdio::shown[LCD_STDIO_MAX_ROWS][LCD_STDIO_MAX_COLS];
+
+// Clearing costs about as much as this many character writes
+static const uint8_t CLEAR_COST_CELLS = 4;
 
 LiquidCrystal_I2C* LCDStdio::init(uint8_t addr, uint8_t cols, uint8_t rows) {
-    lcdCols = cols;
-    lcdRows = rows;
+    lcdCols = cols < LCD_STDIO_MAX_COLS ? cols : LCD_STDIO_MAX_COLS;
+    lcdRows = rows < LCD_STDIO_MAX_ROWS ? rows : LCD_STDIO_MAX_ROWS;
     cursorCol = 0;
     cursorRow = 0;
     
@@ -18,6 +24,8 @@ LiquidCrystal_I2C* LCDStdio::init(uint8_t addr, uint8_t cols, uint8_t rows) {
     lcd->backlight();
     lcd->clear();
     lcd->setCursor(0, 0);
+    blankShadow();
+    memcpy(shown, shadow, sizeof(shown));
     return lcd;
 }
 
@@ -26,12 +34,10 @@ LiquidCrystal_I2C* LCDStdio::getLCD() {
 }
 
 void LCDStdio::setCursor(uint8_t col, uint8_t row) {
+    // Only the shadow position; flush() places the LCD cursor itself
     if (col < lcdCols && row < lcdRows) {
         cursorCol = col;
         cursorRow = row;
-        if (lcd) {
-            lcd->setCursor(cursorCol, cursorRow);
-        }
     }
 }
 
@@ -45,9 +51,60 @@ void LCDStdio::clear() {
         lcd->clear();
         cursorCol = 0;
         cursorRow = 0;
+        blankShadow();
+        memcpy(shown, shadow, sizeof(shown));
+    }
+}
+
+void LCDStdio::flush() {
+    if (!lcd) return;
+
+    // A blanked frame over a busy display: one clear beats many spaces
+    uint8_t changed = 0;
+    bool blank = true;
+    for (uint8_t row = 0; row < lcdRows; row++) {
+        for (uint8_t col = 0; col < lcdCols; col++) {
+            blank = blank && shadow[row][col] == ' ';
+            changed += shadow[row][col] != shown[row][col];
+        }
+    }
+    if (changed == 0) return;
+    if (blank && changed > CLEAR_COST_CELLS) {
+        lcd->clear();
+        memcpy(shown, shadow, sizeof(shown));
+        return;
+    }
+
+    for (uint8_t row = 0; row < lcdRows; row++) {
+        uint8_t col = 0;
+        while (col < lcdCols) {
+            if (shadow[row][col] == shown[row][col]) {
+                col++;
+                continue;
+            }
+            // One cursor move per run of adjacent changed cells
+            lcd->setCursor(col, row);
+            while (col < lcdCols && shadow[row][col] != shown[row][col]) {
+                lcd->write(static_cast<uint8_t>(shadow[row][col]));
+                shown[row][col] = shadow[row][col];
+                col++;
+            }
+        }
     }
 }
 
+void LCDStdio::setAutoFlush(bool enabled) {
+    autoFlush = enabled;
+    if (enabled) {
+        flush();
+    }
+}
+
+void LCDStdio::invalidate() {
+    // No printable character matches, so every cell counts as changed
+    memset(shown, 0, sizeof(shown));
+}
+
 int LCDStdio::putcharlcd(char c, FILE* file) {
     if (!lcd) return -1;
     
@@ -71,9 +128,7 @@ int LCDStdio::putcharlcd(char c, FILE* file) {
         case '\b':
             if (cursorCol > 0) {
                 cursorCol--;
-                lcd->setCursor(cursorCol, cursorRow);
-                lcd->print(' ');  // Erase character
-                lcd->setCursor(cursorCol, cursorRow);
+                shadow[cursorRow][cursorCol] = ' ';  // Erase character
             }
             break;
             
@@ -83,7 +138,10 @@ int LCDStdio::putcharlcd(char c, FILE* file) {
             }
             break;
     }
-    
+
+    if (autoFlush) {
+        flush();
+    }
     return c;
 }
 
@@ -95,19 +153,17 @@ void LCDStdio::handleNewline() {
         // At bottom - scroll up or wrap to top
         scrollUp();
     }
-    lcd->setCursor(cursorCol, cursorRow);
 }
 
 void LCDStdio::handleCarriageReturn() {
     cursorCol = 0;
-    lcd->setCursor(cursorCol, cursorRow);
 }
 
 void LCDStdio::handleFormFeed() {
-    lcd->clear();
+    // Blank the shadow only; flush() sends what actually changed
+    blankShadow();
     cursorCol = 0;
     cursorRow = 0;
-    lcd->setCursor(0, 0);
 }
 
 void LCDStdio::handleTab() {
@@ -129,9 +185,8 @@ void LCDStdio::printCharacter(char c) {
         }
     }
     
-    // Print character at current position
-    lcd->setCursor(cursorCol, cursorRow);
-    lcd->print(c);
+    // Draw character at current position
+    shadow[cursorRow][cursorCol] = c;
     
     // Advance cursor
     cursorCol++;
@@ -146,14 +201,16 @@ void LCDStdio::advanceCursor() {
         } else {
             scrollUp();
         }
-        lcd->setCursor(cursorCol, cursorRow);
     }
 }
 
 void LCDStdio::scrollUp() {
-    lcd->clear();
+    blankShadow();
     cursorRow = 0;
     cursorCol = 0;
-    lcd->setCursor(0, 0);
+}
+
+void LCDStdio::blankShadow() {
+    memset(shadow, ' ', sizeof(shadow));
 }
 
@@ -4,7 +4,30 @@
 #include <Arduino.h>
 #include <LiquidCrystal_I2C.h>
 
+// Largest supported display (shadow buffers are sized for it)
+#ifndef LCD_STDIO_MAX_COLS
+#define LCD_STDIO_MAX_COLS 20
+#endif
+#ifndef LCD_STDIO_MAX_ROWS
+#define LCD_STDIO_MAX_ROWS 4
+#endif
+
 // LCD stdio wrapper for character output
+//
+// Output is drawn into a RAM shadow of the display; flush() compares it with
+// what the LCD shows and sends only the changed cells, one cursor move per
+// run of adjacent changes. '\f' blanks the shadow instead of clearing the
+// LCD, so a status frame redrawn with a leading '\f' costs I2C traffic only
+// for the characters that changed. With auto-flush (the default) every
+// character is flushed at once; code that draws whole frames turns it off
+// and calls flush() after each frame, so cells blanked by '\f' and then
+// redrawn never reach the display.
+//
+// The shadow buffers and flush() are single-writer: nothing here locks.
+// Because '\f' no longer clears the LCD, a flush that overlaps drawing or
+// another flush leaves the record of what the LCD shows out of step with
+// the glass, and a wrong cell stays until its character changes. Tasks that
+// share the display must draw and flush each frame under one lock.
 class LCDStdio {
 public:
     // Initialize the LCD
@@ -20,6 +43,14 @@ public:
     static void setCursor(uint8_t col, uint8_t row);
     static void getCursor(uint8_t& col, uint8_t& row);
     static void clear();
+
+    // Send changed cells to the LCD
+    static void flush();
+    static void setAutoFlush(bool enabled);
+
+    // Forget what the LCD shows (after drawing through getLCD() directly),
+    // so the next flush() redraws every cell
+    static void invalidate();
     
 private:
     static LiquidCrystal_I2C* lcd;
@@ -27,6 +58,9 @@ private:
     static uint8_t lcdRows;
     static uint8_t cursorCol;
     static uint8_t cursorRow;
+    static bool autoFlush;
+    static char shadow[LCD_STDIO_MAX_ROWS][LCD_STDIO_MAX_COLS];   // Drawn by putcharlcd()
+    static char shown[LCD_STDIO_MAX_ROWS][LCD_STDIO_MAX_COLS];    // On the LCD
     
     // Helper functions
     static void handleNewline();
@@ -36,6 +70,7 @@ private:
     static void printCharacter(char c);
     static void advanceCursor();
     static void scrollUp();
+    static void blankShadow();
 };
 
 #endif
@@ -0,0 +1,108 @@
+#include "line_reader.h"
+#include <string.h>
+
+static const char BACKSPACE = '\b';
+static const char DELETE = 0x7F;
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+static void echoChar(LineReader* reader, char c) {
+    if (reader->echo == nullptr) {
+        return;
+    }
+    if (reader->echoLength == LINE_READER_ECHO_SIZE) {
+        lineReaderFlushEcho(reader);
+    }
+    reader->echoBuffer[reader->echoLength++] = c;
+}
+
+static void startLine(LineReader* reader) {
+    reader->length = 0;
+    reader->complete = false;
+    reader->truncated = false;
+    reader->buffer[0] = '\0';
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+void lineReaderInit(LineReader* reader, char* buffer, size_t size, FILE* echo, const char* terminators) {
+    reader->buffer = buffer;
+    reader->size = size;
+    reader->terminators = terminators;
+    reader->echo = echo;
+    reader->echoLength = 0;
+    reader->skipNewline = false;
+    startLine(reader);
+}
+
+bool lineReaderFeed(LineReader* reader, char c) {
+    // Second half of "\r\n"
+    bool skip = reader->skipNewline && c == '\n';
+    reader->skipNewline = false;
+    if (skip) {
+        return false;
+    }
+
+    if (reader->complete) {
+        startLine(reader);
+    }
+
+    if (c != '\0' && strchr(reader->terminators, c) != nullptr) {
+        reader->buffer[reader->length] = '\0';
+        reader->complete = true;
+        reader->skipNewline = (c == '\r');
+        return true;
+    }
+
+    if (c == BACKSPACE || c == DELETE) {
+        if (reader->length > 0) {
+            reader->length--;
+            echoChar(reader, BACKSPACE);
+            echoChar(reader, ' ');
+            echoChar(reader, BACKSPACE);
+        }
+        return false;
+    }
+
+    if (reader->length + 1 >= reader->size) {
+        reader->truncated = true;
+        return false;
+    }
+    reader->buffer[reader->length++] = c;
+    echoChar(reader, c);
+    return false;
+}
+
+bool lineReaderPoll(LineReader* reader, Stream* in) {
+    bool complete = false;
+    while (!complete && in->available() > 0) {
+        int c = in->read();
+        if (c < 0) {
+            break;
+        }
+        complete = lineReaderFeed(reader, static_cast<char>(c));
+    }
+    lineReaderFlushEcho(reader);
+    return complete;
+}
+
+void lineReaderFlushEcho(LineReader* reader) {
+    if (reader->echoLength == 0) {
+        return;
+    }
+    fwrite(reader->echoBuffer, 1, reader->echoLength, reader->echo);
+    reader->echoLength = 0;
+}
+
+const char* lineReaderLine(const LineReader* reader) {
+    return reader->complete ? reader->buffer : nullptr;
+}
+
+void lineReaderReset(LineReader* reader) {
+    reader->echoLength = 0;
+    reader->skipNewline = false;
+    startLine(reader);
+}
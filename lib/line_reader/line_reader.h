@@ -0,0 +1,76 @@
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <Arduino.h>
+#include <stdio.h>
+
+/**
+ * Incremental, non-blocking line editor
+ *
+ * Characters are fed one at a time as they arrive (from a Stream, an ISR
+ * queue, a keypad, ...); the reader never waits for input. Backspace (BS or
+ * DEL) erases the last character, and the echo of everything fed in one go
+ * is collected and written to the echo stream as a single block instead of
+ * one printf per character. The terminator itself is not echoed, so the
+ * caller decides how the line ends on screen.
+ *
+ * A "\r\n" pair ends a single line. Characters beyond the buffer are dropped
+ * (and not echoed) until the terminator arrives. Turn off the echo of the
+ * stdio layer (e.g. initSerialStdio(baud, false)) when the reader echoes.
+ */
+
+// Echo bytes collected before they are written out
+#ifndef LINE_READER_ECHO_SIZE
+#define LINE_READER_ECHO_SIZE 16
+#endif
+
+struct LineReader {
+    char* buffer;               // Caller-owned line storage
+    size_t size;                // Including terminator
+    size_t length;
+    const char* terminators;
+    FILE* echo;                 // nullptr: no echo
+    char echoBuffer[LINE_READER_ECHO_SIZE];
+    uint8_t echoLength;
+    bool complete;              // Line ready, cleared by the next character
+    bool skipNewline;           // Last line ended with '\r'
+    bool truncated;             // Characters were dropped from the current line
+};
+
+/**
+ * Prepare a reader on a caller-owned buffer
+ * @param echo Stream for the echo (nullptr: no echo)
+ * @param terminators Characters that complete a line
+ */
+void lineReaderInit(LineReader* reader, char* buffer, size_t size,
+                    FILE* echo = stdout, const char* terminators = "\r\n");
+
+/**
+ * Feed one character; its echo is buffered until lineReaderFlushEcho()
+ * @return true if the character completed a line
+ */
+bool lineReaderFeed(LineReader* reader, char c);
+
+/**
+ * Feed every character the stream has available, stopping after a completed
+ * line (the rest stays in the stream for the next call), then flush the echo
+ * @return true if a line is complete
+ */
+bool lineReaderPoll(LineReader* reader, Stream* in);
+
+/**
+ * Write out the buffered echo
+ */
+void lineReaderFlushEcho(LineReader* reader);
+
+/**
+ * The completed line (NUL-terminated), or nullptr while a line is in progress
+ */
+const char* lineReaderLine(const LineReader* reader);
+
+/**
+ * Discard the line in progress
+ */
+void lineReaderReset(LineReader* reader);
+
+#endif // LINE_READER_H
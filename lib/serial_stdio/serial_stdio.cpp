@@ -2,14 +2,40 @@
 
 static FILE serialStdio;
 static bool echoEnabled = true;
+static unsigned long readTimeoutMs = SERIAL_READ_FOREVER;
+static void (*waitHook)() = nullptr;
+static SerialTxOverflow txOverflow = SERIAL_TX_BLOCK;
+static uint16_t txDropped = 0;
+static uint16_t txStalls = 0;
 
 int serialPutchar(char c, FILE *file) {
+    if (Serial.availableForWrite() == 0) {
+        txStalls++;
+        if (txOverflow == SERIAL_TX_DROP) {
+            // Counted, not reported, so printf carries on
+            txDropped++;
+            return c;
+        }
+    }
     Serial.write(c);
     return c;
 }
 
 int serialGetchar(FILE *file) {
-    while (!Serial.available());
+    if (!Serial.available()) {
+        if (readTimeoutMs == SERIAL_READ_NONBLOCKING) {
+            return _FDEV_EOF;
+        }
+        unsigned long start = millis();
+        while (!Serial.available()) {
+            if (readTimeoutMs != SERIAL_READ_FOREVER && millis() - start >= readTimeoutMs) {
+                return _FDEV_EOF;
+            }
+            if (waitHook != nullptr) {
+                waitHook();
+            }
+        }
+    }
     int c = Serial.read();
     
     // Echo character back if echo is enabled
@@ -48,4 +74,24 @@ void initSerialStdio(unsigned long baudRate, bool echoEnabledParam) {
 
 void setSerialEcho(bool enabled) {
     echoEnabled = enabled;
+}
+
+void setSerialTxOverflow(SerialTxOverflow overflow) {
+    txOverflow = overflow;
+}
+
+uint16_t serialTxDropped() {
+    return txDropped;
+}
+
+uint16_t serialTxStalls() {
+    return txStalls;
+}
+
+void setSerialReadTimeout(unsigned long timeoutMs) {
+    readTimeoutMs = timeoutMs;
+}
+
+void setSerialWaitHook(void (*hook)()) {
+    waitHook = hook;
 }
\ No newline at end of file
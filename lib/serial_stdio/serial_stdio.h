@@ -3,10 +3,53 @@
 
 #include <Arduino.h>
 
+// getchar()/scanf() read timeouts for setSerialReadTimeout()
+#define SERIAL_READ_FOREVER     0xFFFFFFFFUL
+#define SERIAL_READ_NONBLOCKING 0UL
+
+// What putchar does when the core's TX buffer (SERIAL_TX_BUFFER_SIZE,
+// raise it with a build flag for long reports) is full
+enum SerialTxOverflow : uint8_t {
+    SERIAL_TX_BLOCK,    // Wait for the TX interrupt to free space (default)
+    SERIAL_TX_DROP      // Discard the character and count it
+};
+
 void initSerialStdio(unsigned long baudRate, bool echoEnabled = true);
 
 void setSerialEcho(bool enabled);
 
+/**
+ * How long getchar()/scanf() wait for input before returning EOF
+ * @param timeoutMs Milliseconds, SERIAL_READ_FOREVER (default) or
+ *                  SERIAL_READ_NONBLOCKING to return EOF at once when no
+ *                  byte is buffered
+ */
+void setSerialReadTimeout(unsigned long timeoutMs);
+
+/**
+ * Function called repeatedly while getchar() waits for input
+ *
+ * Arduino's Serial owns the RX interrupt, so the wait is a poll; in FreeRTOS
+ * sketches pass a hook that sleeps (e.g. vTaskDelay(1)) so the reading task
+ * stops starving lower-priority tasks. Sketches that can drop Serial should
+ * use serial_stdio_rtos instead, whose reader sleeps until the RX interrupt
+ * wakes it.
+ * @param hook Wait hook, nullptr to busy-wait (default)
+ */
+void setSerialWaitHook(void (*hook)());
+
+void setSerialTxOverflow(SerialTxOverflow overflow);
+
+/**
+ * Characters discarded by the SERIAL_TX_DROP policy
+ */
+uint16_t serialTxDropped();
+
+/**
+ * Writes that found the TX buffer full (waited or dropped)
+ */
+uint16_t serialTxStalls();
+
 int serialPutchar(char c, FILE *file);
 
 int serialGetchar(FILE *file);
@@ -0,0 +1,275 @@
+#include "serial_stdio_rtos.h"
+#include <semphr.h>
+
+static_assert((SERIAL_RTOS_RX_BUFFER_SIZE & (SERIAL_RTOS_RX_BUFFER_SIZE - 1)) == 0,
+              "SERIAL_RTOS_RX_BUFFER_SIZE must be a power of two");
+static_assert(SERIAL_RTOS_RX_BUFFER_SIZE <= 256, "SERIAL_RTOS_RX_BUFFER_SIZE must fit 8-bit indices");
+static_assert((SERIAL_RTOS_TX_BUFFER_SIZE & (SERIAL_RTOS_TX_BUFFER_SIZE - 1)) == 0,
+              "SERIAL_RTOS_TX_BUFFER_SIZE must be a power of two");
+static_assert(SERIAL_RTOS_TX_BUFFER_SIZE <= 256, "SERIAL_RTOS_TX_BUFFER_SIZE must fit 8-bit indices");
+
+constexpr uint8_t RX_INDEX_MASK = SERIAL_RTOS_RX_BUFFER_SIZE - 1;
+constexpr uint8_t TX_INDEX_MASK = SERIAL_RTOS_TX_BUFFER_SIZE - 1;
+
+static FILE serialStdio;
+static bool echoEnabled = true;
+static TickType_t readTimeout = SERIAL_RTOS_READ_FOREVER;
+
+// RX ring: the ISR only advances head, readers only advance tail
+static volatile uint8_t rxBuffer[SERIAL_RTOS_RX_BUFFER_SIZE];
+static volatile uint8_t rxHead = 0;
+static volatile uint8_t rxTail = 0;
+static volatile uint16_t rxOverruns = 0;
+static SemaphoreHandle_t rxSemaphore = nullptr;
+
+// TX ring: writers advance head with interrupts off (several tasks may
+// print), the UDRE interrupt advances tail
+static volatile uint8_t txBuffer[SERIAL_RTOS_TX_BUFFER_SIZE];
+static volatile uint8_t txHead = 0;
+static volatile uint8_t txTail = 0;
+static volatile uint16_t txDropped = 0;
+static volatile uint16_t txStalls = 0;
+static SerialRtosFlush txFlush = SERIAL_RTOS_FLUSH_NEWLINE;
+static SerialRtosOverflow txOverflow = SERIAL_RTOS_TX_BLOCK;
+
+// -----------------------------------------------------------------------------
+// USART0 low level
+// -----------------------------------------------------------------------------
+
+static void usartWrite(uint8_t value) {
+    while (!(UCSR0A & (1 << UDRE0))) {
+    }
+    UDR0 = value;
+}
+
+static inline void startTransmit() {
+    // The interrupt clears UDRIE0 again once the ring is empty
+    UCSR0B |= (1 << UDRIE0);
+}
+
+/**
+ * Send the oldest buffered byte by polling (interrupts are off, so the
+ * UDRE interrupt cannot make room)
+ */
+static void txDrainOne() {
+    uint8_t tail = txTail;
+    if (tail != txHead) {
+        usartWrite(txBuffer[tail]);
+        txTail = (tail + 1) & TX_INDEX_MASK;
+    }
+}
+
+/**
+ * Append one byte to the TX ring, applying the overflow policy
+ * @return false if the byte was dropped
+ */
+static bool txPut(uint8_t value) {
+    bool stalled = false;
+
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t head = txHead;
+        uint8_t next = (head + 1) & TX_INDEX_MASK;
+        if (next != txTail) {
+            txBuffer[head] = value;
+            txHead = next;
+            SREG = sreg;
+            return true;
+        }
+
+        if (txOverflow == SERIAL_RTOS_TX_DROP) {
+            txDropped++;
+            SREG = sreg;
+            return false;
+        }
+        if (!stalled) {
+            txStalls++;
+            stalled = true;
+        }
+        if (!(sreg & (1 << SREG_I))) {
+            // Called with interrupts disabled: make room by hand
+            txDrainOne();
+            SREG = sreg;
+            continue;
+        }
+        SREG = sreg;
+
+        // Full buffer goes out whatever the flush policy, then wait for room
+        startTransmit();
+        while (((txHead + 1) & TX_INDEX_MASK) == txTail) {
+        }
+    }
+}
+
+ISR(USART0_RX_vect) {
+    bool frameError = (UCSR0A & ((1 << FE0) | (1 << DOR0))) != 0;
+    uint8_t value = UDR0;
+
+    if (frameError) {
+        rxOverruns++;
+        return;
+    }
+
+    uint8_t next = (rxHead + 1) & RX_INDEX_MASK;
+    if (next == rxTail) {
+        rxOverruns++;
+        return;
+    }
+    rxBuffer[rxHead] = value;
+    rxHead = next;
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(rxSemaphore, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+ISR(USART0_UDRE_vect) {
+    uint8_t tail = txTail;
+    if (tail != txHead) {
+        UDR0 = txBuffer[tail];
+        tail = (tail + 1) & TX_INDEX_MASK;
+        txTail = tail;
+    }
+    if (tail == txHead) {
+        UCSR0B &= ~(1 << UDRIE0);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+int serialRtosPutchar(char c, FILE *file) {
+    (void) file;
+    // A dropped character is counted, not reported, so printf carries on
+    txPut(static_cast<uint8_t>(c));
+    if (txFlush == SERIAL_RTOS_FLUSH_IMMEDIATE || (txFlush == SERIAL_RTOS_FLUSH_NEWLINE && c == '\n')) {
+        startTransmit();
+    }
+    return c;
+}
+
+void serialRtosFlush() {
+    if (txTail != txHead) {
+        startTransmit();
+    }
+}
+
+void setSerialRtosTxPolicy(SerialRtosFlush flush, SerialRtosOverflow overflow) {
+    txFlush = flush;
+    txOverflow = overflow;
+}
+
+uint16_t serialRtosTxDropped() {
+    noInterrupts();
+    uint16_t dropped = txDropped;
+    interrupts();
+    return dropped;
+}
+
+uint16_t serialRtosTxStalls() {
+    noInterrupts();
+    uint16_t stalls = txStalls;
+    interrupts();
+    return stalls;
+}
+
+uint8_t serialRtosAvailable() {
+    return (rxHead - rxTail) & RX_INDEX_MASK;
+}
+
+int serialRtosRead() {
+    uint8_t tail = rxTail;
+    if (tail == rxHead) {
+        return EOF;
+    }
+    int c = rxBuffer[tail];
+    rxTail = (tail + 1) & RX_INDEX_MASK;
+
+    // Echo character back if echo is enabled, behind any buffered output
+    if (echoEnabled) {
+        if (c == '\b' || c == 127) {
+            // Backspace-space-backspace erases the character visually
+            txPut('\b');
+            txPut(' ');
+            txPut('\b');
+        } else {
+            txPut(static_cast<uint8_t>(c));
+        }
+        startTransmit();
+    }
+
+    return c;
+}
+
+bool serialRtosWaitForData(TickType_t timeout) {
+    // The semaphore may lag behind the buffer (several bytes, one give),
+    // so the buffer itself is the source of truth; a stale give must not
+    // restart the wait from scratch
+    TimeOut_t timeOut;
+    vTaskSetTimeOutState(&timeOut);
+
+    // Whoever waits for input has usually just printed a prompt
+    serialRtosFlush();
+
+    while (serialRtosAvailable() == 0) {
+        if (xTaskCheckForTimeOut(&timeOut, &timeout) == pdTRUE) {
+            return false;
+        }
+        if (xSemaphoreTake(rxSemaphore, timeout) != pdTRUE) {
+            return serialRtosAvailable() > 0;
+        }
+    }
+    return true;
+}
+
+int serialRtosGetchar(FILE *file) {
+    (void) file;
+    if (readTimeout == SERIAL_RTOS_READ_NONBLOCKING) {
+        int c = serialRtosRead();
+        return c == EOF ? _FDEV_EOF : c;
+    }
+    if (!serialRtosWaitForData(readTimeout)) {
+        return _FDEV_EOF;
+    }
+    return serialRtosRead();
+}
+
+void setSerialRtosReadTimeout(TickType_t timeout) {
+    readTimeout = timeout;
+}
+
+uint16_t serialRtosOverruns() {
+    noInterrupts();
+    uint16_t overruns = rxOverruns;
+    interrupts();
+    return overruns;
+}
+
+void initSerialStdioRtos(unsigned long baudRate, bool echoEnabledParam) {
+    echoEnabled = echoEnabledParam;
+    rxSemaphore = xSemaphoreCreateBinary();
+
+    // Double speed mode, same divisor rounding as the Arduino core
+    uint16_t ubrr = static_cast<uint16_t>((F_CPU / 4 / baudRate - 1) / 2);
+    UCSR0A = (1 << U2X0);
+    UBRR0H = static_cast<uint8_t>(ubrr >> 8);
+    UBRR0L = static_cast<uint8_t>(ubrr & 0xFF);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);  // 8N1
+    UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
+
+    // Set up new streams for stdin/stdout
+    fdev_setup_stream(&serialStdio, serialRtosPutchar, serialRtosGetchar, _FDEV_SETUP_RW);
+
+    // Redirect stdin/stdout/stderr to our new streams
+    stdout = &serialStdio;
+    stdin = &serialStdio;
+    stderr = &serialStdio;
+}
+
+void setSerialRtosEcho(bool enabled) {
+    echoEnabled = enabled;
+}
@@ -0,0 +1,123 @@
+#ifndef SERIAL_STDIO_RTOS_H
+#define SERIAL_STDIO_RTOS_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+
+/**
+ * Interrupt-driven serial stdio for FreeRTOS labs
+ *
+ * Drives USART0 directly: the RX interrupt stores bytes in a ring buffer and
+ * wakes a waiting task through a semaphore, so a task can sleep until input
+ * arrives and then drain everything at once instead of polling.
+ *
+ * Output is buffered the same way: putchar only copies into a TX ring that
+ * the UDRE interrupt drains, so printf returns after a few microseconds per
+ * character instead of waiting for the wire. Buffered output starts sending
+ * at the end of each line (default), on every character, or only when
+ * serialRtosFlush() is called; reads flush first so prompts always appear.
+ *
+ * This owns the USART0 interrupt vectors, so a sketch using it must not
+ * reference Arduino's Serial object (or serial_stdio), otherwise the link
+ * fails with duplicate vector definitions.
+ */
+
+// RX ring buffer size (power of two, at most 256)
+#ifndef SERIAL_RTOS_RX_BUFFER_SIZE
+#define SERIAL_RTOS_RX_BUFFER_SIZE 64
+#endif
+
+// TX ring buffer size (power of two, at most 256)
+#ifndef SERIAL_RTOS_TX_BUFFER_SIZE
+#define SERIAL_RTOS_TX_BUFFER_SIZE 128
+#endif
+
+// When buffered output starts going out
+enum SerialRtosFlush : uint8_t {
+    SERIAL_RTOS_FLUSH_IMMEDIATE,    // Every character
+    SERIAL_RTOS_FLUSH_NEWLINE,      // On '\n', a full buffer or a read (default)
+    SERIAL_RTOS_FLUSH_MANUAL        // On serialRtosFlush(), a full buffer or a read
+};
+
+// What putchar does when the TX ring is full
+enum SerialRtosOverflow : uint8_t {
+    SERIAL_RTOS_TX_BLOCK,           // Wait for the interrupt to free space (default)
+    SERIAL_RTOS_TX_DROP             // Discard the character and count it
+};
+
+// getchar()/scanf() read timeouts for setSerialRtosReadTimeout()
+#define SERIAL_RTOS_READ_FOREVER     portMAX_DELAY
+#define SERIAL_RTOS_READ_NONBLOCKING 0
+
+void initSerialStdioRtos(unsigned long baudRate, bool echoEnabled = true);
+
+void setSerialRtosEcho(bool enabled);
+
+/**
+ * How long getchar()/scanf() on the stream sleep waiting for input
+ *
+ * The reading task blocks on the RX semaphore, so waiting costs no CPU.
+ * When the timeout expires with nothing received the read returns EOF
+ * (scanf() returns EOF or a short count); the stream stays usable and the
+ * next read waits again.
+ * @param timeout Ticks to wait, SERIAL_RTOS_READ_FOREVER (default) or
+ *                SERIAL_RTOS_READ_NONBLOCKING to return EOF at once when
+ *                the buffer is empty
+ */
+void setSerialRtosReadTimeout(TickType_t timeout);
+
+/**
+ * Choose when buffered output is sent and what happens when the buffer is full
+ */
+void setSerialRtosTxPolicy(SerialRtosFlush flush, SerialRtosOverflow overflow);
+
+/**
+ * Start sending everything buffered (returns immediately)
+ */
+void serialRtosFlush();
+
+/**
+ * Characters discarded by the SERIAL_RTOS_TX_DROP policy
+ */
+uint16_t serialRtosTxDropped();
+
+/**
+ * Writes that had to wait for space under the SERIAL_RTOS_TX_BLOCK policy
+ */
+uint16_t serialRtosTxStalls();
+
+/**
+ * Block until received data is available
+ * @param timeout Ticks to wait (portMAX_DELAY to wait forever)
+ * @return true if at least one byte can be read
+ */
+bool serialRtosWaitForData(TickType_t timeout);
+
+/**
+ * Number of buffered received bytes
+ */
+uint8_t serialRtosAvailable();
+
+/**
+ * Read one buffered byte without blocking (echoed if echo is enabled)
+ * @return Byte value or EOF if the buffer is empty
+ */
+int serialRtosRead();
+
+/**
+ * Bytes lost because the RX buffer was full or the UART overran
+ */
+uint16_t serialRtosOverruns();
+
+/**
+ * Stream putchar: queues the character for the UDRE interrupt
+ */
+int serialRtosPutchar(char c, FILE *file);
+
+/**
+ * Stream getchar: sleeps up to the read timeout, then reads one byte
+ * @return Byte value or _FDEV_EOF on timeout
+ */
+int serialRtosGetchar(FILE *file);
+
+#endif
@@ -0,0 +1,137 @@
+#include "stdio_mux.h"
+#include <semphr.h>
+#include <task.h>
+#include <string.h>
+
+struct MuxLine {
+    TaskHandle_t owner;
+    bool claimed;
+    uint8_t length;
+    char text[STDIO_MUX_LINE_SIZE];
+};
+
+static FILE muxStream;
+static FILE *sinkStream = nullptr;
+static SemaphoreHandle_t sinkMutex = nullptr;
+static MuxLine lines[STDIO_MUX_MAX_TASKS];
+static uint16_t splitLines = 0;
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+
+static bool schedulerStarted() {
+#if (INCLUDE_xTaskGetSchedulerState == 1) || (configUSE_TIMERS == 1)
+    return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+#else
+    // The tick count only advances once the scheduler runs
+    return xTaskGetTickCount() != 0;
+#endif
+}
+
+/**
+ * Line buffer of the calling task, claiming a free one on first use
+ * @return nullptr if every buffer belongs to another task or the scheduler
+ *         has not started
+ */
+static MuxLine* currentLine() {
+    // Before the scheduler starts setup() is alone and needs no buffer. The
+    // current-task handle cannot tell: xTaskCreate() already points it at
+    // the highest-priority task created so far
+    if (!schedulerStarted()) {
+        return nullptr;
+    }
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+
+    // Only the owner ever matches its own slot, so the lookup needs no lock
+    for (uint8_t i = 0; i < STDIO_MUX_MAX_TASKS; i++) {
+        if (lines[i].claimed && lines[i].owner == self) {
+            return &lines[i];
+        }
+    }
+
+    MuxLine* line = nullptr;
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < STDIO_MUX_MAX_TASKS; i++) {
+        if (!lines[i].claimed) {
+            lines[i].claimed = true;
+            lines[i].owner = self;
+            lines[i].length = 0;
+            line = &lines[i];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return line;
+}
+
+static void writeToSink(const char *text, size_t length) {
+    xSemaphoreTake(sinkMutex, portMAX_DELAY);
+    for (size_t i = 0; i < length; i++) {
+        fputc(text[i], sinkStream);
+    }
+    xSemaphoreGive(sinkMutex);
+}
+
+static void commitLine(MuxLine *line) {
+    if (line->length > 0) {
+        writeToSink(line->text, line->length);
+        line->length = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+int stdioMuxPutchar(char c, FILE *file) {
+    (void) file;
+
+    MuxLine *line = currentLine();
+    if (line == nullptr) {
+        writeToSink(&c, 1);
+        return c;
+    }
+
+    line->text[line->length++] = c;
+    if (c == '\n') {
+        commitLine(line);
+    } else if (line->length == STDIO_MUX_LINE_SIZE) {
+        taskENTER_CRITICAL();
+        splitLines++;
+        taskEXIT_CRITICAL();
+        commitLine(line);
+    }
+    return c;
+}
+
+void stdioMuxFlush() {
+    MuxLine *line = currentLine();
+    if (line != nullptr) {
+        commitLine(line);
+    }
+}
+
+void stdioMuxWrite(const char *data, size_t length) {
+    writeToSink(data, length);
+}
+
+uint16_t stdioMuxSplitLines() {
+    return splitLines;
+}
+
+bool initStdioMux(FILE *sink) {
+    sinkMutex = xSemaphoreCreateMutex();
+    if (sinkMutex == nullptr) {
+        return false;
+    }
+    sinkStream = sink;
+    memset(lines, 0, sizeof(lines));
+
+    fdev_setup_stream(&muxStream, stdioMuxPutchar, nullptr, _FDEV_SETUP_WRITE);
+
+    // Input stays on the sink's stream
+    stdout = &muxStream;
+    stderr = &muxStream;
+    return true;
+}
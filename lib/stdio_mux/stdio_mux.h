@@ -0,0 +1,57 @@
+#ifndef STDIO_MUX_H
+#define STDIO_MUX_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+
+/**
+ * Line-atomic stdout for several FreeRTOS tasks
+ *
+ * Each task printing through stdout gets its own line buffer (found by its
+ * task handle); characters collect there without any locking, and only a
+ * finished line is copied to the shared sink, under a mutex. Lines from
+ * different tasks therefore never interleave, and a task blocked in a slow
+ * printf does not hold up the others.
+ *
+ * A line is committed on '\n', when its buffer fills up (the rest follows
+ * as a new line), or on stdioMuxFlush(). Tasks beyond STDIO_MUX_MAX_TASKS
+ * write straight to the sink one character at a time.
+ */
+
+// Tasks that get a line buffer (slots are claimed on first output and
+// kept for the task's lifetime)
+#ifndef STDIO_MUX_MAX_TASKS
+#define STDIO_MUX_MAX_TASKS 4
+#endif
+
+// Longest line committed in one piece
+#ifndef STDIO_MUX_LINE_SIZE
+#define STDIO_MUX_LINE_SIZE 80
+#endif
+
+/**
+ * Route stdout and stderr through the multiplexer
+ * @param sink Shared output stream (typically the current stdout, e.g. after initSerialStdio())
+ * @return false if the sink mutex could not be created
+ */
+bool initStdioMux(FILE *sink);
+
+/**
+ * Commit the calling task's partial line (e.g. a prompt without newline)
+ */
+void stdioMuxFlush();
+
+/**
+ * Write a block to the sink in one piece, bypassing the line buffers
+ * (e.g. binary frames that may contain '\n' bytes)
+ */
+void stdioMuxWrite(const char *data, size_t length);
+
+/**
+ * Lines split because they exceeded STDIO_MUX_LINE_SIZE
+ */
+uint16_t stdioMuxSplitLines();
+
+int stdioMuxPutchar(char c, FILE *file);
+
+#endif
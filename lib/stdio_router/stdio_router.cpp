@@ -0,0 +1,242 @@
+#include "stdio_router.h"
+#include <task.h>
+#include <string.h>
+
+struct RouterSink {
+    StdioSinkConfig config;
+    uint16_t head;              // Ring indices and fill, changed in critical sections
+    uint16_t tail;
+    uint16_t used;
+    uint16_t dropped;
+    TaskHandle_t task;          // Drained sinks only
+};
+
+static RouterSink sinks[STDIO_ROUTER_MAX_SINKS];
+static uint8_t sinkCount = 0;
+
+// -----------------------------------------------------------------------------
+// Internal helpers
+// -----------------------------------------------------------------------------
+static bool isDirect(const RouterSink* sink) {
+    return sink->config.buffer == nullptr;
+}
+
+static bool isLog(const RouterSink* sink) {
+    return sink->config.write == nullptr;
+}
+
+/**
+ * Pass a block to the sink callback, expanding '\n' for CRLF sinks
+ */
+static void emit(RouterSink* sink, const char* data, size_t length) {
+    StdioSinkWrite write = sink->config.write;
+    void* context = sink->config.context;
+
+    if ((sink->config.flags & STDIO_SINK_CRLF) == 0) {
+        write(data, length, context);
+        return;
+    }
+
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == '\n') {
+            if (i > start) {
+                write(&data[start], i - start, context);
+            }
+            write("\r\n", 2, context);
+            start = i + 1;
+        }
+    }
+    if (start < length) {
+        write(&data[start], length - start, context);
+    }
+}
+
+/**
+ * Append one byte (inside a critical section)
+ * @return true if the ring was empty before
+ */
+static bool ringPut(RouterSink* sink, char c) {
+    uint16_t size = sink->config.size;
+    if (sink->used == size) {
+        if (!isLog(sink)) {
+            sink->dropped++;
+            return false;
+        }
+        // Log sinks keep the newest output
+        sink->tail = sink->tail + 1 == size ? 0 : sink->tail + 1;
+        sink->used--;
+    }
+
+    sink->config.buffer[sink->head] = c;
+    sink->head = sink->head + 1 == size ? 0 : sink->head + 1;
+    sink->used++;
+    return sink->used == 1;
+}
+
+/**
+ * Remove up to maxLength bytes (inside a critical section)
+ */
+static uint16_t ringTake(RouterSink* sink, char* out, uint16_t maxLength) {
+    uint16_t size = sink->config.size;
+    uint16_t count = 0;
+    while (count < maxLength && sink->used > 0) {
+        out[count++] = sink->config.buffer[sink->tail];
+        sink->tail = sink->tail + 1 == size ? 0 : sink->tail + 1;
+        sink->used--;
+    }
+    return count;
+}
+
+static void drainTask(void* pvParameters) {
+    RouterSink* sink = static_cast<RouterSink*>(pvParameters);
+    char chunk[STDIO_ROUTER_CHUNK_SIZE];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint16_t budget = sink->config.burst > 0 ? sink->config.burst : UINT16_MAX;
+        bool wrote = false;
+        while (budget > 0) {
+            uint16_t length = budget < sizeof(chunk) ? budget : sizeof(chunk);
+            taskENTER_CRITICAL();
+            length = ringTake(sink, chunk, length);
+            taskEXIT_CRITICAL();
+            if (length == 0) {
+                break;
+            }
+            emit(sink, chunk, length);
+            budget -= length;
+            wrote = true;
+        }
+        if (wrote && sink->config.drained != nullptr) {
+            sink->config.drained(sink->config.context);
+        }
+
+        if (sink->config.period > 0) {
+            vTaskDelay(sink->config.period);
+        }
+
+        // Output over the burst limit or written during the delay: writers
+        // only notify when the ring goes from empty to non-empty
+        taskENTER_CRITICAL();
+        bool pending = sink->used > 0;
+        taskEXIT_CRITICAL();
+        if (pending) {
+            xTaskNotifyGive(sink->task);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+int8_t stdioRouterAddSink(const StdioSinkConfig* config) {
+    if (sinkCount >= STDIO_ROUTER_MAX_SINKS || config == nullptr) {
+        return -1;
+    }
+    if (config->buffer == nullptr ? config->write == nullptr : config->size == 0) {
+        return -1;
+    }
+
+    RouterSink* sink = &sinks[sinkCount];
+    sink->config = *config;
+    sink->head = 0;
+    sink->tail = 0;
+    sink->used = 0;
+    sink->dropped = 0;
+    sink->task = nullptr;
+
+    if (!isDirect(sink) && !isLog(sink)) {
+        if (xTaskCreate(drainTask, "Sink", config->stackDepth, sink,
+                        config->priority, &sink->task) != pdPASS) {
+            return -1;
+        }
+    }
+    return static_cast<int8_t>(sinkCount++);
+}
+
+void stdioRouterOpen(FILE* stream, uint8_t routes) {
+    fdev_setup_stream(stream, stdioRouterPutchar, nullptr, _FDEV_SETUP_WRITE);
+    fdev_set_udata(stream, reinterpret_cast<void*>(static_cast<uintptr_t>(routes)));
+}
+
+void stdioRouterWrite(uint8_t routes, const char* data, size_t length) {
+    for (uint8_t i = 0; i < sinkCount; i++) {
+        if ((routes & STDIO_ROUTE(i)) == 0) {
+            continue;
+        }
+
+        RouterSink* sink = &sinks[i];
+        if (isDirect(sink)) {
+            emit(sink, data, length);
+            continue;
+        }
+
+        // Short critical sections keep interrupt latency bounded for long blocks
+        bool wake = false;
+        for (size_t start = 0; start < length; start += STDIO_ROUTER_CHUNK_SIZE) {
+            size_t end = start + STDIO_ROUTER_CHUNK_SIZE < length ? start + STDIO_ROUTER_CHUNK_SIZE : length;
+            taskENTER_CRITICAL();
+            for (size_t j = start; j < end; j++) {
+                wake |= ringPut(sink, data[j]);
+            }
+            taskEXIT_CRITICAL();
+        }
+        if (wake && sink->task != nullptr) {
+            xTaskNotifyGive(sink->task);
+        }
+    }
+}
+
+void stdioRouterDumpLog(int8_t sink, FILE* out) {
+    if (sink < 0 || sink >= sinkCount || isDirect(&sinks[sink])) {
+        return;
+    }
+
+    RouterSink* log = &sinks[sink];
+    bool crlf = (log->config.flags & STDIO_SINK_CRLF) != 0;
+    char chunk[STDIO_ROUTER_CHUNK_SIZE];
+
+    // Copied in pieces; output arriving meanwhile may shift the window
+    for (uint16_t offset = 0;;) {
+        uint8_t length = 0;
+        taskENTER_CRITICAL();
+        while (length < sizeof(chunk) && offset < log->used) {
+            uint16_t index = log->tail + offset;
+            if (index >= log->config.size) {
+                index -= log->config.size;
+            }
+            chunk[length++] = log->config.buffer[index];
+            offset++;
+        }
+        taskEXIT_CRITICAL();
+
+        if (length == 0) {
+            break;
+        }
+        for (uint8_t i = 0; i < length; i++) {
+            if (crlf && chunk[i] == '\n') {
+                fputc('\r', out);
+            }
+            fputc(chunk[i], out);
+        }
+    }
+}
+
+uint16_t stdioRouterDropped(int8_t sink) {
+    if (sink < 0 || sink >= sinkCount) {
+        return 0;
+    }
+    taskENTER_CRITICAL();
+    uint16_t dropped = sinks[sink].dropped;
+    taskEXIT_CRITICAL();
+    return dropped;
+}
+
+int stdioRouterPutchar(char c, FILE* file) {
+    uint8_t routes = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(fdev_get_udata(file)));
+    stdioRouterWrite(routes, &c, 1);
+    return c;
+}
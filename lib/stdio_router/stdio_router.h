@@ -0,0 +1,98 @@
+#ifndef STDIO_ROUTER_H
+#define STDIO_ROUTER_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+
+/**
+ * Fan-out of formatted stdio output to several sinks
+ *
+ * Output is formatted once (fprintf on a router stream, or
+ * stdioRouterWrite()) and the resulting bytes are copied into every sink
+ * the stream routes to. Each sink has its own ring buffer, drained by its
+ * own task at its own pace:
+ *   - a drained sink (serial, LCD, ...) gets a task that writes buffered
+ *     output through the sink callback, optionally rate limited to one
+ *     burst per period; when its ring is full new output for that sink is
+ *     dropped and counted, other sinks are unaffected
+ *   - a direct sink (no buffer) is written from the caller, for sinks that
+ *     buffer on their own (e.g. serial_stdio_rtos)
+ *   - a log sink (no callback) keeps the most recent output, overwriting the
+ *     oldest, until it is dumped with stdioRouterDumpLog()
+ * A slow sink such as the I2C LCD therefore never holds up the caller or
+ * the other sinks.
+ *
+ * Bytes from different tasks are not grouped into lines; put stdio_mux in
+ * front of a router stream if tasks share one.
+ */
+
+#ifndef STDIO_ROUTER_MAX_SINKS
+#define STDIO_ROUTER_MAX_SINKS 4
+#endif
+
+// Bytes taken out of a ring per sink callback
+#ifndef STDIO_ROUTER_CHUNK_SIZE
+#define STDIO_ROUTER_CHUNK_SIZE 16
+#endif
+
+// Route mask bit of a sink ID
+#define STDIO_ROUTE(sink) (1U << (sink))
+
+enum StdioSinkFlags : uint8_t {
+    STDIO_SINK_CRLF = 0x01      // Write '\n' as "\r\n"
+};
+
+/**
+ * Sink output callback (called from the sink task, or the caller for direct sinks)
+ */
+typedef void (*StdioSinkWrite)(const char* data, size_t length, void* context);
+
+/**
+ * End-of-pass callback for drained sinks, e.g. to push a display frame out
+ */
+typedef void (*StdioSinkDrained)(void* context);
+
+struct StdioSinkConfig {
+    StdioSinkWrite write;       // nullptr: log sink
+    void* context;
+    char* buffer;               // nullptr: direct sink (write is required)
+    uint16_t size;
+    TickType_t period;          // Minimum ticks between drains (0: drain as soon as data arrives)
+    uint16_t burst;             // Bytes written per drain (0: everything buffered)
+    uint8_t flags;              // StdioSinkFlags
+    UBaseType_t priority;       // Drain task (drained sinks only)
+    uint16_t stackDepth;
+    StdioSinkDrained drained;   // Optional, after each drain pass that wrote output
+};
+
+/**
+ * Add a sink
+ * @return Sink ID for STDIO_ROUTE(), or -1 if the table is full, the
+ *         configuration is invalid or the drain task could not be created
+ */
+int8_t stdioRouterAddSink(const StdioSinkConfig* config);
+
+/**
+ * Turn a caller-owned FILE into a write stream routed to a set of sinks
+ * @param routes STDIO_ROUTE() bits, e.g. STDIO_ROUTE(serial) | STDIO_ROUTE(log)
+ */
+void stdioRouterOpen(FILE* stream, uint8_t routes);
+
+/**
+ * Write a block to a set of sinks
+ */
+void stdioRouterWrite(uint8_t routes, const char* data, size_t length);
+
+/**
+ * Write the retained text of a log sink, oldest first
+ */
+void stdioRouterDumpLog(int8_t sink, FILE* out);
+
+/**
+ * Bytes a drained sink dropped because its ring was full
+ */
+uint16_t stdioRouterDropped(int8_t sink);
+
+int stdioRouterPutchar(char c, FILE* file);
+
+#endif
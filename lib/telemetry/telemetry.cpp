@@ -0,0 +1,289 @@
+#include "telemetry.h"
+#include "frame_codec.h"
+#include <task.h>
+
+// Sample frame header: kind u8 | firstSample u32 | count u8
+static const uint8_t SAMPLE_HEADER_SIZE = 6;
+
+// Descriptor header: kind u8 | version u8 | periodUs u32 | channelCount u8
+static const uint8_t DESCRIPTOR_HEADER_SIZE = 7;
+
+// Ring slot: sample number u32 | values
+static const uint8_t SLOT_HEADER_SIZE = 4;
+
+// Timer2 clock selects (CS22:0) and the divider each one applies to F_CPU
+struct TimerPrescaler {
+    uint16_t divider;
+    uint8_t clockSelect;
+};
+
+static const TimerPrescaler PRESCALERS[] = {
+    {1, 1}, {8, 2}, {32, 3}, {64, 4}, {128, 5}, {256, 6}, {1024, 7}
+};
+static const uint8_t PRESCALER_COUNT = sizeof(PRESCALERS) / sizeof(PRESCALERS[0]);
+
+// Longest Timer2 period: 256 counts at clk/1024 (16.4 ms at 16 MHz)
+static const uint32_t TIMER_MAX_CYCLES = 256UL * 1024;
+
+struct TelemetryChannel {
+    const char* name;
+    const volatile uint8_t* source;
+    uint8_t size;
+    TelemetryType type;
+};
+
+static TelemetryChannel channels[TELEMETRY_MAX_CHANNELS];
+static uint8_t channelCount = 0;
+static uint8_t sampleSize = 0;
+static uint16_t descriptorSize = DESCRIPTOR_HEADER_SIZE;
+
+// The ISR is the only writer (head), the streaming task the only reader (tail)
+static uint8_t ring[TELEMETRY_BUFFER_SIZE];
+static uint8_t slotSize = 0;
+static uint16_t slotCount = 0;
+static volatile uint16_t ringHead = 0;
+static volatile uint16_t ringTail = 0;
+static volatile uint32_t sampleNumber = 0;
+static volatile uint16_t droppedSamples = 0;
+
+static volatile bool running = false;
+static uint32_t periodUs = 0;
+
+// Timer2 is 8-bit; slow rates take a sample every postscale compare matches
+static uint8_t postscale = 1;
+static uint8_t postscaleCount = 1;
+static TelemetryWrite frameWrite = nullptr;
+static void* frameContext = nullptr;
+
+// Staging buffers of the streaming task; static to keep them off its stack
+static uint8_t payload[TELEMETRY_FRAME_PAYLOAD];
+static uint8_t frame[FRAME_MAX_ENCODED(TELEMETRY_FRAME_PAYLOAD)];
+
+static uint8_t typeSize(TelemetryType type) {
+    switch (type) {
+        case TELEMETRY_U8:
+        case TELEMETRY_I8:
+            return 1;
+        case TELEMETRY_U16:
+        case TELEMETRY_I16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Sampling
+// -----------------------------------------------------------------------------
+
+/**
+ * Copy every channel into the next ring slot (interrupts off)
+ */
+static inline void takeSample() {
+    uint32_t number = sampleNumber++;
+    uint16_t head = ringHead;
+    uint16_t next = head + 1 == slotCount ? 0 : head + 1;
+    if (next == ringTail) {
+        droppedSamples++;
+        return;
+    }
+
+    uint8_t* slot = &ring[head * slotSize];
+    memcpy(slot, &number, SLOT_HEADER_SIZE);
+    slot += SLOT_HEADER_SIZE;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        const volatile uint8_t* source = channels[i].source;
+        for (uint8_t b = 0; b < channels[i].size; b++) {
+            *slot++ = source[b];
+        }
+    }
+    ringHead = next;
+}
+
+ISR(TIMER2_COMPA_vect) {
+    if (--postscaleCount != 0) {
+        return;
+    }
+    postscaleCount = postscale;
+    takeSample();
+}
+
+static void startTimer(uint16_t ticks, uint8_t clockSelect) {
+    uint8_t sreg = SREG;
+    cli();
+    TCCR2A = 0;
+    TCCR2B = 0;
+    TCNT2 = 0;
+    OCR2A = static_cast<uint8_t>(ticks - 1);
+    postscaleCount = postscale;
+    TIFR2 = (1 << OCF2A);
+    TIMSK2 |= (1 << OCIE2A);
+    TCCR2A = (1 << WGM21);                              // CTC on OCR2A
+    TCCR2B = clockSelect;
+    SREG = sreg;
+}
+
+// -----------------------------------------------------------------------------
+// Streaming
+// -----------------------------------------------------------------------------
+static void sendFrame(size_t length) {
+    frameWrite(frame, frame_encode(payload, length, frame), frameContext);
+}
+
+static void sendDescriptor() {
+    size_t length = 0;
+    payload[length++] = 'D';
+    payload[length++] = TELEMETRY_FORMAT_VERSION;
+    memcpy(&payload[length], &periodUs, sizeof(periodUs));
+    length += sizeof(periodUs);
+    payload[length++] = channelCount;
+
+    for (uint8_t i = 0; i < channelCount; i++) {
+        uint8_t nameLength = static_cast<uint8_t>(strlen(channels[i].name));
+        payload[length++] = channels[i].type;
+        payload[length++] = nameLength;
+        memcpy(&payload[length], channels[i].name, nameLength);
+        length += nameLength;
+    }
+    sendFrame(length);
+}
+
+/**
+ * Pack every buffered sample into as few frames as fit
+ */
+static void sendSamples() {
+    size_t length = 0;
+    uint8_t count = 0;
+    uint32_t previous = 0;
+
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t head = ringHead;
+        SREG = sreg;
+
+        uint16_t tail = ringTail;
+        if (tail == head) {
+            break;
+        }
+
+        const uint8_t* slot = &ring[tail * slotSize];
+        uint32_t number;
+        memcpy(&number, slot, SLOT_HEADER_SIZE);
+
+        // A gap wider than one step byte starts a new frame
+        bool full = length + 1 + sampleSize > TELEMETRY_FRAME_PAYLOAD;
+        if (count > 0 && (full || number - previous > 0xFF || count == 0xFF)) {
+            payload[SAMPLE_HEADER_SIZE - 1] = count;
+            sendFrame(length);
+            count = 0;
+        }
+        if (count == 0) {
+            payload[0] = 'S';
+            memcpy(&payload[1], &number, sizeof(number));
+            length = SAMPLE_HEADER_SIZE;
+            previous = number;
+        }
+
+        payload[length++] = static_cast<uint8_t>(number - previous);
+        memcpy(&payload[length], slot + SLOT_HEADER_SIZE, sampleSize);
+        length += sampleSize;
+        previous = number;
+        count++;
+
+        ringTail = tail + 1 == slotCount ? 0 : tail + 1;
+    }
+
+    if (count > 0) {
+        payload[SAMPLE_HEADER_SIZE - 1] = count;
+        sendFrame(length);
+    }
+}
+
+static void telemetryTask(void* pvParameters) {
+    (void) pvParameters;
+    TickType_t lastWakeTime = xTaskGetTickCount();
+    uint32_t lastDescriptor = millis();
+
+    sendDescriptor();
+    for (;;) {
+        if (millis() - lastDescriptor >= TELEMETRY_DESCRIPTOR_PERIOD_MS) {
+            lastDescriptor = millis();
+            sendDescriptor();
+        }
+        sendSamples();
+        vTaskDelayUntil(&lastWakeTime, 1);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool telemetry_register(const char* name, const volatile void* source, TelemetryType type) {
+    if (running || channelCount >= TELEMETRY_MAX_CHANNELS || name == nullptr || source == nullptr) {
+        return false;
+    }
+
+    uint8_t size = typeSize(type);
+    size_t nameLength = strlen(name);
+    if (nameLength > 0xFF
+        || descriptorSize + 2 + nameLength > TELEMETRY_FRAME_PAYLOAD
+        || SAMPLE_HEADER_SIZE + 1 + sampleSize + size > TELEMETRY_FRAME_PAYLOAD
+        || SLOT_HEADER_SIZE + sampleSize + size > TELEMETRY_BUFFER_SIZE / 2) {
+        return false;
+    }
+
+    TelemetryChannel& channel = channels[channelCount++];
+    channel.name = name;
+    channel.source = static_cast<const volatile uint8_t*>(source);
+    channel.size = size;
+    channel.type = type;
+    sampleSize += size;
+    descriptorSize += 2 + nameLength;
+    return true;
+}
+
+bool telemetry_start(uint16_t rateHz, TelemetryWrite write, void* context,
+                     UBaseType_t priority, uint16_t stackDepth) {
+    if (running || channelCount == 0 || write == nullptr || rateHz < 4 || rateHz > 10000) {
+        return false;
+    }
+
+    // Fewest compare matches per sample, then the finest prescaler that
+    // fits one match period in 256 counts
+    uint32_t cycles = (F_CPU + rateHz / 2) / rateHz;
+    postscale = static_cast<uint8_t>((cycles + TIMER_MAX_CYCLES - 1) / TIMER_MAX_CYCLES);
+    cycles /= postscale;
+    uint8_t p = 0;
+    while (p < PRESCALER_COUNT - 1 && cycles > 256UL * PRESCALERS[p].divider) {
+        p++;
+    }
+    uint32_t divider = PRESCALERS[p].divider;
+    uint32_t ticks = (cycles + divider / 2) / divider;
+    periodUs = ticks * divider * postscale / (F_CPU / 1000000UL);
+    frameWrite = write;
+    frameContext = context;
+
+    slotSize = SLOT_HEADER_SIZE + sampleSize;
+    slotCount = TELEMETRY_BUFFER_SIZE / slotSize;
+    ringHead = 0;
+    ringTail = 0;
+    sampleNumber = 0;
+    droppedSamples = 0;
+
+    if (xTaskCreate(telemetryTask, "Telemetry", stackDepth, nullptr, priority, nullptr) != pdPASS) {
+        return false;
+    }
+    running = true;
+    startTimer(static_cast<uint16_t>(ticks), PRESCALERS[p].clockSelect);
+    return true;
+}
+
+uint16_t telemetry_dropped() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t dropped = droppedSamples;
+    SREG = sreg;
+    return dropped;
+}
@@ -0,0 +1,127 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <Arduino_FreeRTOS.h>
+#include <stdint.h>
+
+/**
+ * Fixed-rate binary telemetry
+ *
+ * Tasks register the variables they already update (ADC readings, filter
+ * outputs, motor power, servo angle, ...); nothing changes in the tasks
+ * themselves. Timer2 fires at the configured rate and its ISR copies every
+ * registered variable into a RAM ring as one sample. A low-priority task
+ * packs buffered samples into frame_codec frames and hands them to a
+ * write callback, so control tasks never wait for the serial port.
+ *
+ * Sample times follow from the sample number: sample n was taken n timer
+ * periods after telemetry_start(), and each sample carries its number so
+ * the host sees samples lost to a full ring. tools/telemetry_decode.py
+ * turns a capture into CSV; frames are 0x00-delimited with a CRC, so text
+ * output can share the port.
+ *
+ * Values are read by the ISR without locking; a 16/32-bit value that a task
+ * is halfway through storing can show up torn in a single sample.
+ *
+ * This owns the Timer2 compare interrupt, so tone() and PWM on pins 9 and
+ * 10 are unavailable while telemetry runs. The 16-bit timers are not an
+ * option: on the Mega the Servo library defines the compare ISRs of Timers
+ * 5, 1, 3 and 4, and linking it next to another handler for any of them
+ * fails. Timer2 is 8-bit, so rates below ~61 Hz sample every few compare
+ * matches; periodUs in the descriptor is the exact period achieved.
+ *
+ * Frame payloads (little-endian):
+ *   Descriptor (at start, then every TELEMETRY_DESCRIPTOR_PERIOD_MS):
+ *     'D' | version u8 | periodUs u32 | channelCount u8
+ *     per channel: type u8 | nameLen u8 | name
+ *   Samples:
+ *     'S' | firstSample u32 | count u8
+ *     per sample: step u8 (sample number minus previous, 0 for the first) | values
+ */
+
+// Registered variables
+#ifndef TELEMETRY_MAX_CHANNELS
+#define TELEMETRY_MAX_CHANNELS 8
+#endif
+
+// Sample ring size in bytes (each sample takes 4 + value bytes)
+#ifndef TELEMETRY_BUFFER_SIZE
+#define TELEMETRY_BUFFER_SIZE 512
+#endif
+
+// Largest frame payload
+#ifndef TELEMETRY_FRAME_PAYLOAD
+#define TELEMETRY_FRAME_PAYLOAD 96
+#endif
+
+#ifndef TELEMETRY_DESCRIPTOR_PERIOD_MS
+#define TELEMETRY_DESCRIPTOR_PERIOD_MS 1000
+#endif
+
+#define TELEMETRY_FORMAT_VERSION 1
+
+enum TelemetryType : uint8_t {
+    TELEMETRY_U8,
+    TELEMETRY_I8,
+    TELEMETRY_U16,
+    TELEMETRY_I16,
+    TELEMETRY_U32,
+    TELEMETRY_I32,
+    TELEMETRY_FLOAT
+};
+
+/**
+ * Output sink for finished frames (one call per frame, delimiters included)
+ */
+typedef void (*TelemetryWrite)(const uint8_t* data, size_t length, void* context);
+
+/**
+ * Add a variable to every sample (before telemetry_start)
+ * @param name Column name (must stay valid, typically a string literal)
+ * @param source Variable read by the sampling ISR
+ * @return false if the channel table is full or telemetry is running
+ */
+bool telemetry_register(const char* name, const volatile void* source, TelemetryType type);
+
+inline bool telemetry_register(const char* name, const volatile uint8_t* source) {
+    return telemetry_register(name, source, TELEMETRY_U8);
+}
+inline bool telemetry_register(const char* name, const volatile int8_t* source) {
+    return telemetry_register(name, source, TELEMETRY_I8);
+}
+inline bool telemetry_register(const char* name, const volatile uint16_t* source) {
+    return telemetry_register(name, source, TELEMETRY_U16);
+}
+inline bool telemetry_register(const char* name, const volatile int16_t* source) {
+    return telemetry_register(name, source, TELEMETRY_I16);
+}
+inline bool telemetry_register(const char* name, const volatile uint32_t* source) {
+    return telemetry_register(name, source, TELEMETRY_U32);
+}
+inline bool telemetry_register(const char* name, const volatile int32_t* source) {
+    return telemetry_register(name, source, TELEMETRY_I32);
+}
+inline bool telemetry_register(const char* name, const volatile float* source) {
+    return telemetry_register(name, source, TELEMETRY_FLOAT);
+}
+
+/**
+ * Start sampling and the streaming task
+ * @param rateHz Samples per second (4 to 10000; the serial link must carry
+ *               rateHz * (sample size + 1) bytes per second plus framing)
+ * @param write Frame sink
+ * @param priority Streaming task priority (lowest useful level keeps control tasks unaffected)
+ * @param stackDepth Streaming task stack size
+ * @return false if no channel is registered, the rate is out of range or
+ *         the task could not be created
+ */
+bool telemetry_start(uint16_t rateHz, TelemetryWrite write, void* context,
+                     UBaseType_t priority, uint16_t stackDepth);
+
+/**
+ * Samples lost because the ring was full
+ */
+uint16_t telemetry_dropped();
+
+#endif // TELEMETRY_H
@@ -2,7 +2,7 @@
 #include <Arduino.h>
 #include "config.h"
 #include "my_led.h"
-#include "interactive_scanf.h"
+#include "line_reader.h"
 #include "serial_stdio.h"  // Add this include
 
 #define LED_PIN 12
@@ -20,8 +20,13 @@
 Led led;
 void(* resetFunc) (void) = 0; //declare reset function @ address 0
 
+// Commands are assembled without blocking; loop() stays free for other work
+char commandBuffer[32];
+LineReader commandReader;
+
 void setup() {
-    initSerialStdio(SERIAL_BAUD_RATE);  // Replace Serial.begin() with this
+    initSerialStdio(SERIAL_BAUD_RATE, false);  // The line reader does the echo
+    lineReaderInit(&commandReader, commandBuffer, sizeof(commandBuffer));
     
     // Initialize LED
     led_init(&led, LED_PIN);
@@ -37,12 +42,13 @@ void setup() {
 }
 
 void loop() {
-    delay(10); //Debounce time: 10 ms (to avoid busy loop)
-
-    char buffer[32];
-
-
-    scanf("%31s", buffer);
+    if (!lineReaderPoll(&commandReader, &Serial)) {
+        return;  // Line still being typed
+    }
+    const char* buffer = lineReaderLine(&commandReader);
+    if (buffer[0] == '\0') {
+        return;  // Empty line
+    }
     
     if (strcmp(buffer, LED_ON_COMMAND) == 0) {
         led_turn_on(&led);
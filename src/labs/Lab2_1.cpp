@@ -46,6 +46,23 @@ volatile unsigned long led2_lastChange = 0; // Last time LED2 changed state
 // Task 3 state (Provider)
 volatile int counter = 0;                   // Counter value
 
+// Status report in progress (Idle task): values are captured when the report
+// starts and sent one line per loop pass, see continueStatusReport()
+#define REPORT_LINES 8
+#define REPORT_LINE_SIZE 48         // Longest line is 46 bytes; the TX ring holds 63
+
+struct StatusReport {
+    bool led1;
+    bool led2;
+    int counter;
+    unsigned long led2OnTime;
+    unsigned long led2OffTime;
+    unsigned long uptime;
+};
+
+StatusReport report;
+uint8_t reportLine = REPORT_LINES;          // Next line to send (REPORT_LINES: idle)
+
 // Button interrupt flags
 volatile bool btn1_pressed = false;
 volatile bool btn2_pressed = false;
@@ -61,6 +78,7 @@ void executeTask1();
 void executeTask2();
 void executeTask3();
 void executeIdleTask();
+void continueStatusReport();
 
 // ============================================================================
 // TASK LIST
@@ -254,18 +272,53 @@ void executeTask3() {
 /**
  * Idle Task: Reporting and Monitoring
  * - Consumer: reads all global state variables
- * - Reports system state via Serial (STDIO)
+ * - Captures system state and starts a report; the lines go out from loop()
  */
 void executeIdleTask() {
+    noInterrupts();
+    report.led1 = led1_state;
+    report.led2 = led2_state;
+    report.counter = counter;
+    report.led2OnTime = led2_onTime;
+    report.led2OffTime = led2_offTime;
+    report.uptime = systemTicks;
+    interrupts();
+    reportLine = 0;
+}
+
+/**
+ * Format one line of the captured report
+ * @return Line length (snprintf semantics)
+ */
+int formatReportLine(uint8_t line, char* buffer, size_t size) {
     // Use \r\n for proper carriage return in Serial monitor
-    printf("\r\n=== Lab 2.1 Status (Interrupt-Driven) ===\r\n");
-    printf("LED1: %s\r\n", led1_state ? "ON " : "OFF");
-    printf("LED2: %s\r\n", led2_state ? "ON " : "OFF");
-    printf("Counter: %d\r\n", counter);
-    printf("LED2 ON:  %lu ms\r\n", led2_onTime);
-    printf("LED2 OFF: %lu ms\r\n", led2_offTime);
-    printf("Uptime: %lu ms\r\n", systemTicks);
-    printf("==========================================\r\n\r\n");
+    switch (line) {
+        case 0: return snprintf(buffer, size, "\r\n=== Lab 2.1 Status (Interrupt-Driven) ===\r\n");
+        case 1: return snprintf(buffer, size, "LED1: %s\r\n", report.led1 ? "ON " : "OFF");
+        case 2: return snprintf(buffer, size, "LED2: %s\r\n", report.led2 ? "ON " : "OFF");
+        case 3: return snprintf(buffer, size, "Counter: %d\r\n", report.counter);
+        case 4: return snprintf(buffer, size, "LED2 ON:  %lu ms\r\n", report.led2OnTime);
+        case 5: return snprintf(buffer, size, "LED2 OFF: %lu ms\r\n", report.led2OffTime);
+        case 6: return snprintf(buffer, size, "Uptime: %lu ms\r\n", report.uptime);
+        default: return snprintf(buffer, size, "==========================================\r\n\r\n");
+    }
+}
+
+/**
+ * Send the pending report lines that fit the core's 64-byte TX ring
+ * - The whole report (~200 bytes) would make printf wait on the wire and
+ *   delay the button tasks; whole lines that fit return at once
+ */
+void continueStatusReport() {
+    char line[REPORT_LINE_SIZE];
+    while (reportLine < REPORT_LINES) {
+        int length = formatReportLine(reportLine, line, sizeof(line));
+        if (length > Serial.availableForWrite()) {
+            return;  // Rest goes out on a later pass
+        }
+        fputs(line, stdout);
+        reportLine++;
+    }
 }
 
 // ============================================================================
@@ -385,6 +438,8 @@ void loop() {
         }
     }
     
+    continueStatusReport();
+
     // CPU can idle here or do other work
     // The loop is no longer polling - it's event-driven by interrupt flags
 }
@@ -5,9 +5,13 @@
 #include <queue.h>
 #include "config.h"
 #include "serial_stdio.h"
+#include "stdio_mux.h"
+#include "binlog_task.h"
 
 // Lab 2.2 - FreeRTOS: Preemptive Multitasking with Semaphores and Queues
 // Three tasks demonstrating synchronization and inter-task communication
+// All three print; stdio_mux keeps each task's lines whole on the terminal
+// Task 2 logs through binlog: decode with tools/binlog_decode.py firmware.elf
 
 // ============================================================================
 // HARDWARE CONFIGURATION
@@ -28,6 +32,12 @@ QueueHandle_t dataQueue;            // Queue for Task 2 -> Task 3 communication
 volatile int N = 0;                 // Counter incremented by Task 2
 volatile unsigned long led1_onTime = 0;  // Time when LED1 should turn off
 
+// Binary log frames go out whole, between the tasks' text lines
+static void binlogToMux(const uint8_t* data, size_t length, void* context) {
+    (void) context;
+    stdioMuxWrite(reinterpret_cast<const char*>(data), length);
+}
+
 // ============================================================================
 // TASK FUNCTION DECLARATIONS
 // ============================================================================
@@ -114,18 +124,17 @@ void Task2_SynchronousTask(void *pvParameters) {
         if (xSemaphoreTake(buttonSemaphore, portMAX_DELAY) == pdTRUE) {
             // Semaphore received - button was pressed
             N++;
-            printf("Task2: Semaphore received! N = %d\r\n", N);
+            BINLOG("Task2: Semaphore received! N = %d", N);
             
             // Send series of bytes (1,2,3,...N) to queue with 50ms interval
-            printf("Task2: Sending bytes to queue: ");
             for (int i = 1; i <= N; i++) {
                 uint8_t byte = i;
                 
                 // Send byte to queue (non-blocking or with timeout)
                 if (xQueueSendToBack(dataQueue, &byte, pdMS_TO_TICKS(10)) == pdTRUE) {
-                    printf("%d ", byte);
+                    BINLOG("Task2: Sent %d to queue", byte);
                 } else {
-                    printf("(queue full!) ");
+                    BINLOG("Task2: Queue full, %d not sent", byte);
                 }
                 
                 vTaskDelay(pdMS_TO_TICKS(50));  // 50ms delay between bytes
@@ -134,10 +143,10 @@ void Task2_SynchronousTask(void *pvParameters) {
             // Send terminator byte (0) for newline
             uint8_t terminator = 0;
             xQueueSendToBack(dataQueue, &terminator, pdMS_TO_TICKS(10));
-            printf("0\r\n");
+            BINLOG("Task2: Sent terminator 0");
             
             // Blink LED2 N times (ON: 300ms, OFF: 500ms)
-            printf("Task2: Blinking LED2 %d times.\r\n", N);
+            BINLOG("Task2: Blinking LED2 %d times.", N);
             for (int i = 0; i < N; i++) {
                 digitalWrite(LED2_PIN, HIGH);
                 vTaskDelay(pdMS_TO_TICKS(300));  // ON for 300ms
@@ -146,7 +155,7 @@ void Task2_SynchronousTask(void *pvParameters) {
                 vTaskDelay(pdMS_TO_TICKS(500));  // OFF for 500ms
             }
             
-            printf("Task2: Finished sequence for N=%d.\r\n", N);
+            BINLOG("Task2: Finished sequence for N=%d.", N);
         }
     }
 }
@@ -193,8 +202,12 @@ void Task3_BufferReader(void *pvParameters) {
 // ARDUINO SETUP
 // ============================================================================
 void setup() {
-    // Initialize Serial for STDIO
+    // Initialize Serial for STDIO, then give every task its own line buffer
     initSerialStdio(SERIAL_BAUD_RATE);
+    if (!initStdioMux(stdout)) {
+        printf("ERROR: Failed to create stdio mutex!\r\n");
+        while(1);  // Halt on error
+    }
     
     printf("Lab 2.2 - FreeRTOS Multitasking\r\n");
     printf("================================\r\n\r\n");
@@ -222,6 +235,8 @@ void setup() {
         while(1);  // Halt on error
     }
     
+    binlog_init(binlogToMux, nullptr);
+    
     printf("FreeRTOS objects created successfully.\r\n");
     printf("Creating tasks...\r\n\r\n");
     
@@ -255,6 +270,9 @@ void setup() {
         NULL
     );
     
+    // Create binary log streamer (Priority 0 - lowest, sends every 100ms)
+    binlog_start_task(0, 192, pdMS_TO_TICKS(100));
+    
     printf("All tasks created!\r\n");
     printf("BTN1 (pin %d): Press to trigger sequence\r\n", BTN1_PIN);
     printf("LED1 (pin %d): Lights for 1 second on button press\r\n", LED1_PIN);
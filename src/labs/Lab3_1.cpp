@@ -4,7 +4,10 @@
 #include <Adafruit_NeoPixel.h>
 #include "config.h"
 #include "serial_stdio.h"
+#include "stdio_mux.h"
+#include "telemetry.h"
 #include "analog_sensor.h"
+#include "fixed_format.h"
 
 // ============================================================================
 // HARDWARE CONFIGURATION
@@ -13,6 +16,9 @@
 #define LED_RING_PIXELS     16      // Number of LEDs in ring
 #define POT_PIN             A0      // Potentiometer analog input
 
+// Binary telemetry of the shared variables (tools/telemetry_decode.py -> CSV)
+#define TELEMETRY_RATE_HZ   500
+
 // ============================================================================
 // GLOBAL OBJECTS
 // ============================================================================
@@ -30,6 +36,13 @@ volatile float potVoltage = 0.0;
 volatile uint32_t sensorReadCount = 0;
 volatile uint32_t ledUpdateCount = 0;
 
+// Telemetry frames share the port with the status text; the mux keeps
+// frames and lines from splitting each other
+static void telemetryToMux(const uint8_t* data, size_t length, void* context) {
+    (void) context;
+    stdioMuxWrite(reinterpret_cast<const char*>(data), length);
+}
+
 // ============================================================================
 // TASK FUNCTION DECLARATIONS
 // ============================================================================
@@ -206,9 +219,11 @@ void TaskStatusDisplay(void *pvParameters) {
         float voltage = potVoltage;
         
         // Simple output: Potentiometer and LED position
-        printf("Pot: %4u (%1.2fV) | LED Position: %2u/%u\r\n", 
+        char voltageText[8];
+        fixed_format::formatFloat(voltageText, sizeof(voltageText), voltage, 2, 1);
+        printf("Pot: %4u (%sV) | LED Position: %2u/%u\r\n", 
                rawAdc,
-               (double) voltage,
+               voltageText,
                ledPos % LED_RING_PIXELS,
                LED_RING_PIXELS - 1);
         
@@ -221,8 +236,12 @@ void TaskStatusDisplay(void *pvParameters) {
 // ARDUINO SETUP
 // ============================================================================
 void setup() {
-    // Initialize Serial STDIO (for printf/scanf)
+    // Initialize Serial STDIO (for printf/scanf), shared with the telemetry task
     initSerialStdio(SERIAL_BAUD_RATE);
+    if (!initStdioMux(stdout)) {
+        printf("ERROR: Failed to create stdio mutex!\r\n");
+        while(1);  // Halt on error
+    }
     
     // Initialize LED ring (NeoPixel)
     ring.begin();
@@ -243,6 +262,14 @@ void setup() {
     // Create Task 3: Status Display (Low priority - monitoring)
     xTaskCreate(TaskStatusDisplay, "Display", 256, NULL, 1, NULL);
     
+    // Sample the sensor and LED task variables from the Timer2 ISR
+    telemetry_register("pot_raw", &potRawValue);
+    telemetry_register("pot_voltage", &potVoltage);
+    telemetry_register("led_updates", &ledUpdateCount);
+    if (!telemetry_start(TELEMETRY_RATE_HZ, telemetryToMux, NULL, 0, 192)) {
+        printf("ERROR: Failed to start telemetry!\r\n");
+    }
+    
     printf("Lab 3.1: LED Ring Control Ready\r\n");
     
     // Start FreeRTOS scheduler
@@ -10,6 +10,7 @@
 #include "signal_conditioning.h"
 #include "thermistor_utils.h"
 #include "lcd_stdio.h"
+#include "fixed_format.h"
 
 // -----------------------------------------------------------------------------
 // Hardware configuration
@@ -107,13 +108,20 @@ static void updateLcd(const ConditionedSample &sample) {
         statusText = "LOW";
     }
 
+    char temperatureText[8];
+    char voltageText[8];
+    fixed_format::formatFloat(temperatureText, sizeof(temperatureText), sample.temperatureFilteredC, 1, 5);
+    fixed_format::formatFloat(voltageText, sizeof(voltageText), sample.voltage, 2, 1);
+
     printf(
-        "\fT:%5.1f%cC %-4s\nADC:%4u V:%1.2f",
-        static_cast<double>(sample.temperatureFilteredC),
+        "\fT:%s%cC %-4s\nADC:%4u V:%s",
+        temperatureText,
         (char)223,
         statusText,
         sample.rawAdc,
-        static_cast<double>(sample.voltage));
+        voltageText);
+    // Only the digits that moved go over I2C
+    LCDStdio::flush();
 }
 
 // -----------------------------------------------------------------------------
@@ -189,6 +197,7 @@ void setup() {
 
     LCDStdio::init(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
     LCDStdio::clear();
+    LCDStdio::setAutoFlush(false);  // Whole frames, flushed by updateLcd()
 
     thermistorConfigInit(gThermistorConfig,
                          THERMISTOR_BETA,
@@ -211,11 +220,13 @@ void setup() {
 
     // Preload LCD with startup message via stdio stream
     printf("\fLab 3.2 Ready\nInit filters...");
+    LCDStdio::flush();
 
     xTaskCreate(TaskSensorPipeline, "Sensor", 256, nullptr, 3, nullptr);
     xTaskCreate(TaskReporter, "Reporter", 256, nullptr, 2, nullptr);
 
     printf("\fLab 3.2 Ready\nScheduler start");
+    LCDStdio::flush();
 
     vTaskStartScheduler();
 
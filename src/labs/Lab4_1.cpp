@@ -3,13 +3,15 @@
 #include <Arduino.h>
 #include <Arduino_FreeRTOS.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <Wire.h>
 #include <semphr.h>
 
 #include "config.h"
-#include "serial_stdio.h"
+#include "serial_stdio_rtos.h"
 #include "my_relay.h"
 #include "lcd_stdio.h"
+#include "stdio_router.h"
 #include "command_handler.h"
 
 // -----------------------------------------------------------------------------
@@ -30,6 +32,12 @@ constexpr TickType_t POT_CHECK_PERIOD = pdMS_TO_TICKS(100);
 constexpr TickType_t STATUS_UPDATE_PERIOD = pdMS_TO_TICKS(500);
 constexpr TickType_t LED_BLINK_PERIOD = pdMS_TO_TICKS(1000);
 
+// Output sinks: the I2C LCD is drained by its own task at most every
+// LCD_REFRESH_PERIOD, so commands never wait for the display
+constexpr TickType_t LCD_REFRESH_PERIOD = pdMS_TO_TICKS(100);
+constexpr uint16_t LCD_SINK_BUFFER_SIZE = 96;
+constexpr uint16_t LOG_SINK_BUFFER_SIZE = 256;
+
 // -----------------------------------------------------------------------------
 // Shared data structures (protected by mutex)
 // -----------------------------------------------------------------------------
@@ -42,15 +50,58 @@ struct RelayState {
 
 static Relay gRelay;
 static CommandHandler gCommandHandler;
-static FILE gLcdStream;
+static FILE gLcdStream;          // LCD only
+static FILE gEventStream;        // Serial, LCD and event log
+static FILE* gSerialStream = nullptr;
+static char gLcdSinkBuffer[LCD_SINK_BUFFER_SIZE];
+static char gLogSinkBuffer[LOG_SINK_BUFFER_SIZE];
+static int8_t gLogSink = -1;
 static RelayState gRelayState{false, false, 0, 0};
 static SemaphoreHandle_t gStateMutex = nullptr;
+static SemaphoreHandle_t gLcdMutex = nullptr;    // One LCD frame at a time
 
 // -----------------------------------------------------------------------------
 // Helper functions for thread-safe access
 // -----------------------------------------------------------------------------
-static int lcdStreamPutchar(char c, FILE *file) {
-    return LCDStdio::putcharlcd(c, file);
+// A line end is applied only once more text follows, so event messages can
+// end in '\n' for the serial side without scrolling the LCD
+static void lcdSinkWrite(const char* data, size_t length, void* context) {
+    (void) context;
+    static bool pendingNewline = false;
+
+    for (size_t i = 0; i < length; i++) {
+        if (pendingNewline && data[i] != '\f') {
+            LCDStdio::putcharlcd('\n', nullptr);
+        }
+        pendingNewline = (data[i] == '\n');
+        if (!pendingNewline) {
+            LCDStdio::putcharlcd(data[i], nullptr);
+        }
+    }
+}
+
+// The LCD is written in whole drain passes, so push the frame once per pass
+static void lcdSinkDrained(void* context) {
+    (void) context;
+    LCDStdio::flush();
+}
+
+static void serialSinkWrite(const char* data, size_t length, void* context) {
+    (void) context;
+    fwrite(data, 1, length, gSerialStream);
+}
+
+// LCD frames start with '\f' and are written by tasks of different priority;
+// holding gLcdMutex for the whole frame keeps PotMonitor's auto events from
+// landing in the middle of a status frame in the LCD sink
+static void lcdPrintf(FILE* stream, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (gLcdMutex != nullptr && xSemaphoreTake(gLcdMutex, portMAX_DELAY) == pdTRUE) {
+        vfprintf(stream, format, args);
+        xSemaphoreGive(gLcdMutex);
+    }
+    va_end(args);
 }
 
 static RelayState getRelayStateSnapshot() {
@@ -81,11 +132,11 @@ static void setAutoMode(bool autoMode) {
 
 static void updateStatusDisplay() {
     RelayState state = getRelayStateSnapshot();
-    fprintf(&gLcdStream,
-            "\fRelay: %s\nPot: %3u%% (%s)",
-            state.relayOn ? "ON " : "OFF",
-            state.potPercent,
-            state.autoMode ? "AUTO" : "MAN");
+    lcdPrintf(&gLcdStream,
+              "\fRelay: %s\nPot: %3u%% (%s)",
+              state.relayOn ? "ON " : "OFF",
+              state.potPercent,
+              state.autoMode ? "AUTO" : "MAN");
 }
 
 // -----------------------------------------------------------------------------
@@ -98,8 +149,7 @@ static bool cmdRelayOn(void* context, const char* args) {
     relay_turn_on(&gRelay);
     setAutoMode(false);
     updateRelayState(true, false, state.potValue, state.potPercent);
-    printf("\fRelay: ON\r\n");
-    fprintf(&gLcdStream, "\fRelay: ON\nManual mode");
+    lcdPrintf(&gEventStream, "\fRelay: ON\nManual mode\n");
     return true;
 }
 
@@ -110,8 +160,7 @@ static bool cmdRelayOff(void* context, const char* args) {
     relay_turn_off(&gRelay);
     setAutoMode(false);
     updateRelayState(false, false, state.potValue, state.potPercent);
-    printf("\fRelay: OFF\r\n");
-    fprintf(&gLcdStream, "\fRelay: OFF\nManual mode");
+    lcdPrintf(&gEventStream, "\fRelay: OFF\nManual mode\n");
     return true;
 }
 
@@ -122,6 +171,14 @@ static bool cmdStatus(void* context, const char* args) {
     return true;
 }
 
+static bool cmdLog(void* context, const char* args) {
+    (void) context;
+    (void) args;
+    printf("Event log:\r\n");
+    stdioRouterDumpLog(gLogSink, stdout);
+    return true;
+}
+
 static bool cmdHelp(void* context, const char* args) {
     (void) context;
     (void) args;
@@ -132,7 +189,7 @@ static bool cmdHelp(void* context, const char* args) {
 static bool cmdUnknown(void* context, const char* command) {
     (void) context;
     printf("\fUnknown command: %s\r\n", command ? command : "");
-    fprintf(&gLcdStream, "\fUnknown cmd\nTry: relay on/off");
+    lcdPrintf(&gLcdStream, "\fUnknown cmd\nTry: relay on/off");
     commandHandlerPrintHelp(&gCommandHandler);
     return false;
 }
@@ -150,17 +207,19 @@ void TaskStatusLED(void *pvParameters);
 // -----------------------------------------------------------------------------
 void TaskCommandProcessor(void *pvParameters) {
     (void) pvParameters;
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(50);
 
     for (;;) {
-        if (Serial.available()) {
-            int c = getchar();
-            if (c != EOF && c != '\0') {
-                commandHandlerProcessChar(&gCommandHandler, static_cast<char>(c));
-            }
+        // Sleep until the RX interrupt delivers input, then drain all of it
+        if (!serialRtosWaitForData(portMAX_DELAY)) {
+            continue;
+        }
+
+        int c;
+        while ((c = serialRtosRead()) != EOF) {
+            // 0x00 opens a binary frame; frame bytes are not echoed
+            commandHandlerProcessChar(&gCommandHandler, static_cast<char>(c));
+            setSerialRtosEcho(!commandHandlerInFrame(&gCommandHandler));
         }
-        vTaskDelayUntil(&lastWakeTime, xFrequency);
     }
 }
 
@@ -189,7 +248,7 @@ void TaskPotentiometerMonitor(void *pvParameters) {
             if (relay_is_on(&gRelay) && state.autoMode) {
                 relay_turn_off(&gRelay);
                 updateRelayState(false, true, potValue, potPercent);
-                printf("[Auto] Relay OFF (Pot: %u%%)\r\n", potPercent);
+                lcdPrintf(&gEventStream, "\f[Auto] Relay OFF\nPot: %u%%\n", potPercent);
             } else {
                 updateRelayState(state.relayOn, state.autoMode, potValue, potPercent);
             }
@@ -231,7 +290,7 @@ void TaskStatusLED(void *pvParameters) {
 // Arduino setup & loop
 // -----------------------------------------------------------------------------
 void setup() {
-    initSerialStdio(SERIAL_BAUD_RATE);
+    initSerialStdioRtos(SERIAL_BAUD_RATE);
 
     pinMode(POTENTIOMETER_PIN, INPUT);
     pinMode(STATUS_LED_PIN, OUTPUT);
@@ -243,9 +302,28 @@ void setup() {
     Wire.begin();
     LCDStdio::init(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
     LCDStdio::clear();
-    fdev_setup_stream(&gLcdStream, lcdStreamPutchar, nullptr, _FDEV_SETUP_WRITE);
+    LCDStdio::setAutoFlush(false);
+
+    // Route LCD text and events through the stdio router; serial output is
+    // already buffered by serial_stdio_rtos and is written directly
+    gSerialStream = stdout;
+    const StdioSinkConfig serialSink{serialSinkWrite, nullptr, nullptr, 0, 0, 0, STDIO_SINK_CRLF, 0, 0, nullptr};
+    const StdioSinkConfig lcdSink{lcdSinkWrite, nullptr, gLcdSinkBuffer, LCD_SINK_BUFFER_SIZE,
+                                  LCD_REFRESH_PERIOD, 0, 0, 0, 192, lcdSinkDrained};
+    const StdioSinkConfig logSink{nullptr, nullptr, gLogSinkBuffer, LOG_SINK_BUFFER_SIZE, 0, 0, STDIO_SINK_CRLF, 0, 0,
+                                  nullptr};
+    int8_t serial = stdioRouterAddSink(&serialSink);
+    int8_t lcd = stdioRouterAddSink(&lcdSink);
+    gLogSink = stdioRouterAddSink(&logSink);
+    if (serial < 0 || lcd < 0 || gLogSink < 0) {
+        printf("ERROR: Failed to create output sinks!\r\n");
+        while (true);  // Halt on error
+    }
+    stdioRouterOpen(&gLcdStream, STDIO_ROUTE(lcd));
+    stdioRouterOpen(&gEventStream, STDIO_ROUTE(serial) | STDIO_ROUTE(lcd) | STDIO_ROUTE(gLogSink));
 
     gStateMutex = xSemaphoreCreateMutex();
+    gLcdMutex = xSemaphoreCreateMutex();
 
     // Initialize unified command handler with default callback for unknown commands
     commandHandlerInit(&gCommandHandler, cmdUnknown, nullptr);
@@ -254,6 +332,7 @@ void setup() {
     commandHandlerRegister(&gCommandHandler, "relay on", cmdRelayOn, nullptr, "Turn relay ON");
     commandHandlerRegister(&gCommandHandler, "relay off", cmdRelayOff, nullptr, "Turn relay OFF");
     commandHandlerRegister(&gCommandHandler, "status", cmdStatus, nullptr, "Show current status");
+    commandHandlerRegister(&gCommandHandler, "log", cmdLog, nullptr, "Show recent relay events");
     commandHandlerRegister(&gCommandHandler, "help", cmdHelp, nullptr, "Show help");
 
     fprintf(&gLcdStream, "\fLab 4.1 Ready\nInit FreeRTOS...");
@@ -262,7 +341,7 @@ void setup() {
     printf("Auto mode: Relay activates at pot > 70%%\r\n");
 
     // Create FreeRTOS tasks
-    // Priority order: PotMonitor (3) > CommandProcessor (2) > StatusDisplay (1) > StatusLED (0)
+    // Priority order: PotMonitor (3) > CommandProcessor (2) > StatusDisplay (1) > StatusLED, LCD sink (0)
     xTaskCreate(TaskPotentiometerMonitor, "PotMonitor", 256, nullptr, 3, nullptr);
     xTaskCreate(TaskCommandProcessor, "CmdProc", 256, nullptr, 2, nullptr);
     xTaskCreate(TaskStatusDisplay, "StatusDisp", 256, nullptr, 1, nullptr);
@@ -5,13 +5,14 @@
 #include <stdio.h>
 #include <Wire.h>
 #include <semphr.h>
-#include <stdlib.h>
 
 #include "config.h"
-#include "serial_stdio.h"
+#include "serial_stdio_rtos.h"
 #include "my_a4988.h"
 #include "lcd_stdio.h"
 #include "command_handler.h"
+#include "command_macros.h"
+#include "command_async.h"
 
 // -----------------------------------------------------------------------------
 // Hardware configuration
@@ -25,6 +26,13 @@ constexpr uint8_t LCD_I2C_ADDRESS = 0x27;
 constexpr uint8_t LCD_COLUMNS = 16;
 constexpr uint8_t LCD_ROWS = 2;
 
+constexpr uint16_t MACRO_EEPROM_ADDRESS = 0;
+
+// Second command port on Serial1 (TX1/RX1). It is polled once per tick
+// (15 ms), so the baud rate must keep a tick's worth of bytes below the
+// 64-byte RX buffer.
+constexpr unsigned long AUX_BAUD_RATE = 38400;
+
 constexpr TickType_t STATUS_UPDATE_PERIOD = pdMS_TO_TICKS(500);
 constexpr TickType_t LED_BLINK_PERIOD = pdMS_TO_TICKS(1000);
 
@@ -39,9 +47,14 @@ struct MotorState {
 
 static A4988Motor gMotor;
 static CommandHandler gCommandHandler;
+static CommandMacros gCommandMacros;
 static FILE gLcdStream;
 static MotorState gMotorState{0, false, "STOP"};
 static SemaphoreHandle_t gStateMutex = nullptr;
+static SemaphoreHandle_t gCommandMutex = nullptr;
+static SemaphoreHandle_t gLcdMutex = nullptr;    // LCDStdio drawing and flush()
+static CommandInput gAuxInput;
+static FILE gAuxStream;
 
 // -----------------------------------------------------------------------------
 // Helper functions for thread-safe access
@@ -50,6 +63,24 @@ static int lcdStreamPutchar(char c, FILE *file) {
     return LCDStdio::putcharlcd(c, file);
 }
 
+static int auxStreamPutchar(char c, FILE *file) {
+    (void) file;
+    Serial1.write(static_cast<uint8_t>(c));
+    return c;
+}
+
+// Both command ports dispatch under one lock; responses go to the port the
+// command came from
+static void lockCommands(void* context) {
+    (void) context;
+    xSemaphoreTake(gCommandMutex, portMAX_DELAY);
+}
+
+static void unlockCommands(void* context) {
+    (void) context;
+    xSemaphoreGive(gCommandMutex);
+}
+
 static MotorState getMotorStateSnapshot() {
     MotorState snapshot{0, false, "STOP"};
     if (gStateMutex != nullptr && xSemaphoreTake(gStateMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
@@ -59,59 +90,118 @@ static MotorState getMotorStateSnapshot() {
     return snapshot;
 }
 
+// Caller holds gStateMutex
+static void setMotorStateLocked(int8_t power) {
+    gMotorState.power = power;
+    gMotorState.isRunning = (power != 0);
+    if (power > 0) {
+        gMotorState.direction = "FWD";
+    } else if (power < 0) {
+        gMotorState.direction = "REV";
+    } else {
+        gMotorState.direction = "STOP";
+    }
+}
+
 static void updateMotorState(int8_t power) {
     if (gStateMutex != nullptr && xSemaphoreTake(gStateMutex, portMAX_DELAY) == pdTRUE) {
-        gMotorState.power = power;
-        gMotorState.isRunning = (power != 0);
-        if (power > 0) {
-            gMotorState.direction = "FWD";
-        } else if (power < 0) {
-            gMotorState.direction = "REV";
-        } else {
-            gMotorState.direction = "STOP";
-        }
+        setMotorStateLocked(power);
         xSemaphoreGive(gStateMutex);
     }
 }
 
+// Runs from the display task and from "status" on either command port;
+// LCDStdio is single-writer, so each frame is drawn and flushed under gLcdMutex
 static void updateStatusDisplay() {
     MotorState state = getMotorStateSnapshot();
-    fprintf(&gLcdStream,
-            "\fMotor: %s\nPower: %+4d%%",
-            state.direction,
-            state.power);
+    if (gLcdMutex != nullptr && xSemaphoreTake(gLcdMutex, portMAX_DELAY) == pdTRUE) {
+        fprintf(&gLcdStream,
+                "\fMotor: %s\nPower: %+4d%%",
+                state.direction,
+                state.power);
+        LCDStdio::flush();
+        xSemaphoreGive(gLcdMutex);
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Command callbacks for unified handler
 // -----------------------------------------------------------------------------
-static bool cmdMotorSet(void* context, const char* args) {
+// "motor set" schema: power is validated by the command handler
+static const CommandArgSpec MOTOR_SET_ARGS[] = {
+    COMMAND_ARG_INT("power", -100, 100),
+};
+
+static bool cmdMotorSet(void* context, const CommandArg* args, uint8_t argCount) {
     (void) context;
-    
-    if (args == nullptr || *args == '\0') {
-        printf("\fError: motor set requires value [-100..100]\r\n");
-        return false;
+    (void) argCount;
+
+    int8_t power = static_cast<int8_t>(args[0].value);
+    a4988_set_power(&gMotor, power);
+    updateMotorState(power);
+    commandHandlerPrintf("\fMotor set to %+d%%\r\n", power);
+    return true;
+}
+
+// "motor ramp" runs as a job: it steps the power every few hundred
+// milliseconds, so it must not hold up the command task
+static const CommandArgSpec MOTOR_RAMP_ARGS[] = {
+    COMMAND_ARG_INT("power", -100, 100),
+    COMMAND_ARG_INT("step_ms", 20, 2000),
+};
+
+static bool cmdMotorRamp(void* context, const CommandArg* args, uint8_t argCount) {
+    (void) context;
+    (void) argCount;
+
+    int8_t target = static_cast<int8_t>(args[0].value);
+    TickType_t stepDelay = pdMS_TO_TICKS(args[1].value);
+    int8_t power = a4988_get_power(&gMotor);
+
+    while (power != target) {
+        int16_t next = power + ((target > power) ? 10 : -10);
+        if ((target > power && next > target) || (target < power && next < target)) {
+            next = target;
+        }
+
+        // Checked under the state mutex so a late step cannot undo an urgent stop
+        bool cancelled = true;
+        if (xSemaphoreTake(gStateMutex, portMAX_DELAY) == pdTRUE) {
+            cancelled = commandAsyncCancelled();
+            if (!cancelled) {
+                a4988_set_power(&gMotor, static_cast<int8_t>(next));
+                setMotorStateLocked(static_cast<int8_t>(next));
+            }
+            xSemaphoreGive(gStateMutex);
+        }
+        if (cancelled) {
+            break;
+        }
+        power = static_cast<int8_t>(next);
+
+        if (power != target && !commandAsyncDelay(stepDelay)) {
+            break;
+        }
     }
-    
-    // Parse power value
-    int power = atoi(args);
-    if (power < -100 || power > 100) {
-        printf("\fError: Power must be [-100..100]\r\n");
+
+    if (power != target) {
+        commandHandlerPrintf("Ramp stopped at %+d%%\r\n", power);
         return false;
     }
-    
-    a4988_set_power(&gMotor, static_cast<int8_t>(power));
-    updateMotorState(power);
-    printf("\fMotor set to %+d%%\r\n", power);
+    commandHandlerPrintf("Ramp reached %+d%%\r\n", power);
     return true;
 }
 
 static bool cmdMotorStop(void* context, const char* args) {
     (void) context;
     (void) args;
-    a4988_stop(&gMotor);
-    updateMotorState(0);
-    printf("\fMotor stopped\r\n");
+    // Same lock as a ramp step, so a step in flight lands before the stop
+    if (xSemaphoreTake(gStateMutex, portMAX_DELAY) == pdTRUE) {
+        a4988_stop(&gMotor);
+        setMotorStateLocked(0);
+        xSemaphoreGive(gStateMutex);
+    }
+    commandHandlerPrintf("\fMotor stopped\r\n");
     return true;
 }
 
@@ -122,7 +212,7 @@ static bool cmdMotorMax(void* context, const char* args) {
     int8_t maxPower = (state.power >= 0) ? 100 : -100;
     a4988_set_max(&gMotor);
     updateMotorState(maxPower);
-    printf("\fMotor set to maximum (%+d%%)\r\n", maxPower);
+    commandHandlerPrintf("\fMotor set to maximum (%+d%%)\r\n", maxPower);
     return true;
 }
 
@@ -134,7 +224,7 @@ static bool cmdMotorInc(void* context, const char* args) {
     a4988_increase_power(&gMotor, 10);
     int8_t newPower = a4988_get_power(&gMotor);
     updateMotorState(newPower);
-    printf("\fMotor power increased: %+d%% -> %+d%%\r\n", oldPower, newPower);
+    commandHandlerPrintf("\fMotor power increased: %+d%% -> %+d%%\r\n", oldPower, newPower);
     return true;
 }
 
@@ -146,7 +236,7 @@ static bool cmdMotorDec(void* context, const char* args) {
     a4988_decrease_power(&gMotor, 10);
     int8_t newPower = a4988_get_power(&gMotor);
     updateMotorState(newPower);
-    printf("\fMotor power decreased: %+d%% -> %+d%%\r\n", oldPower, newPower);
+    commandHandlerPrintf("\fMotor power decreased: %+d%% -> %+d%%\r\n", oldPower, newPower);
     return true;
 }
 
@@ -166,34 +256,70 @@ static bool cmdHelp(void* context, const char* args) {
 
 static bool cmdUnknown(void* context, const char* command) {
     (void) context;
-    printf("\fUnknown command: %s\r\n", command ? command : "");
+    commandHandlerPrintf("\fUnknown command: %s\r\n", command ? command : "");
     commandHandlerPrintHelp(&gCommandHandler);
     return false;
 }
 
+// Command table in flash: names and help text cost no SRAM
+static const char NAME_MOTOR_SET[] PROGMEM = "motor set";
+static const char NAME_MOTOR_STOP[] PROGMEM = "motor stop";
+static const char NAME_MOTOR_MAX[] PROGMEM = "motor max";
+static const char NAME_MOTOR_INC[] PROGMEM = "motor inc";
+static const char NAME_MOTOR_DEC[] PROGMEM = "motor dec";
+static const char NAME_MOTOR_RAMP[] PROGMEM = "motor ramp";
+static const char NAME_STATUS[] PROGMEM = "status";
+static const char NAME_HELP[] PROGMEM = "help";
+
+static const char DESC_MOTOR_SET[] PROGMEM = "Set motor power [-100..100]";
+static const char DESC_MOTOR_STOP[] PROGMEM = "Stop motor immediately";
+static const char DESC_MOTOR_MAX[] PROGMEM = "Set motor to maximum power";
+static const char DESC_MOTOR_INC[] PROGMEM = "Increase power by 10%";
+static const char DESC_MOTOR_DEC[] PROGMEM = "Decrease power by 10%";
+static const char DESC_MOTOR_RAMP[] PROGMEM = "Ramp power in 10% steps (job)";
+static const char DESC_STATUS[] PROGMEM = "Show current status";
+static const char DESC_HELP[] PROGMEM = "Show help";
+
+static const CommandTableEntry MOTOR_COMMANDS[] PROGMEM = {
+    COMMAND_TABLE_TYPED(NAME_MOTOR_SET, cmdMotorSet, MOTOR_SET_ARGS,
+                        sizeof(MOTOR_SET_ARGS) / sizeof(MOTOR_SET_ARGS[0]), DESC_MOTOR_SET),
+    COMMAND_TABLE_ENTRY_FLAGS(NAME_MOTOR_STOP, cmdMotorStop, DESC_MOTOR_STOP, COMMAND_FLAG_URGENT),
+    COMMAND_TABLE_ENTRY(NAME_MOTOR_MAX, cmdMotorMax, DESC_MOTOR_MAX),
+    COMMAND_TABLE_ENTRY(NAME_MOTOR_INC, cmdMotorInc, DESC_MOTOR_INC),
+    COMMAND_TABLE_ENTRY(NAME_MOTOR_DEC, cmdMotorDec, DESC_MOTOR_DEC),
+    COMMAND_TABLE_ENTRY(NAME_STATUS, cmdStatus, DESC_STATUS),
+    COMMAND_TABLE_ENTRY(NAME_HELP, cmdHelp, DESC_HELP),
+    COMMAND_TABLE_TYPED_FLAGS(NAME_MOTOR_RAMP, cmdMotorRamp, MOTOR_RAMP_ARGS,
+                              sizeof(MOTOR_RAMP_ARGS) / sizeof(MOTOR_RAMP_ARGS[0]), DESC_MOTOR_RAMP,
+                              COMMAND_FLAG_ASYNC),
+};
+
 // -----------------------------------------------------------------------------
 // FreeRTOS Task declarations
 // -----------------------------------------------------------------------------
 void TaskCommandProcessor(void *pvParameters);
 void TaskStatusDisplay(void *pvParameters);
 void TaskStatusLED(void *pvParameters);
+void TaskAuxCommands(void *pvParameters);
 
 // -----------------------------------------------------------------------------
 // Task 1: Command Processor (STDIO input)
 // -----------------------------------------------------------------------------
 void TaskCommandProcessor(void *pvParameters) {
     (void) pvParameters;
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(50);
 
     for (;;) {
-        if (Serial.available()) {
-            int c = getchar();
-            if (c != EOF && c != '\0') {
-                commandHandlerProcessChar(&gCommandHandler, static_cast<char>(c));
-            }
+        // Sleep until the RX interrupt delivers input, then drain all of it
+        if (!serialRtosWaitForData(portMAX_DELAY)) {
+            continue;
+        }
+
+        int c;
+        while ((c = serialRtosRead()) != EOF) {
+            // 0x00 opens a binary frame; frame bytes are not echoed
+            commandHandlerProcessChar(&gCommandHandler, static_cast<char>(c));
+            setSerialRtosEcho(!commandHandlerInFrame(&gCommandHandler));
         }
-        vTaskDelayUntil(&lastWakeTime, xFrequency);
     }
 }
 
@@ -226,11 +352,32 @@ void TaskStatusLED(void *pvParameters) {
     }
 }
 
+// -----------------------------------------------------------------------------
+// Task 4: Aux Command Port (Serial1, own line buffer, same command table)
+// -----------------------------------------------------------------------------
+void TaskAuxCommands(void *pvParameters) {
+    (void) pvParameters;
+
+    // HardwareSerial has no RX notification, so Serial1 is polled once per
+    // tick: aux commands see up to one tick (15 ms) of extra latency
+    for (;;) {
+        while (Serial1.available() > 0) {
+            char c = static_cast<char>(Serial1.read());
+            bool framed = commandInputInFrame(&gAuxInput) || static_cast<uint8_t>(c) == FRAME_DELIMITER;
+            if (!framed) {
+                Serial1.write(static_cast<uint8_t>(c));
+            }
+            commandHandlerProcessInputChar(&gCommandHandler, &gAuxInput, c);
+        }
+        vTaskDelay(1);
+    }
+}
+
 // -----------------------------------------------------------------------------
 // Arduino setup & loop
 // -----------------------------------------------------------------------------
 void setup() {
-    initSerialStdio(SERIAL_BAUD_RATE);
+    initSerialStdioRtos(SERIAL_BAUD_RATE);
 
     pinMode(STATUS_LED_PIN, OUTPUT);
     digitalWrite(STATUS_LED_PIN, LOW);
@@ -246,36 +393,53 @@ void setup() {
     Wire.begin();
     LCDStdio::init(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
     LCDStdio::clear();
+    LCDStdio::setAutoFlush(false);  // Whole frames, flushed by updateStatusDisplay()
     fdev_setup_stream(&gLcdStream, lcdStreamPutchar, nullptr, _FDEV_SETUP_WRITE);
 
     gStateMutex = xSemaphoreCreateMutex();
+    gCommandMutex = xSemaphoreCreateMutex();
+    gLcdMutex = xSemaphoreCreateMutex();
+
+    Serial1.begin(AUX_BAUD_RATE);
+    fdev_setup_stream(&gAuxStream, auxStreamPutchar, nullptr, _FDEV_SETUP_WRITE);
+    commandInputInit(&gAuxInput, &gAuxStream);
 
     // Initialize unified command handler with default callback for unknown commands
     commandHandlerInit(&gCommandHandler, cmdUnknown, nullptr);
+    commandHandlerSetLock(&gCommandHandler, lockCommands, unlockCommands, nullptr);
+
+    // Register commands from the flash table (frame command indices follow table order)
+    commandHandlerRegisterTable(&gCommandHandler, MOTOR_COMMANDS,
+                                sizeof(MOTOR_COMMANDS) / sizeof(MOTOR_COMMANDS[0]), nullptr);
+    // Long commands run on a worker below the command task; "motor stop"
+    // (urgent) cancels them before it runs
+    commandAsyncInit(&gCommandHandler, 1, 256);
+
+    // Stored macros live at the start of EEPROM and register their own names
+    commandMacrosInit(&gCommandMacros, &gCommandHandler, MACRO_EEPROM_ADDRESS);
 
-    // Register commands dynamically
-    commandHandlerRegister(&gCommandHandler, "motor set", cmdMotorSet, nullptr, "Set motor power [-100..100]");
-    commandHandlerRegister(&gCommandHandler, "motor stop", cmdMotorStop, nullptr, "Stop motor immediately");
-    commandHandlerRegister(&gCommandHandler, "motor max", cmdMotorMax, nullptr, "Set motor to maximum power");
-    commandHandlerRegister(&gCommandHandler, "motor inc", cmdMotorInc, nullptr, "Increase power by 10%");
-    commandHandlerRegister(&gCommandHandler, "motor dec", cmdMotorDec, nullptr, "Decrease power by 10%");
-    commandHandlerRegister(&gCommandHandler, "status", cmdStatus, nullptr, "Show current status");
-    commandHandlerRegister(&gCommandHandler, "help", cmdHelp, nullptr, "Show help");
+    // "stats" only exists when built with COMMAND_HANDLER_STATS=1; last, so
+    // no other frame command index depends on that flag
+    commandHandlerRegisterStats(&gCommandHandler);
 
     fprintf(&gLcdStream, "\fLab 4.2 Ready\nInit FreeRTOS...");
+    LCDStdio::flush();
     printf("Lab 4.2: Stepper Motor Control System Ready\r\n");
     printf("Type 'help' for available commands\r\n");
-    printf("Commands: motor set [-100..100], motor stop, motor max, motor inc, motor dec\r\n");
+    printf("Commands: motor set [-100..100], motor stop, motor max, motor inc, motor dec, motor ramp\r\n");
+    printf("Batch with ';', store with: macro set <name> \"cmd; cmd\"\r\n");
 
     // Create FreeRTOS tasks
     // Motor control is now interrupt-based, so no dedicated task needed
-    // Priority order: CommandProcessor (2) > StatusDisplay (1) > StatusLED (0)
-    xTaskCreate(TaskCommandProcessor, "CmdProc", 256, nullptr, 2, nullptr);
+    // Priority order: CommandProcessor, CmdAux (2) > StatusDisplay, CmdJob (1) > StatusLED (0)
+    xTaskCreate(TaskCommandProcessor, "CmdProc", 384, nullptr, 2, nullptr);
     xTaskCreate(TaskStatusDisplay, "StatusDisp", 256, nullptr, 1, nullptr);
     xTaskCreate(TaskStatusLED, "StatusLED", 128, nullptr, 0, nullptr);
+    xTaskCreate(TaskAuxCommands, "CmdAux", 384, nullptr, 2, nullptr);
 
     printf("FreeRTOS scheduler starting...\r\n");
     fprintf(&gLcdStream, "\fLab 4.2 Ready\nFreeRTOS active");
+    LCDStdio::flush();
 
     vTaskStartScheduler();
 
@@ -10,6 +10,7 @@
 #include "analog_sensor.h"
 #include "my_servo.h"
 #include "lcd_stdio.h"
+#include "fixed_format.h"
 
 // -----------------------------------------------------------------------------
 // Hardware configuration
@@ -63,11 +64,14 @@ static void updateStatusDisplay() {
     float voltage = potVoltage;
     int16_t angle = servoAngle;
     
+    char voltageText[8];
+    fixed_format::formatFloat(voltageText, sizeof(voltageText), voltage, 2, 1);
     fprintf(&gLcdStream,
-            "\fPot: %4u (%1.2fV)\nServo: %3d deg",
+            "\fPot: %4u (%sV)\nServo: %3d deg",
             rawAdc,
-            (double)voltage,
+            voltageText,
             angle);
+    LCDStdio::flush();
 }
 
 
@@ -215,9 +219,11 @@ void setup() {
     Wire.begin();
     LCDStdio::init(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
     LCDStdio::clear();
+    LCDStdio::setAutoFlush(false);  // Whole frames, flushed by updateStatusDisplay()
     fdev_setup_stream(&gLcdStream, lcdStreamPutchar, nullptr, _FDEV_SETUP_WRITE);
 
     fprintf(&gLcdStream, "\fLab 5.1 Ready\nInit FreeRTOS...");
+    LCDStdio::flush();
     printf("Lab 5.1: Servo Control System Ready\r\n");
     printf("Potentiometer controls servo angle (0-180 degrees)\r\n");
 
@@ -230,6 +236,7 @@ void setup() {
 
     printf("FreeRTOS scheduler starting...\r\n");
     fprintf(&gLcdStream, "\fLab 5.1 Ready\nFreeRTOS active");
+    LCDStdio::flush();
 
     vTaskStartScheduler();
 
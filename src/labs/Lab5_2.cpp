@@ -11,6 +11,7 @@
 #include "analog_sensor.h"
 #include "my_servo.h"
 #include "lcd_stdio.h"
+#include "fixed_format.h"
 
 // -----------------------------------------------------------------------------
 // Hardware configuration
@@ -65,11 +66,14 @@ static void updateStatusDisplay() {
     float voltage = potVoltage;
     int16_t angle = servoAngle;
     
+    char voltageText[8];
+    fixed_format::formatFloat(voltageText, sizeof(voltageText), voltage, 2, 1);
     fprintf(&gLcdStream,
-            "\fPot: %4u (%1.2fV)\nServo: %3d deg",
+            "\fPot: %4u (%sV)\nServo: %3d deg",
             rawAdc,
-            (double)voltage,
+            voltageText,
             angle);
+    LCDStdio::flush();
 }
 
 
@@ -231,13 +235,18 @@ void setup() {
     Wire.begin();
     LCDStdio::init(LCD_I2C_ADDRESS, LCD_COLUMNS, LCD_ROWS);
     LCDStdio::clear();
+    LCDStdio::setAutoFlush(false);  // Whole frames, flushed by updateStatusDisplay()
     fdev_setup_stream(&gLcdStream, lcdStreamPutchar, nullptr, _FDEV_SETUP_WRITE);
 
     fprintf(&gLcdStream, "\fLab 5.2 Ready\nInit FreeRTOS...");
+    LCDStdio::flush();
     printf("Lab 5.2: Smooth Servo Control System Ready\r\n");
     printf("Potentiometer controls servo angle (0-180 degrees)\r\n");
-    printf("Smoothing: factor=%.2f, deadband=%.1f deg\r\n", 
-           (double)SMOOTHING_FACTOR, (double)DEADBAND_DEGREES);
+    char factorText[8];
+    char deadbandText[8];
+    fixed_format::formatFloat(factorText, sizeof(factorText), SMOOTHING_FACTOR, 2);
+    fixed_format::formatFloat(deadbandText, sizeof(deadbandText), DEADBAND_DEGREES, 1);
+    printf("Smoothing: factor=%s, deadband=%s deg\r\n", factorText, deadbandText);
 
     // Create FreeRTOS tasks
     // Priority order: SensorRead (3) > ServoControl (2) > StatusDisplay (1) > StatusLED (0)
@@ -248,6 +257,7 @@ void setup() {
 
     printf("FreeRTOS scheduler starting...\r\n");
     fprintf(&gLcdStream, "\fLab 5.2 Ready\nFreeRTOS active");
+    LCDStdio::flush();
 
     vTaskStartScheduler();
 
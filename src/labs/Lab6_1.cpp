@@ -4,32 +4,21 @@
 #include <Arduino_FreeRTOS.h>
 #include <semphr.h>
 #include "fsm.h"
+#include "fsm_snapshot.h"
 #include "rtos_btn.h"
+#include "binlog_task.h"
+#include "Lab6_1_fsm.h"
 
 // -----------------------------------------------------------------------------
 // Hardware configuration
 // -----------------------------------------------------------------------------
-// Pin definitions (from diagram.json)
-constexpr uint8_t RED_LED_PIN = 5;
-constexpr uint8_t GREEN_LED_PIN = 4;
+// Pin definitions (from diagram.json), LED pins live in Lab6_1_fsm.h
 constexpr uint8_t BUTTON_PIN = 15;
 constexpr uint8_t STATUS_LED_PIN = 13;
 
 constexpr TickType_t FSM_UPDATE_PERIOD = pdMS_TO_TICKS(50);
 constexpr TickType_t STATUS_LED_BLINK_PERIOD = pdMS_TO_TICKS(1000);
-
-// -----------------------------------------------------------------------------
-// State IDs
-// -----------------------------------------------------------------------------
-enum LedStates {
-    STATE_RED_LED = 0,
-    STATE_GREEN_LED = 1
-};
-
-// Event IDs
-enum Events {
-    EVENT_BUTTON_PRESS = 1
-};
+constexpr TickType_t BINLOG_FLUSH_PERIOD = pdMS_TO_TICKS(100);
 
 // -----------------------------------------------------------------------------
 // Global objects
@@ -37,22 +26,17 @@ enum Events {
 static FSM gLedFsm;
 static RTOSButton gButton(BUTTON_PIN, true);  // Pullup enabled
 static SemaphoreHandle_t gFsmMutex = nullptr;
+static SemaphoreHandle_t gSerialMutex = nullptr;  // Binlog frames and trace dumps share Serial
 
-// -----------------------------------------------------------------------------
-// FSM State callbacks
-// -----------------------------------------------------------------------------
-// State callback: Red LED active
-void state_red_led_enter(FSM* fsm) {
-    digitalWrite(RED_LED_PIN, HIGH);
-    digitalWrite(GREEN_LED_PIN, LOW);
-    Serial.println("[FSM] State: RED LED ON");
-}
+// Survives watchdog/external resets so the LED state can be resumed
+static FSMSnapshot gLedFsmSnapshot FSM_SNAPSHOT_NOINIT;
 
-// State callback: Green LED active
-void state_green_led_enter(FSM* fsm) {
-    digitalWrite(RED_LED_PIN, LOW);
-    digitalWrite(GREEN_LED_PIN, HIGH);
-    Serial.println("[FSM] State: GREEN LED ON");
+// Binary log frames go out whole, never split by a trace dump
+static void binlogToSerial(const uint8_t* data, size_t length, void* context) {
+    (void) context;
+    xSemaphoreTake(gSerialMutex, portMAX_DELAY);
+    Serial.write(data, length);
+    xSemaphoreGive(gSerialMutex);
 }
 
 // -----------------------------------------------------------------------------
@@ -67,7 +51,9 @@ void TaskStatusLED(void *pvParameters);
 void TaskFsmProcessor(void *pvParameters) {
     (void) pvParameters;
     TickType_t lastWakeTime = xTaskGetTickCount();
+    xSemaphoreTake(gSerialMutex, portMAX_DELAY);
     Serial.println("[TaskFsmProcessor] Started.");
+    xSemaphoreGive(gSerialMutex);
     for (;;) {
         // Check for button press (thread-safe)
         if (gButton.consumePress()) {
@@ -84,6 +70,15 @@ void TaskFsmProcessor(void *pvParameters) {
             xSemaphoreGive(gFsmMutex);
         }
         
+#if FSM_TRACE_ENABLED
+        // Dump recorded transitions on request ('t'), decode with tools/fsm_trace_decode.py
+        if (Serial.available() && Serial.read() == 't') {
+            xSemaphoreTake(gSerialMutex, portMAX_DELAY);
+            fsm_trace_dump(Serial);
+            xSemaphoreGive(gSerialMutex);
+        }
+#endif
+        
         vTaskDelayUntil(&lastWakeTime, FSM_UPDATE_PERIOD);
     }
 }
@@ -109,6 +104,15 @@ void TaskStatusLED(void *pvParameters) {
 void setup() {
     Serial.begin(115200);
 
+    gSerialMutex = xSemaphoreCreateMutex();
+    if (gSerialMutex == nullptr) {
+        Serial.println("ERROR: Failed to create Serial mutex!");
+        while (1);  // Halt
+    }
+
+    // State changes are logged in binary, decode with tools/binlog_decode.py
+    binlog_init(binlogToSerial, nullptr);
+
     // Configure LED pins
     pinMode(RED_LED_PIN, OUTPUT);
     pinMode(GREEN_LED_PIN, OUTPUT);
@@ -125,23 +129,16 @@ void setup() {
         while (1);  // Halt
     }
     
-    // Initialize FSM
-    fsm_init(&gLedFsm, "LED_FSM");
-    
-    // Add states
-    fsm_add_state(&gLedFsm, STATE_RED_LED, "RED_LED", 
-                  state_red_led_enter, NULL, NULL);
-    fsm_add_state(&gLedFsm, STATE_GREEN_LED, "GREEN_LED", 
-                  state_green_led_enter, NULL, NULL);
+    // Initialize FSM (states and transitions from Lab6_1_fsm.h)
+    lab6_1_build_led_fsm(&gLedFsm);
     
-    // Add transitions (toggle between states on button press)
-    fsm_add_transition(&gLedFsm, STATE_RED_LED, STATE_GREEN_LED, 
-                       EVENT_BUTTON_PRESS, NULL, NULL);
-    fsm_add_transition(&gLedFsm, STATE_GREEN_LED, STATE_RED_LED, 
-                       EVENT_BUTTON_PRESS, NULL, NULL);
-    
-    // Start FSM in RED_LED state
-    fsm_start(&gLedFsm, STATE_RED_LED);
+    // Resume the state from before a warm reset, otherwise start in RED_LED
+    if (fsm_restore(&gLedFsm, &gLedFsmSnapshot, true)) {
+        Serial.println("FSM resumed from snapshot.");
+    } else {
+        fsm_start(&gLedFsm, STATE_RED_LED);
+    }
+    fsm_snapshot_attach(&gLedFsm, &gLedFsmSnapshot);
     
     Serial.println("FSM initialized. Press button to toggle LEDs.");
     
@@ -157,6 +154,7 @@ void setup() {
     // Priority order: ButtonMonitor (3) > FsmProcessor (2) > StatusLED (1)
     xTaskCreate(TaskFsmProcessor, "FsmProc", 256, nullptr, 3, nullptr);
     xTaskCreate(TaskStatusLED, "StatusLED", 128, nullptr, 1, nullptr);
+    binlog_start_task(0, 192, BINLOG_FLUSH_PERIOD);
     
     Serial.println("FreeRTOS scheduler starting...");
     
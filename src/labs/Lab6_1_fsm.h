@@ -0,0 +1,70 @@
+#ifndef LAB6_1_FSM_H
+#define LAB6_1_FSM_H
+
+// Lab 6.1 LED state machine definition.
+// Shared by Lab6_1.cpp and the host simulation harness (tools/host/fsm_sim.cpp)
+// so both exercise exactly the same states, transitions and callbacks.
+
+#include <Arduino.h>
+#include "fsm.h"
+#include "binlog.h"
+
+// -----------------------------------------------------------------------------
+// Hardware configuration
+// -----------------------------------------------------------------------------
+// Pin definitions (from diagram.json)
+constexpr uint8_t RED_LED_PIN = 5;
+constexpr uint8_t GREEN_LED_PIN = 4;
+
+// -----------------------------------------------------------------------------
+// State IDs
+// -----------------------------------------------------------------------------
+enum LedStates {
+    STATE_RED_LED = 0,
+    STATE_GREEN_LED = 1
+};
+
+// Event IDs
+enum Events {
+    EVENT_BUTTON_PRESS = 1
+};
+
+// -----------------------------------------------------------------------------
+// FSM State callbacks
+// -----------------------------------------------------------------------------
+// State callback: Red LED active
+static void state_red_led_enter(FSM* fsm) {
+    (void) fsm;
+    digitalWrite(RED_LED_PIN, HIGH);
+    digitalWrite(GREEN_LED_PIN, LOW);
+    BINLOG("[FSM] State: RED LED ON");
+}
+
+// State callback: Green LED active
+static void state_green_led_enter(FSM* fsm) {
+    (void) fsm;
+    digitalWrite(RED_LED_PIN, LOW);
+    digitalWrite(GREEN_LED_PIN, HIGH);
+    BINLOG("[FSM] State: GREEN LED ON");
+}
+
+// -----------------------------------------------------------------------------
+// FSM construction (states and transitions, not started)
+// -----------------------------------------------------------------------------
+static void lab6_1_build_led_fsm(FSM* fsm) {
+    fsm_init(fsm, "LED_FSM");
+
+    // Add states
+    fsm_add_state(fsm, STATE_RED_LED, "RED_LED",
+                  state_red_led_enter, NULL, NULL);
+    fsm_add_state(fsm, STATE_GREEN_LED, "GREEN_LED",
+                  state_green_led_enter, NULL, NULL);
+
+    // Add transitions (toggle between states on button press)
+    fsm_add_transition(fsm, STATE_RED_LED, STATE_GREEN_LED,
+                       EVENT_BUTTON_PRESS, NULL, NULL);
+    fsm_add_transition(fsm, STATE_GREEN_LED, STATE_RED_LED,
+                       EVENT_BUTTON_PRESS, NULL, NULL);
+}
+
+#endif // LAB6_1_FSM_H
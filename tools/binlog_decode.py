@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""Turn binary log frames produced by lib/binlog back into text.
+
+Records only carry the flash address of their format string, so the
+firmware ELF that produced the capture is needed to rebuild the messages
+(PlatformIO: .pio/build/<env>/firmware.elf). Text printed around the frames
+is passed through unchanged.
+
+Usage:
+  binlog_decode.py firmware.elf capture.bin          # decode a raw capture
+  binlog_decode.py firmware.elf --port COM5          # live, until Ctrl+C
+  binlog_decode.py firmware.elf capture.bin --no-text
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from frame_codec import decode_frame
+
+FRAME_KIND = ord("L")
+RECORD_HEADER = struct.Struct("<IHB")
+
+# AVR printf argument sizes after promotion (see lib/binlog/binlog.h)
+INT_SIZE = 2
+LONG_SIZE = 4
+FLOAT_SIZE = 4
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|t)?([diouxXcseEfgGp%])")
+
+
+class ElfFormatError(Exception):
+    pass
+
+
+# -----------------------------------------------------------------------------
+# ELF string lookup
+# -----------------------------------------------------------------------------
+class FirmwareStrings:
+    """Reads NUL-terminated strings from the loadable sections of an ELF file."""
+
+    SHT_PROGBITS = 1
+    SHF_ALLOC = 0x2
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF":
+            raise ElfFormatError("%s is not an ELF file" % path)
+        is64 = self.data[4] == 2
+        endian = "<" if self.data[5] == 1 else ">"
+
+        if is64:
+            shoff, = struct.unpack_from(endian + "Q", self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x3A)
+            header = struct.Struct(endian + "IIQQQQIIQQ")
+        else:
+            shoff, = struct.unpack_from(endian + "I", self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(endian + "HH", self.data, 0x2E)
+            header = struct.Struct(endian + "IIIIIIIIII")
+
+        self.sections = []
+        for i in range(shnum):
+            fields = header.unpack_from(self.data, shoff + i * shentsize)
+            sh_type, sh_flags, sh_addr, sh_offset, sh_size = fields[1:6]
+            if sh_type == self.SHT_PROGBITS and sh_flags & self.SHF_ALLOC:
+                self.sections.append((sh_addr, sh_offset, sh_size))
+        self.cache = {}
+
+    def string_at(self, address):
+        if address in self.cache:
+            return self.cache[address]
+        for base, offset, size in self.sections:
+            # Record IDs are 16-bit flash addresses
+            if (base & 0xFFFF0000) == 0 and base <= address < base + size:
+                start = offset + address - base
+                end = self.data.find(b"\x00", start, offset + size)
+                if end >= 0:
+                    text = self.data[start:end].decode("ascii", errors="replace")
+                    self.cache[address] = text
+                    return text
+        self.cache[address] = None
+        return None
+
+
+# -----------------------------------------------------------------------------
+# Formatting
+# -----------------------------------------------------------------------------
+def argument_sizes(fmt, int_size):
+    sizes = []
+    for match in CONVERSION.finditer(fmt):
+        length, conversion = match.group(4), match.group(5)
+        if conversion == "%":
+            continue
+        if conversion in "eEfgG":
+            sizes.append(("f", FLOAT_SIZE))
+        elif length == "l":
+            sizes.append(("i" if conversion in "di" else "u", LONG_SIZE))
+        else:
+            sizes.append(("i" if conversion in "dic" else "u", int_size))
+    return sizes
+
+
+def unpack_args(fmt, raw, int_size):
+    sizes = argument_sizes(fmt, int_size)
+    if sum(size for _, size in sizes) != len(raw):
+        return None
+    values = []
+    pos = 0
+    for kind, size in sizes:
+        chunk = raw[pos:pos + size]
+        pos += size
+        if kind == "f":
+            values.append(struct.unpack("<f", chunk)[0])
+        else:
+            values.append(int.from_bytes(chunk, "little", signed=(kind == "i")))
+    return values
+
+
+def render(fmt, values):
+    """printf-style rendering without C length modifiers."""
+    values = iter(values)
+
+    def convert(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+        spec = "%" + flags + width + ("." + precision if precision is not None else "")
+        value = next(values)
+        if conversion == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conversion == "p":
+            return (spec + "x") % value
+        if conversion == "s":
+            return (spec + "s") % value
+        return (spec + conversion) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def format_record(strings, address, raw, int_size):
+    fmt = strings.string_at(address)
+    if fmt is None:
+        return "<unknown format 0x%04x> %s" % (address, raw.hex())
+    values = unpack_args(fmt, raw, int_size)
+    if values is None:
+        return "<argument mismatch for \"%s\"> %s" % (fmt, raw.hex())
+    return render(fmt, values)
+
+
+# -----------------------------------------------------------------------------
+# Stream decoding
+# -----------------------------------------------------------------------------
+def parse_frame(body):
+    """Return (dropped, records) for a valid binlog frame body, else None."""
+    payload = decode_frame(body)
+    if payload is None or len(payload) < 3 or payload[0] != FRAME_KIND:
+        return None
+
+    dropped = struct.unpack_from("<H", payload, 1)[0]
+    records = []
+    pos = 3
+    while pos + RECORD_HEADER.size <= len(payload):
+        timestamp, address, length = RECORD_HEADER.unpack_from(payload, pos)
+        pos += RECORD_HEADER.size
+        records.append((timestamp, address, payload[pos:pos + length]))
+        pos += length
+    return dropped, records
+
+
+class Decoder:
+    def __init__(self, strings, out, show_text=True, int_size=INT_SIZE):
+        self.strings = strings
+        self.int_size = int_size
+        self.out = out
+        self.show_text = show_text
+        self.chunk = bytearray()
+        self.dropped = 0
+        self.records = 0
+
+    def feed(self, data):
+        for byte in data:
+            if byte != 0:
+                self.chunk.append(byte)
+                continue
+            self.segment(bytes(self.chunk))
+            self.chunk = bytearray()
+
+    def finish(self):
+        if self.chunk:
+            self.segment(bytes(self.chunk))
+            self.chunk = bytearray()
+
+    def segment(self, data):
+        if not data:
+            return
+        frame = parse_frame(data)
+        if frame is None:
+            # Text between (or instead of) frames
+            if self.show_text:
+                self.out.write(data.decode("ascii", errors="replace"))
+            return
+
+        dropped, records = frame
+        lost = (dropped - self.dropped) & 0xFFFF
+        if lost:
+            self.out.write("[binlog] %d records dropped\n" % lost)
+        self.dropped = dropped
+
+        for timestamp, address, raw in records:
+            self.records += 1
+            text = format_record(self.strings, address, raw, self.int_size)
+            self.out.write("[%10.6f] %s\n" % (timestamp / 1e6, text))
+        self.out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="firmware ELF the capture came from")
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--port", help="read from a serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--no-text", action="store_true", help="hide text outside frames")
+    parser.add_argument("--int-size", type=int, default=INT_SIZE,
+                        help="sizeof(int) on the target (default: %d, AVR)" % INT_SIZE)
+    args = parser.parse_args()
+
+    try:
+        strings = FirmwareStrings(args.elf)
+    except (OSError, ElfFormatError) as error:
+        sys.stderr.write("%s\n" % error)
+        return 2
+    decoder = Decoder(strings, sys.stdout, show_text=not args.no_text, int_size=args.int_size)
+
+    if args.port:
+        import serial  # pyserial
+
+        with serial.Serial(args.port, args.baud, timeout=0.1) as link:
+            try:
+                while True:
+                    decoder.feed(link.read(4096))
+            except KeyboardInterrupt:
+                pass
+    else:
+        if args.capture:
+            with open(args.capture, "rb") as f:
+                data = f.read()
+        else:
+            data = sys.stdin.buffer.read()
+        decoder.feed(data)
+    decoder.finish()
+
+    if decoder.records == 0 and not args.port:
+        sys.stderr.write("no binlog frames found\n")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
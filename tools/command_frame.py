@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Send binary command frames to a command_handler over serial.
+
+Frames are 0x00 + COBS(payload + CRC-16/CCITT-FALSE little endian) + 0x00,
+with payload = [command index][packed arguments]. The command index is the
+registration order of the command on the device (0 = first registered).
+
+Arguments are given as TYPE:VALUE and packed in order:
+  i32:-50      INT argument (int32 little endian)
+  fx2:1.25     FIXED argument with 2 decimals (scaled, int32 little endian)
+  u8:1         ENUM argument (choice index)
+  str:hello    STRING argument (uint8 length + bytes)
+  text:50      raw text arguments for commands registered without a schema
+
+Usage:
+  command_frame.py --port COM5 0 i32:50             # Lab 4.2: motor set 50
+  command_frame.py --port COM5 0 i32:50 --repeat 100 --quiet
+  command_frame.py --dump 0 i32:50 | xxd            # print the frame only
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from frame_codec import decode_frame, encode_frame
+
+STATUS = {
+    0: "OK",
+    1: "FAILED",
+    2: "UNKNOWN",
+    3: "BAD_ARGS",
+    4: "BAD_CRC",
+    5: "MALFORMED",
+}
+
+
+def pack_args(specs):
+    packed = bytearray()
+    for spec in specs:
+        kind, _, value = spec.partition(":")
+        if kind == "i32":
+            packed += struct.pack("<i", int(value, 0))
+        elif kind.startswith("fx"):
+            decimals = int(kind[2:])
+            packed += struct.pack("<i", int(round(float(value) * 10 ** decimals)))
+        elif kind == "u8":
+            packed += struct.pack("<B", int(value, 0))
+        elif kind == "str":
+            raw = value.encode("ascii")
+            packed += struct.pack("<B", len(raw)) + raw
+        elif kind == "text":
+            packed += value.encode("ascii")
+        else:
+            raise ValueError("unknown argument type '%s'" % kind)
+    return bytes(packed)
+
+
+def read_response(link, timeout):
+    """Return (command, status) of the next valid frame; text output is skipped."""
+    deadline = time.monotonic() + timeout
+    chunk = bytearray()
+    while time.monotonic() < deadline:
+        byte = link.read(1)
+        if not byte:
+            continue
+        if byte[0] != 0:
+            chunk += byte
+            continue
+        if chunk:
+            payload = decode_frame(bytes(chunk))
+            chunk = bytearray()
+            if payload is not None and len(payload) == 2:
+                return payload[0], payload[1]
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", type=lambda v: int(v, 0), help="command index")
+    parser.add_argument("args", nargs="*", help="TYPE:VALUE arguments")
+    parser.add_argument("--port", help="serial port")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=1.0, help="seconds to wait for a response")
+    parser.add_argument("--repeat", type=int, default=1)
+    parser.add_argument("--quiet", action="store_true", help="only print a summary")
+    parser.add_argument("--dump", action="store_true", help="write the frame to stdout and exit")
+    args = parser.parse_args()
+
+    frame = encode_frame(bytes([args.command]) + pack_args(args.args))
+    if args.dump:
+        sys.stdout.buffer.write(frame)
+        return 0
+    if not args.port:
+        parser.error("--port is required unless --dump is given")
+
+    import serial  # pyserial
+
+    failures = 0
+    start = time.monotonic()
+    with serial.Serial(args.port, args.baud, timeout=0.05) as link:
+        for _ in range(args.repeat):
+            link.write(frame)
+            response = read_response(link, args.timeout)
+            if response is None:
+                failures += 1
+                if not args.quiet:
+                    print("no response")
+                continue
+            command, status = response
+            if status != 0:
+                failures += 1
+            if not args.quiet:
+                print("command %d: %s" % (command, STATUS.get(status, status)))
+    elapsed = time.monotonic() - start
+    if args.repeat > 1:
+        print("%d frames, %d failed, %.1f frames/s" % (args.repeat, failures, args.repeat / elapsed))
+    return 0 if failures == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
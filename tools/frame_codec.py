@@ -0,0 +1,75 @@
+"""Host side of lib/frame_codec, shared by the frame tools in this directory.
+
+A frame on the wire is 0x00 + COBS(payload + CRC-16/CCITT-FALSE little
+endian) + 0x00. The scripts here import this module from their own
+directory, so keep it next to them.
+"""
+
+import struct
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_index = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+            continue
+        out.append(byte)
+        code += 1
+        if code == 0xFF:
+            out[code_index] = code
+            code_index = len(out)
+            out.append(0)
+            code = 1
+    out[code_index] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS block")
+        out.extend(data[i + 1:i + code])
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(payload):
+    """Return a complete frame, delimiters included."""
+    body = payload + struct.pack("<H", crc16(payload))
+    return b"\x00" + cobs_encode(body) + b"\x00"
+
+
+def decode_frame(body):
+    """Return the payload of a frame body (bytes between delimiters), or None
+    if the COBS encoding or the CRC is invalid."""
+    try:
+        data = cobs_decode(body)
+    except ValueError:
+        return None
+    if len(data) < 2:
+        return None
+    payload, crc = data[:-2], struct.unpack("<H", data[-2:])[0]
+    if crc16(payload) != crc:
+        return None
+    return payload
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Decode binary FSM transition traces produced by fsm_trace_dump().
+
+The dump is self-describing: it carries the FSM and state name tables, so no
+firmware sources are needed. Text printed around the dump (e.g. Serial.println
+output from the lab) is skipped.
+
+Usage:
+  fsm_trace_decode.py capture.bin                    # decode a raw capture
+  fsm_trace_decode.py --port COM5 --request t        # ask the board for a dump
+  fsm_trace_decode.py capture.bin --csv > trace.csv
+  fsm_trace_decode.py capture.bin --event 1=BUTTON_PRESS
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"FTRC"
+FORMAT_VERSION = 1
+EVENT_RESTORE = 0xFD
+EVENT_START = 0xFE
+EVENT_FORCE = 0xFF
+RECORD = struct.Struct("<IBBBB")
+
+
+class TraceFormatError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data, offset):
+        self.data = data
+        self.pos = offset
+
+    def take(self, count):
+        if self.pos + count > len(self.data):
+            raise TraceFormatError("truncated dump")
+        chunk = self.data[self.pos:self.pos + count]
+        self.pos += count
+        return chunk
+
+    def u8(self):
+        return self.take(1)[0]
+
+    def unpack(self, fmt):
+        return struct.unpack(fmt, self.take(struct.calcsize(fmt)))
+
+    def name(self):
+        return self.take(self.u8()).decode("ascii", errors="replace")
+
+
+def parse_dump(data, offset):
+    """Parse one dump starting at the magic; returns (tables, records, overwritten, end)."""
+    r = Reader(data, offset + len(MAGIC))
+    version = r.u8()
+    if version != FORMAT_VERSION:
+        raise TraceFormatError("unsupported trace version %d" % version)
+
+    tables = {}
+    for _ in range(r.u8()):
+        fsm_id = r.u8()
+        fsm_name = r.name()
+        states = {}
+        for _ in range(r.u8()):
+            state_id = r.u8()
+            states[state_id] = r.name()
+        tables[fsm_id] = (fsm_name, states)
+
+    count, overwritten = r.unpack("<HI")
+    records = [RECORD.unpack(r.take(RECORD.size)) for _ in range(count)]
+    return tables, records, overwritten, r.pos
+
+
+def find_dumps(data):
+    pos = data.find(MAGIC)
+    while pos >= 0:
+        try:
+            tables, records, overwritten, end = parse_dump(data, pos)
+        except TraceFormatError:
+            pos = data.find(MAGIC, pos + 1)
+            continue
+        yield tables, records, overwritten
+        pos = data.find(MAGIC, end)
+
+
+def event_label(event, event_names):
+    if event == EVENT_RESTORE:
+        return "RESTORE"
+    if event == EVENT_START:
+        return "START"
+    if event == EVENT_FORCE:
+        return "FORCE"
+    return event_names.get(event, str(event))
+
+
+def decode(data, event_names, csv_output, out):
+    dumps = 0
+    if csv_output:
+        out.write("time_us,delta_us,fsm,from,to,event\n")
+    for tables, records, overwritten in find_dumps(data):
+        dumps += 1
+        if not csv_output:
+            out.write("--- dump %d: %d records, %d overwritten ---\n"
+                      % (dumps, len(records), overwritten))
+        previous = None
+        for timestamp, fsm_id, from_state, to_state, event in records:
+            fsm_name, states = tables.get(fsm_id, ("fsm%d" % fsm_id, {}))
+            delta = 0 if previous is None else (timestamp - previous) & 0xFFFFFFFF
+            previous = timestamp
+            row = (timestamp, delta, fsm_name,
+                   states.get(from_state, str(from_state)),
+                   states.get(to_state, str(to_state)),
+                   event_label(event, event_names))
+            if csv_output:
+                out.write("%d,%d,%s,%s,%s,%s\n" % row)
+            else:
+                out.write("%12d us  +%-9d %-12s %s -> %s  [%s]\n" % row)
+    return dumps
+
+
+def read_port(port, baud, request, timeout):
+    import serial  # pyserial
+
+    with serial.Serial(port, baud, timeout=timeout) as link:
+        if request:
+            link.write(request.encode("ascii"))
+        data = bytearray()
+        while True:
+            chunk = link.read(4096)
+            if not chunk:
+                break
+            data.extend(chunk)
+    return bytes(data)
+
+
+def parse_event_names(pairs):
+    names = {}
+    for pair in pairs:
+        value, _, name = pair.partition("=")
+        names[int(value, 0)] = name
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--port", help="read from a serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--request", help="bytes to send to trigger a dump (e.g. 't')")
+    parser.add_argument("--timeout", type=float, default=1.0,
+                        help="seconds of silence that end a serial capture")
+    parser.add_argument("--event", action="append", default=[], metavar="ID=NAME",
+                        help="name an event ID (repeatable)")
+    parser.add_argument("--csv", action="store_true", help="emit CSV")
+    args = parser.parse_args()
+
+    if args.port:
+        data = read_port(args.port, args.baud, args.request, args.timeout)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    if decode(data, parse_event_names(args.event), args.csv, sys.stdout) == 0:
+        sys.stderr.write("no trace dump found\n")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,204 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Minimal Arduino core for building lab libraries natively on Linux.
+// Put tools/host first on the include path so lib/ code picks this up
+// instead of the AVR core. Time comes from a virtual clock that only moves
+// when the harness advances it, so runs are deterministic.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+// -----------------------------------------------------------------------------
+// Virtual clock
+// -----------------------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+/**
+ * Move the virtual clock forward
+ */
+void host_clock_advance_us(uint64_t us);
+void host_clock_advance_ms(uint32_t ms);
+
+/**
+ * Jump the virtual clock to an absolute time (used to test wrap-around)
+ */
+void host_clock_set_us(uint64_t us);
+
+// -----------------------------------------------------------------------------
+// GPIO (recorded, not driven)
+// -----------------------------------------------------------------------------
+#define HOST_NUM_PINS 70
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+/**
+ * Inject an input level seen by digitalRead()
+ */
+void host_pin_set_input(uint8_t pin, uint8_t value);
+
+/**
+ * Number of digitalWrite() calls seen on a pin since the last reset
+ */
+uint32_t host_pin_write_count(uint8_t pin);
+void host_pins_reset();
+
+// Critical sections are no-ops: the harness is single threaded
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// -----------------------------------------------------------------------------
+// stdio streams (avr-libc fdev_*)
+// -----------------------------------------------------------------------------
+// avr-libc streams are FILE objects owned by the caller and driven by
+// put/get callbacks. glibc FILE objects cannot be set up that way, so on the
+// host fdev_setup_stream() only records the callbacks and host_fdev_open()
+// returns a real stream (fopencookie) that drives them, e.g.
+//   initSerialStdio(115200);
+//   stdout = host_fdev_open(stdout, "w");
+#define _FDEV_SETUP_READ  0x01
+#define _FDEV_SETUP_WRITE 0x02
+#define _FDEV_SETUP_RW    (_FDEV_SETUP_READ | _FDEV_SETUP_WRITE)
+#define _FDEV_ERR (-1)
+#define _FDEV_EOF (-2)
+
+typedef int (*HostFdevPut)(char c, FILE* stream);
+typedef int (*HostFdevGet)(FILE* stream);
+
+void host_fdev_setup(FILE* stream, HostFdevPut put, HostFdevGet get);
+#define fdev_setup_stream(stream, put, get, rwflag) host_fdev_setup((stream), (put), (get))
+
+/**
+ * Stream driving the callbacks recorded for an fdev stream
+ * @return nullptr if the stream was never set up
+ */
+FILE* host_fdev_open(FILE* stream, const char* mode);
+
+// -----------------------------------------------------------------------------
+// Print / Serial
+// -----------------------------------------------------------------------------
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t write(const char* str) {
+        return str != NULL ? write(reinterpret_cast<const uint8_t*>(str), strlen(str)) : 0;
+    }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const __FlashStringHelper* str) { return write(reinterpret_cast<const char*>(str)); }
+    size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(unsigned char value, int base = DEC) { return printUnsigned(value, base); }
+    size_t print(unsigned int value, int base = DEC) { return printUnsigned(value, base); }
+    size_t print(unsigned long value, int base = DEC) { return printUnsigned(value, base); }
+    size_t print(int value, int base = DEC) { return printSigned(value, base); }
+    size_t print(long value, int base = DEC) { return printSigned(value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return write(reinterpret_cast<const uint8_t*>("\r\n"), 2); }
+
+    template <typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+
+    template <typename T>
+    size_t println(T value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+private:
+    size_t printUnsigned(unsigned long value, int base);
+    size_t printSigned(long value, int base);
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual void flush() {}
+};
+
+/**
+ * Byte transport behind Serial (e.g. a pseudo-terminal, see host_pty.h)
+ */
+class SerialBackend {
+public:
+    virtual ~SerialBackend() {}
+    virtual size_t write(uint8_t value) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual int availableForWrite() = 0;
+};
+
+/**
+ * Host Serial: output is captured in memory and optionally echoed to stdout,
+ * input is fed by the harness; with a backend set, both go through it instead.
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud) { (void) baud; }
+    operator bool() const { return true; }
+
+    size_t write(uint8_t value) override;
+    using Print::write;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite();
+
+    // Harness controls
+    void setBackend(SerialBackend* backend) { backend_ = backend; }
+    void setEcho(bool echo) { echo_ = echo; }
+    void feed(const char* data);
+    const char* captured() const { return captured_; }
+    size_t capturedLength() const { return capturedLength_; }
+    void clearCaptured();
+
+private:
+    static constexpr size_t CAPTURE_SIZE = 64 * 1024;
+    static constexpr size_t INPUT_SIZE = 4096;
+
+    SerialBackend* backend_ = nullptr;
+    bool echo_ = false;
+    char captured_[CAPTURE_SIZE + 1] = {0};
+    size_t capturedLength_ = 0;
+    char input_[INPUT_SIZE] = {0};
+    size_t inputHead_ = 0;
+    size_t inputTail_ = 0;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,28 @@
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+// RAM-backed EEPROM for host builds (ATmega2560 size, erased to 0xFF)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x0FFF
+
+void eeprom_read_block(void* dst, const void* src, size_t size);
+void eeprom_write_block(const void* src, void* dst, size_t size);
+void eeprom_update_block(const void* src, void* dst, size_t size);
+uint8_t eeprom_read_byte(const uint8_t* address);
+void eeprom_write_byte(uint8_t* address, uint8_t value);
+void eeprom_update_byte(uint8_t* address, uint8_t value);
+
+/**
+ * Erase the emulated EEPROM and reset the write counter
+ */
+void host_eeprom_reset();
+
+/**
+ * Number of bytes physically written (update skips unchanged bytes)
+ */
+uint32_t host_eeprom_write_count();
+
+#endif // HOST_AVR_EEPROM_H
@@ -0,0 +1,455 @@
+// Host-side throughput and latency benchmark for lib/command_handler
+//
+// Pushes command streams byte by byte through commandHandlerProcessChar(),
+// the same path the labs feed from their serial tasks, and reports:
+//   - commands per second and bytes per second
+//   - average and worst-case time per command (first byte to dispatch)
+// for synthetic tables of 4 to 64 commands, plus a recorded Lab 4.2 session.
+//
+// Every run is self-checking: each line must reach the expected callback
+// with the expected arguments (or the unknown-command callback), and the
+// per-command cost at 64 commands must stay within SCALING_LIMIT times the
+// cost at 4 commands, which a linear-scan lookup would exceed. Each table is
+// timed SCALING_RUNS times and the fastest run counts, so a busy machine
+// does not fail the check. Any failure makes the exit status nonzero;
+// tools/host/CMakeLists.txt runs it under ctest with the other harnesses.
+//
+// Build (from the repo root, one command; or through tools/host/CMakeLists.txt):
+//   g++ -std=gnu++11 -O2 -Wall -Wextra -DMAX_COMMANDS=64
+//       -Itools/host -Ilib/command_handler -Ilib/frame_codec
+//       tools/host/command_bench.cpp tools/host/host_arduino.cpp
+//       lib/command_handler/command_handler.cpp lib/frame_codec/frame_codec.cpp
+//       -o command_bench
+//
+// Usage:
+//   command_bench                           recorded session and synthetic sweep
+//   command_bench synth [lines] [seed]      synthetic sweep (default: 200000 1)
+//   command_bench replay <file|->           recorded stream against the Lab 4.2 table
+//
+// Recorded streams are plain terminal input: one command line per line,
+// '\r' or '\n' terminated, as captured from the serial port.
+
+#include <Arduino.h>
+#include "command_handler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+static_assert(MAX_COMMANDS >= 64, "Build with -DMAX_COMMANDS=64 to bench the largest table");
+
+// Worst allowed ns/command ratio between the 64- and the 4-command table
+static const double SCALING_LIMIT = 4.0;
+
+// Timed runs per table; the fastest one is compared
+static const uint8_t SCALING_RUNS = 3;
+
+// -----------------------------------------------------------------------------
+// Call recording
+// -----------------------------------------------------------------------------
+// Callbacks only record what they received, so the numbers measure lookup
+// and argument parsing rather than output.
+struct CallLog {
+    uint32_t calls;
+    uint32_t unknown;
+    int32_t lastCommand;          // Command index passed as context, -1 for unknown
+    int32_t lastValue;            // First typed argument
+    bool lastHadArgs;
+};
+
+static CallLog gLog;
+
+// Handler error and usage output is discarded so it neither costs terminal
+// time nor interleaves with the report
+static FILE* gQuiet = NULL;
+
+static void quiet_output(CommandHandler* handler) {
+    if (gQuiet == NULL) {
+        gQuiet = fopen("/dev/null", "w");
+    }
+    commandInputInit(&handler->input, gQuiet);
+}
+
+static bool on_text(void* context, const char* args) {
+    gLog.calls++;
+    gLog.lastCommand = static_cast<int32_t>(reinterpret_cast<intptr_t>(context));
+    gLog.lastHadArgs = args != NULL;
+    return true;
+}
+
+static bool on_typed(void* context, const CommandArg* args, uint8_t argCount) {
+    gLog.calls++;
+    gLog.lastCommand = static_cast<int32_t>(reinterpret_cast<intptr_t>(context));
+    gLog.lastValue = argCount > 0 ? args[0].value : 0;
+    gLog.lastHadArgs = argCount > 0;
+    return true;
+}
+
+static bool on_unknown(void* context, const char* command) {
+    (void) context;
+    (void) command;
+    gLog.unknown++;
+    gLog.lastCommand = -1;
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Command tables
+// -----------------------------------------------------------------------------
+// Synthetic names are "<device> <action>" pairs, so larger tables share long
+// prefixes the way real multi-word command sets do.
+static const char* const DEVICES[] = {"motor", "relay", "led", "servo", "pump", "fan", "heater", "valve"};
+static const char* const ACTIONS[] = {"set", "get", "on", "off", "inc", "dec", "stop", "start"};
+
+static const CommandArgSpec VALUE_ARGS[] = {
+    COMMAND_ARG_INT("value", -1000, 1000),
+};
+
+struct BenchCommand {
+    std::string name;
+    bool typed;
+};
+
+struct BenchTable {
+    std::vector<BenchCommand> commands;   // Names must outlive the handler
+    CommandHandler handler;
+};
+
+static bool build_table(BenchTable* table, uint8_t count) {
+    table->commands.clear();
+    table->commands.reserve(count);
+    for (uint8_t i = 0; i < count; i++) {
+        BenchCommand command;
+        command.name = std::string(DEVICES[i / 8]) + " " + ACTIONS[i % 8];
+        command.typed = (i % 8) == 0 || (i % 8) == 4;   // "set" and "inc" take a value
+        table->commands.push_back(command);
+    }
+
+    commandHandlerInit(&table->handler, on_unknown, NULL);
+    quiet_output(&table->handler);
+    for (uint8_t i = 0; i < count; i++) {
+        const BenchCommand& command = table->commands[i];
+        void* context = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+        bool ok = command.typed
+                      ? commandHandlerRegisterTyped(&table->handler, command.name.c_str(), on_typed,
+                                                    VALUE_ARGS, 1, context, NULL)
+                      : commandHandlerRegister(&table->handler, command.name.c_str(), on_text, context, NULL);
+        if (!ok) {
+            fprintf(stderr, "FAIL: could not register '%s'\n", command.name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Streams
+// -----------------------------------------------------------------------------
+struct BenchLine {
+    std::string text;             // Including the terminator
+    int32_t command;              // Expected command index, -1 for unknown
+    int32_t value;                // Expected typed value
+};
+
+/**
+ * Random lines over the table: 90% known commands with valid arguments,
+ * the rest unknown names that share a known prefix
+ */
+static std::vector<BenchLine> synthetic_stream(const BenchTable& table, uint32_t lines, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<BenchLine> stream;
+    stream.reserve(lines);
+
+    for (uint32_t i = 0; i < lines; i++) {
+        BenchLine line;
+        uint32_t pick = rng() % table.commands.size();
+        const BenchCommand& command = table.commands[pick];
+
+        if (rng() % 10 == 0) {
+            line.text = std::string(DEVICES[pick / 8]) + " bogus";
+            line.command = -1;
+            line.value = 0;
+        } else if (command.typed) {
+            line.value = static_cast<int32_t>(rng() % 2001) - 1000;
+            line.text = command.name + " " + std::to_string(line.value);
+            line.command = static_cast<int32_t>(pick);
+        } else {
+            line.text = command.name;
+            line.command = static_cast<int32_t>(pick);
+            line.value = 0;
+        }
+        // Terminals send "\r", captures often "\r\n"; mix both
+        line.text += (i & 1) ? "\r" : "\r\n";
+        stream.push_back(line);
+    }
+    return stream;
+}
+
+// -----------------------------------------------------------------------------
+// Runner
+// -----------------------------------------------------------------------------
+struct BenchResult {
+    uint32_t lines;
+    uint64_t bytes;
+    double totalNs;
+    double worstNs;
+    uint32_t failures;
+};
+
+static uint32_t gReported = 0;
+
+static void mismatch(uint32_t index, const BenchLine& line, const char* what) {
+    if (gReported++ < 10) {
+        std::string shown = line.text.substr(0, line.text.find_first_of("\r\n"));
+        fprintf(stderr, "FAIL line %u '%s': %s\n", index, shown.c_str(), what);
+    }
+}
+
+/**
+ * Feed every line and time it from its first byte to its terminator
+ * @param checked Compare each dispatch against the expected command and value
+ */
+static BenchResult run_stream(CommandHandler* handler, const std::vector<BenchLine>& stream, bool checked) {
+    BenchResult result = {0, 0, 0.0, 0.0, 0};
+
+    for (uint32_t i = 0; i < stream.size(); i++) {
+        const BenchLine& line = stream[i];
+        CallLog before = gLog;
+
+        auto start = std::chrono::steady_clock::now();
+        for (char c : line.text) {
+            commandHandlerProcessChar(handler, c);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        result.totalNs += ns;
+        result.worstNs = std::max(result.worstNs, ns);
+        result.bytes += line.text.size();
+        result.lines++;
+
+        // One outcome per line; recorded lines may also be rejected for bad
+        // arguments, which runs no callback at all
+        uint32_t outcomes = (gLog.calls - before.calls) + (gLog.unknown - before.unknown);
+        if (outcomes > 1 || (checked && outcomes != 1)) {
+            result.failures++;
+            mismatch(i, line, "unexpected number of dispatches");
+        } else if (checked && gLog.lastCommand != line.command) {
+            result.failures++;
+            mismatch(i, line, "dispatched to the wrong command");
+        } else if (checked && line.command >= 0 && gLog.lastHadArgs && gLog.lastValue != line.value) {
+            result.failures++;
+            mismatch(i, line, "typed argument value differs");
+        }
+    }
+    return result;
+}
+
+static void print_header(const char* title) {
+    printf("%s\n", title);
+    printf("%-10s %8s %10s %10s %10s %10s %8s\n",
+           "table", "lines", "cmd/s", "MB/s", "ns/cmd", "worst ns", "fail");
+}
+
+static void print_result(const char* label, const BenchResult& r) {
+    double seconds = r.totalNs / 1e9;
+    printf("%-10s %8u %10.0f %10.2f %10.1f %10.0f %8u\n", label, r.lines,
+           r.lines / seconds, r.bytes / seconds / 1e6, r.totalNs / r.lines, r.worstNs, r.failures);
+}
+
+static int run_synthetic(uint32_t lines, uint32_t seed) {
+    static const uint8_t SIZES[] = {4, 8, 16, 32, 64};
+    static BenchTable table;
+
+    print_header("synthetic stream");
+    int status = 0;
+    double firstNs = 0.0;
+    double lastNs = 0.0;
+
+    for (uint8_t size : SIZES) {
+        if (!build_table(&table, size)) {
+            return 1;
+        }
+        std::vector<BenchLine> stream = synthetic_stream(table, lines, seed);
+
+        run_stream(&table.handler, stream, true);  // Warm-up (caches, branch predictors)
+        BenchResult r = run_stream(&table.handler, stream, true);
+        uint32_t failures = r.failures;
+        for (uint8_t run = 1; run < SCALING_RUNS; run++) {
+            BenchResult again = run_stream(&table.handler, stream, true);
+            failures += again.failures;
+            if (again.totalNs < r.totalNs) {
+                r = again;
+            }
+        }
+        r.failures = failures;
+
+        char label[16];
+        snprintf(label, sizeof(label), "%u cmds", size);
+        print_result(label, r);
+
+        if (r.failures > 0) {
+            status = 1;
+        }
+        double ns = r.totalNs / r.lines;
+        if (size == SIZES[0]) {
+            firstNs = ns;
+        }
+        lastNs = ns;
+    }
+
+    double scaling = lastNs / firstNs;
+    printf("scaling 64/4 commands: %.2fx (limit %.1fx)\n\n", scaling, SCALING_LIMIT);
+    if (scaling > SCALING_LIMIT) {
+        fprintf(stderr, "FAIL: per-command cost grows too fast with the table size\n");
+        status = 1;
+    }
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// Recorded session (Lab 4.2 command set)
+// -----------------------------------------------------------------------------
+static const char* const LAB4_2_NAMES[] = {
+    "motor set", "motor stop", "motor max", "motor inc", "motor dec", "status",
+};
+
+static const CommandArgSpec MOTOR_SET_ARGS[] = {
+    COMMAND_ARG_INT("power", -100, 100),
+};
+
+// Typical operator session, typos and unknown commands included
+static const char* const DEFAULT_RECORDING =
+    "status\r\n"
+    "motor set 50\r\n"
+    "motor inc\r\n"
+    "motor inc\r\n"
+    "status\r\n"
+    "motor dec\r\n"
+    "motor set -30\r\n"
+    "motr stop\r\n"
+    "motor stop\r\n"
+    "MOTOR MAX\r\n"
+    "motor   set   100\r\n"
+    "motor set 0\r\n"
+    "statuss\r\n"
+    "status\r\n";
+
+static void build_lab4_2_table(CommandHandler* handler) {
+    commandHandlerInit(handler, on_unknown, NULL);
+    quiet_output(handler);
+    for (size_t i = 0; i < sizeof(LAB4_2_NAMES) / sizeof(LAB4_2_NAMES[0]); i++) {
+        void* context = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+        if (i == 0) {
+            commandHandlerRegisterTyped(handler, LAB4_2_NAMES[i], on_typed, MOTOR_SET_ARGS, 1, context, NULL);
+        } else {
+            commandHandlerRegister(handler, LAB4_2_NAMES[i], on_text, context, NULL);
+        }
+    }
+}
+
+static std::vector<BenchLine> split_recording(const std::string& text) {
+    std::vector<BenchLine> stream;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find_first_of("\r\n", start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        size_t next = text.find_first_not_of("\r\n", end);
+        if (next == std::string::npos) {
+            next = text.size();
+        }
+
+        // Blank lines do not dispatch anything, so they are not timed
+        if (text.find_first_not_of(" \t", start) < end) {
+            BenchLine line;
+            line.text = text.substr(start, next - start);
+            if (line.text.find_first_of("\r\n") == std::string::npos) {
+                line.text += "\r";
+            }
+            line.command = -1;
+            line.value = 0;
+            stream.push_back(line);
+        }
+        start = next;
+    }
+    return stream;
+}
+
+static int run_replay(const std::string& text, const char* source, uint32_t repeat) {
+    static CommandHandler handler;
+    build_lab4_2_table(&handler);
+
+    std::vector<BenchLine> once = split_recording(text);
+    if (once.empty()) {
+        fprintf(stderr, "FAIL: no commands in %s\n", source);
+        return 1;
+    }
+    std::vector<BenchLine> stream;
+    for (uint32_t i = 0; i < repeat; i++) {
+        stream.insert(stream.end(), once.begin(), once.end());
+    }
+
+    char title[96];
+    snprintf(title, sizeof(title), "recorded stream %s (%u lines x %u)",
+             source, static_cast<unsigned>(once.size()), repeat);
+    print_header(title);
+
+    run_stream(&handler, stream, false);
+    BenchResult r = run_stream(&handler, stream, false);
+    print_result("lab4_2", r);
+    printf("\n");
+    return r.failures > 0 ? 1 : 0;
+}
+
+static int run_replay_file(const char* path) {
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 2;
+    }
+    std::string text;
+    char chunk[512];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return run_replay(text, path, 1000);
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+static uint32_t arg_u32(int argc, char** argv, int index, uint32_t fallback) {
+    return index < argc ? static_cast<uint32_t>(strtoul(argv[index], NULL, 0)) : fallback;
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+
+    if (strcmp(mode, "synth") == 0) {
+        return run_synthetic(arg_u32(argc, argv, 2, 200000), arg_u32(argc, argv, 3, 1));
+    }
+    if (strcmp(mode, "replay") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "usage: %s replay <file|->\n", argv[0]);
+            return 2;
+        }
+        return run_replay_file(argv[2]);
+    }
+    if (strcmp(mode, "all") != 0) {
+        fprintf(stderr, "usage: %s [synth|replay] ...\n", argv[0]);
+        return 2;
+    }
+
+    int status = run_replay(DEFAULT_RECORDING, "<built-in>", 10000);
+    status |= run_synthetic(200000, 1);
+    printf("%s\n", status == 0 ? "PASS" : "FAIL");
+    return status;
+}
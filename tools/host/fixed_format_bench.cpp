@@ -0,0 +1,286 @@
+// Host-side check and benchmark for lib/fixed_format
+//
+// Compares every helper against the printf conversion it replaces:
+//   - formatInt/formatUint against "%*ld"/"%0*lu"/"%-*ld"/"%+*ld"
+//   - formatFixed against "%*.*f" of scaled / 10^decimals
+//   - formatFloat against "%*.*f", allowing the last digit to differ only
+//     when the value sits exactly on a half (printf rounds those to even)
+//   - buffer truncation and snprintf-style return values
+// then times the lab status lines (Lab 3.1, 3.2 and 5.x) built with
+// fixed_format against the same lines built with snprintf.
+//
+// Build (from the repo root, one command; or through tools/host/CMakeLists.txt):
+//   g++ -std=gnu++11 -O2 -Wall -Wextra
+//       -Itools/host -Ilib/fixed_format
+//       tools/host/fixed_format_bench.cpp tools/host/host_arduino.cpp
+//       lib/fixed_format/fixed_format.cpp
+//       -o fixed_format_bench
+//
+// Usage:
+//   fixed_format_bench                   conformance checks and bench
+//   fixed_format_bench check [seed]      conformance checks only
+//   fixed_format_bench bench [lines]     status line bench (default: 1000000)
+//
+// Host timings only rank the two approaches; on the AVR the gap is wider
+// because the float vfprintf does its conversion in software doubles.
+
+#include <Arduino.h>
+#include "fixed_format.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+
+using namespace fixed_format;
+
+static uint32_t gFailures = 0;
+
+static void expect_equal(const char* what, const char* got, const char* expected) {
+    if (strcmp(got, expected) != 0) {
+        if (gFailures < 10) {
+            fprintf(stderr, "FAIL %s: got '%s', expected '%s'\n", what, got, expected);
+        }
+        gFailures++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Conformance
+// -----------------------------------------------------------------------------
+static const uint8_t FLAG_SETS[] = {0, ALIGN_LEFT, PAD_ZERO, FORCE_SIGN, PAD_ZERO | FORCE_SIGN};
+
+static void printf_spec(char* spec, size_t size, uint8_t flags, const char* conversion) {
+    snprintf(spec, size, "%%%s%s%s*%s",
+             (flags & ALIGN_LEFT) ? "-" : "",
+             (flags & FORCE_SIGN) ? "+" : "",
+             (flags & PAD_ZERO) ? "0" : "",
+             conversion);
+}
+
+static void check_integers(std::mt19937& rng) {
+    static const int32_t EDGES[] = {0, 1, -1, 9, 10, -10, 99, 1023, -32768, INT32_MAX, INT32_MIN};
+
+    for (uint32_t i = 0; i < 200000; i++) {
+        int32_t value = i < sizeof(EDGES) / sizeof(EDGES[0])
+                            ? EDGES[i]
+                            : static_cast<int32_t>(rng()) >> (rng() % 31);
+        uint8_t width = rng() % 14;
+        uint8_t flags = FLAG_SETS[rng() % sizeof(FLAG_SETS)];
+
+        char spec[16];
+        char got[32];
+        char expected[32];
+
+        printf_spec(spec, sizeof(spec), flags, "ld");
+        formatInt(got, sizeof(got), value, width, flags);
+        snprintf(expected, sizeof(expected), spec, width, static_cast<long>(value));
+        expect_equal("formatInt", got, expected);
+
+        // Unsigned conversions have no sign
+        uint8_t unsignedFlags = flags & ~FORCE_SIGN;
+        printf_spec(spec, sizeof(spec), unsignedFlags, "lu");
+        formatUint(got, sizeof(got), static_cast<uint32_t>(value), width, unsignedFlags);
+        snprintf(expected, sizeof(expected), spec, width, static_cast<unsigned long>(static_cast<uint32_t>(value)));
+        expect_equal("formatUint", got, expected);
+    }
+}
+
+static void check_fixed(std::mt19937& rng) {
+    for (uint32_t i = 0; i < 200000; i++) {
+        int32_t scaled = static_cast<int32_t>(rng()) >> (rng() % 31);
+        uint8_t decimals = rng() % (MAX_DECIMALS + 1);
+        uint8_t width = rng() % 16;
+        uint8_t flags = FLAG_SETS[rng() % sizeof(FLAG_SETS)];
+
+        char spec[16];
+        char got[32];
+        char expected[32];
+
+        // The double nearest scaled / 10^d prints back as exactly scaled
+        printf_spec(spec, sizeof(spec), flags, ".*f");
+        formatFixed(got, sizeof(got), scaled, decimals, width, flags);
+        snprintf(expected, sizeof(expected), spec, width, decimals,
+                 static_cast<double>(scaled) / std::pow(10.0, decimals));
+        // printf keeps the sign of a negative value that rounds to zero
+        if (scaled == 0 || std::string(expected).find_first_of("123456789") != std::string::npos) {
+            expect_equal("formatFixed", got, expected);
+        }
+    }
+}
+
+static void check_float(std::mt19937& rng) {
+    uint32_t boundary = 0;
+
+    // value * 10^decimals beyond 2^24 must not lose digits
+    char large[32];
+    formatFloat(large, sizeof(large), 999999.9f, 1);
+    expect_equal("formatFloat large", large, "999999.9");
+    formatFloat(large, sizeof(large), 123456.79f, 2);
+    expect_equal("formatFloat large", large, "123456.79");
+    formatFloat(large, sizeof(large), -16777215.0f, 2);
+    expect_equal("formatFloat large", large, "-16777215.00");
+
+    for (uint32_t i = 0; i < 200000; i++) {
+        float value = std::ldexp(static_cast<float>(static_cast<int32_t>(rng() % 2000001) - 1000000), -(rng() % 16));
+        uint8_t decimals = rng() % 4;
+
+        char got[32];
+        char expected[32];
+        formatFloat(got, sizeof(got), value, decimals, 6);
+        snprintf(expected, sizeof(expected), "%6.*f", decimals, static_cast<double>(value));
+
+        if (strcmp(got, expected) != 0) {
+            // Only a value on (or within float rounding of) a half may differ:
+            // printf rounds exact halves to even, toFixed() away from zero
+            double scaled = std::fabs(static_cast<double>(value)) * std::pow(10.0, decimals);
+            double fraction = scaled - std::floor(scaled);
+            bool onBoundary = std::fabs(fraction - 0.5) < 1e-9;
+            bool negativeZero = std::string(expected).find_first_of("123456789") == std::string::npos;
+            if (onBoundary || negativeZero) {
+                boundary++;
+            } else {
+                expect_equal("formatFloat", got, expected);
+            }
+        }
+    }
+    printf("formatFloat: %u boundary roundings differ from printf (allowed)\n", boundary);
+}
+
+static void check_truncation() {
+    char buffer[6];
+    memset(buffer, 'x', sizeof(buffer));
+
+    size_t length = formatFixed(buffer, sizeof(buffer), -123456, 3, 10);
+    expect_equal("truncated", buffer, "  -12");
+    if (length != 10) {
+        fprintf(stderr, "FAIL truncated length: %zu\n", length);
+        gFailures++;
+    }
+    if (formatInt(buffer, 0, 42) != 2) {
+        fprintf(stderr, "FAIL zero-size buffer length\n");
+        gFailures++;
+    }
+}
+
+static int run_checks(uint32_t seed) {
+    std::mt19937 rng(seed);
+    gFailures = 0;
+
+    check_integers(rng);
+    check_fixed(rng);
+    check_float(rng);
+    check_truncation();
+
+    printf("conformance: %s (%u failures)\n\n", gFailures == 0 ? "ok" : "FAILED", gFailures);
+    return gFailures == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Status line bench
+// -----------------------------------------------------------------------------
+// Volatile sink so the compiler cannot drop the formatting
+static volatile char gSink;
+
+static size_t lab3_1_printf(char* line, size_t size, uint16_t raw, float voltage, uint16_t position) {
+    return snprintf(line, size, "Pot: %4u (%1.2fV) | LED Position: %2u/%u\r\n",
+                    raw, static_cast<double>(voltage), position, 15);
+}
+
+static size_t lab3_1_fixed(char* line, size_t size, uint16_t raw, float voltage, uint16_t position) {
+    char voltageText[8];
+    formatFloat(voltageText, sizeof(voltageText), voltage, 2, 1);
+    return snprintf(line, size, "Pot: %4u (%sV) | LED Position: %2u/%u\r\n",
+                    raw, voltageText, position, 15);
+}
+
+static size_t lab3_2_printf(char* line, size_t size, uint16_t raw, float voltage, float temperature) {
+    return snprintf(line, size, "\fT:%5.1f%cC %-4s\nADC:%4u V:%1.2f",
+                    static_cast<double>(temperature), 'o', "OK", raw, static_cast<double>(voltage));
+}
+
+static size_t lab3_2_fixed(char* line, size_t size, uint16_t raw, float voltage, float temperature) {
+    char temperatureText[8];
+    char voltageText[8];
+    formatFloat(temperatureText, sizeof(temperatureText), temperature, 1, 5);
+    formatFloat(voltageText, sizeof(voltageText), voltage, 2, 1);
+    return snprintf(line, size, "\fT:%s%cC %-4s\nADC:%4u V:%s",
+                    temperatureText, 'o', "OK", raw, voltageText);
+}
+
+template <typename Format>
+static double time_lines(Format format, uint32_t lines, uint32_t seed) {
+    std::mt19937 rng(seed);
+    char line[64];
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lines; i++) {
+        uint16_t raw = rng() % 1024;
+        float voltage = raw * (5.0f / 1023.0f);
+        size_t length = format(line, sizeof(line), raw, voltage, raw);
+        gSink = line[length / 2];
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / lines;
+}
+
+static int run_bench(uint32_t lines) {
+    // Same inputs must give the same text before timing means anything
+    for (uint16_t raw = 0; raw < 1024; raw++) {
+        float voltage = raw * (5.0f / 1023.0f);
+        float temperature = raw * 0.1f - 40.0f;
+        char a[64];
+        char b[64];
+        lab3_1_printf(a, sizeof(a), raw, voltage, raw % 16);
+        lab3_1_fixed(b, sizeof(b), raw, voltage, raw % 16);
+        expect_equal("lab3_1 line", b, a);
+        lab3_2_printf(a, sizeof(a), raw, voltage, temperature);
+        lab3_2_fixed(b, sizeof(b), raw, voltage, temperature);
+        expect_equal("lab3_2 line", b, a);
+    }
+
+    double lab31Printf = time_lines([](char* l, size_t n, uint16_t r, float v, uint16_t) {
+        return lab3_1_printf(l, n, r, v, r % 16);
+    }, lines, 1);
+    double lab31Fixed = time_lines([](char* l, size_t n, uint16_t r, float v, uint16_t) {
+        return lab3_1_fixed(l, n, r, v, r % 16);
+    }, lines, 1);
+    double lab32Printf = time_lines([](char* l, size_t n, uint16_t r, float v, uint16_t) {
+        return lab3_2_printf(l, n, r, v, r * 0.1f - 40.0f);
+    }, lines, 1);
+    double lab32Fixed = time_lines([](char* l, size_t n, uint16_t r, float v, uint16_t) {
+        return lab3_2_fixed(l, n, r, v, r * 0.1f - 40.0f);
+    }, lines, 1);
+
+    printf("%-22s %12s %12s %8s\n", "status line", "snprintf ns", "fixed ns", "speedup");
+    printf("%-22s %12.1f %12.1f %7.2fx\n", "Lab 3.1 / 5.x serial", lab31Printf, lab31Fixed, lab31Printf / lab31Fixed);
+    printf("%-22s %12.1f %12.1f %7.2fx\n\n", "Lab 3.2 LCD", lab32Printf, lab32Fixed, lab32Printf / lab32Fixed);
+    return gFailures == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+static uint32_t arg_u32(int argc, char** argv, int index, uint32_t fallback) {
+    return index < argc ? static_cast<uint32_t>(strtoul(argv[index], NULL, 0)) : fallback;
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+
+    if (strcmp(mode, "check") == 0) {
+        return run_checks(arg_u32(argc, argv, 2, 1));
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return run_bench(arg_u32(argc, argv, 2, 1000000));
+    }
+    if (strcmp(mode, "all") != 0) {
+        fprintf(stderr, "usage: %s [check|bench] ...\n", argv[0]);
+        return 2;
+    }
+
+    int status = run_checks(1);
+    status |= run_bench(1000000);
+    printf("%s\n", status == 0 ? "PASS" : "FAIL");
+    return status;
+}
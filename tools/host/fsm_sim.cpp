@@ -0,0 +1,702 @@
+// Host-side simulation and throughput harness for lib/fsm
+//
+// Builds machines with the same setup code the labs use (e.g.
+// src/labs/Lab6_1_fsm.h), drives randomized or scripted event streams through
+// them on a virtual clock and checks invariants after every step:
+//   - onExit/onEnter pairing per region (no double enter, no stray exit)
+//   - every entered state is registered and belongs to the entering region
+//   - fsm_process_event() return value matches the transitions observed
+//   - the transition trace (FSM_TRACE_ENABLED=1) matches the callbacks
+// The bench mode reports dispatch throughput for a range of table sizes so
+// table-layout changes can be compared before they go on hardware.
+//
+// Build (from the repo root, one command; or through tools/host/CMakeLists.txt):
+//   g++ -std=gnu++11 -O2 -Wall -Wextra -DFSM_TRACE_ENABLED=1
+//       -Itools/host -Ilib/fsm -Ilib/binlog -Isrc/labs
+//       tools/host/fsm_sim.cpp tools/host/host_arduino.cpp
+//       lib/fsm/fsm.cpp lib/fsm/fsm_trace.cpp lib/fsm/fsm_snapshot.cpp
+//       -o fsm_sim
+// Build with -DFSM_TRACE_ENABLED=0 to bench dispatch without trace overhead.
+//
+// Usage:
+//   fsm_sim                                   built-in script, random run, bench
+//   fsm_sim random [machine] [steps] [seed]   randomized stream (default: led 100000 1)
+//   fsm_sim script <file|->                   scripted stream
+//   fsm_sim bench [events]                    dispatch throughput
+//
+// Script commands (one per line, '#' starts a comment):
+//   machine <led|grid>        build and start a machine
+//   event <id>                fsm_process_event
+//   post <id>                 fsm_post_event (queued)
+//   pending                   fsm_process_pending
+//   wait <ms>                 advance the virtual clock
+//   update                    fsm_update
+//   force <state id>          fsm_force_state
+//   restart                   snapshot, rebuild and fsm_restore (warm reset)
+//   expect <state> [region]   current state by name or ID
+//   expect_pin <pin> <level>  last digitalWrite level
+//   expect_time <ms> [region] time in state
+
+#include <Arduino.h>
+#include "fsm.h"
+#include "fsm_snapshot.h"
+#include "Lab6_1_fsm.h"
+
+#include <stdarg.h>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// -----------------------------------------------------------------------------
+// Machine catalogue
+// -----------------------------------------------------------------------------
+typedef void (*MachineBuild)(FSM* fsm);
+typedef void (*MachineStart)(FSM* fsm);
+
+struct MachineDef {
+    const char* name;
+    MachineBuild build;
+    MachineStart start;
+};
+
+static void led_start(FSM* fsm) {
+    fsm_start(fsm, STATE_RED_LED);
+}
+
+/**
+ * Synthetic table: `states` states split evenly over `regions` regions, each
+ * with `events` outgoing transitions to states further along its region.
+ */
+static void build_synthetic(FSM* fsm, uint8_t states, uint8_t events, uint8_t regions) {
+    static char names[FSM_MAX_STATES][8];
+
+    fsm_init(fsm, "SYNTH");
+    for (uint8_t r = 1; r < regions; r++) {
+        fsm_add_region(fsm, "R");
+    }
+
+    uint8_t perRegion = states / regions;
+    for (uint8_t s = 0; s < states; s++) {
+        snprintf(names[s], sizeof(names[s]), "S%u", s);
+        fsm_add_region_state(fsm, s / perRegion, s, names[s], NULL, NULL, NULL);
+    }
+    for (uint8_t s = 0; s < states; s++) {
+        uint8_t base = (s / perRegion) * perRegion;
+        for (uint8_t e = 1; e <= events; e++) {
+            uint8_t to = base + (s - base + e) % perRegion;
+            fsm_add_transition(fsm, s, to, e, NULL, NULL);
+        }
+    }
+}
+
+static void synthetic_start(FSM* fsm) {
+    for (uint8_t r = 0; r < fsm->regionCount; r++) {
+        for (uint8_t s = 0; s < fsm->stateCount; s++) {
+            if (fsm->states[s].region == r) {
+                fsm_start(fsm, fsm->states[s].id);
+                break;
+            }
+        }
+    }
+}
+
+static void grid_build(FSM* fsm) {
+    build_synthetic(fsm, 8, 2, 2);
+}
+
+static const MachineDef MACHINES[] = {
+    {"led", lab6_1_build_led_fsm, led_start},
+    {"grid", grid_build, synthetic_start},
+};
+
+static const MachineDef* find_machine(const char* name) {
+    for (size_t i = 0; i < sizeof(MACHINES) / sizeof(MACHINES[0]); i++) {
+        if (strcmp(MACHINES[i].name, name) == 0) {
+            return &MACHINES[i];
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Invariant monitor
+// -----------------------------------------------------------------------------
+// Callbacks are plain function pointers, so the monitor wraps every state's
+// onEnter/onExit with its own and keeps the originals here.
+struct RegionTrack {
+    bool inside;                   // onEnter seen without matching onExit
+    uint8_t state;                 // State last entered
+};
+
+struct Transition {
+    uint8_t from;
+    uint8_t to;
+};
+
+struct Monitor {
+    FSM* fsm;
+    StateCallback onEnter[256];
+    StateCallback onExit[256];
+    RegionTrack regions[FSM_MAX_REGIONS];
+    std::vector<Transition> untraced; // Entered since the last trace check
+    uint32_t enters;
+    uint32_t exits;
+    uint32_t violations;
+    uint32_t steps;
+};
+
+static Monitor gMonitor;
+
+static void violation(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void violation(const char* fmt, ...) {
+    gMonitor.violations++;
+    if (gMonitor.violations > 20) {
+        return; // Enough to diagnose, keep the log readable
+    }
+    fprintf(stderr, "VIOLATION step %u: ", gMonitor.steps);
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+static const FSMState* monitor_find_state(const FSM* fsm, uint8_t id) {
+    for (uint8_t i = 0; i < fsm->stateCount; i++) {
+        if (fsm->states[i].id == id) {
+            return &fsm->states[i];
+        }
+    }
+    return NULL;
+}
+
+static void monitor_on_exit(FSM* fsm) {
+    uint8_t region = fsm->activeRegion;
+    uint8_t state = fsm->regions[region].currentState;
+    RegionTrack* t = &gMonitor.regions[region];
+
+    if (!t->inside || t->state != state) {
+        violation("onExit of state %u in region %u without matching onEnter", state, region);
+    }
+    t->inside = false;
+    gMonitor.exits++;
+
+    if (gMonitor.onExit[state] != NULL) {
+        gMonitor.onExit[state](fsm);
+    }
+}
+
+static void monitor_on_enter(FSM* fsm) {
+    uint8_t region = fsm->activeRegion;
+    const FSMRegion* r = &fsm->regions[region];
+    uint8_t state = r->currentState;
+    RegionTrack* t = &gMonitor.regions[region];
+
+    const FSMState* s = monitor_find_state(fsm, state);
+    if (s == NULL) {
+        violation("entered unregistered state %u in region %u", state, region);
+    } else if (s->region != region) {
+        violation("state %s (region %u) entered from region %u", s->name, s->region, region);
+    }
+    if (t->inside) {
+        violation("onEnter of state %u while state %u in region %u was not exited",
+                  state, t->state, region);
+    }
+    t->inside = true;
+    t->state = state;
+    gMonitor.enters++;
+    gMonitor.untraced.push_back(Transition{r->previousState, state});
+
+    if (gMonitor.onEnter[state] != NULL) {
+        gMonitor.onEnter[state](fsm);
+    }
+}
+
+/**
+ * Report transitions that reference unregistered states (the FSM silently
+ * ignores them at runtime)
+ */
+static void monitor_check_table(const FSM* fsm) {
+    for (uint8_t i = 0; i < fsm->transitionCount; i++) {
+        const FSMTransition* t = &fsm->transitions[i];
+        if (monitor_find_state(fsm, t->fromState) == NULL) {
+            violation("transition %u: from-state %u is not registered", i, t->fromState);
+        }
+        if (monitor_find_state(fsm, t->toState) == NULL) {
+            violation("transition %u: to-state %u is not registered", i, t->toState);
+        }
+    }
+}
+
+/**
+ * Wrap callbacks of a built (not yet started) machine
+ */
+static void monitor_attach(FSM* fsm) {
+    gMonitor.fsm = fsm;
+    memset(gMonitor.regions, 0, sizeof(gMonitor.regions));
+    gMonitor.untraced.clear();
+
+    for (uint8_t i = 0; i < fsm->stateCount; i++) {
+        FSMState* s = &fsm->states[i];
+        gMonitor.onEnter[s->id] = s->onEnter;
+        gMonitor.onExit[s->id] = s->onExit;
+        s->onEnter = monitor_on_enter;
+        s->onExit = monitor_on_exit;
+    }
+
+    monitor_check_table(fsm);
+#if FSM_TRACE_ENABLED
+    fsm_trace_clear();
+#endif
+}
+
+#if FSM_TRACE_ENABLED
+// Collects a trace dump in memory
+class BufferPrint : public Print {
+public:
+    size_t write(uint8_t value) override {
+        data.push_back(value);
+        return 1;
+    }
+    using Print::write;
+
+    std::vector<uint8_t> data;
+};
+#endif
+
+/**
+ * Cross-check the machine after a step
+ */
+static void monitor_check(bool reported, uint32_t entersBefore, bool checkReturn) {
+    const FSM* fsm = gMonitor.fsm;
+
+    if (checkReturn && reported != (gMonitor.enters != entersBefore)) {
+        violation("fsm_process_event returned %s but %u states were entered",
+                  reported ? "true" : "false", gMonitor.enters - entersBefore);
+    }
+
+    for (uint8_t region = 0; region < fsm->regionCount; region++) {
+        const FSMRegion* r = &fsm->regions[region];
+        if (!r->active) {
+            continue;
+        }
+        const FSMState* s = monitor_find_state(fsm, r->currentState);
+        if (s == NULL || s->region != region) {
+            violation("region %u rests in unregistered state %u", region, r->currentState);
+        }
+        const RegionTrack* t = &gMonitor.regions[region];
+        if (!t->inside || t->state != r->currentState) {
+            violation("region %u is in state %u but callbacks saw %u", region,
+                      r->currentState, t->state);
+        }
+    }
+
+#if FSM_TRACE_ENABLED
+    // Every onEnter corresponds to exactly one trace record
+    uint16_t count = fsm_trace_count();
+    uint32_t overwritten = fsm_trace_overwritten();
+    if (count + overwritten != gMonitor.untraced.size()) {
+        violation("trace has %u records, callbacks saw %u transitions",
+                  static_cast<unsigned>(count + overwritten),
+                  static_cast<unsigned>(gMonitor.untraced.size()));
+    } else if (count > 0) {
+        BufferPrint dump;
+        fsm_trace_dump(dump);
+        const uint8_t* records = dump.data.data() + dump.data.size() - count * 8u;
+        size_t first = gMonitor.untraced.size() - count;
+        for (uint16_t i = 0; i < count; i++) {
+            const uint8_t* rec = records + i * 8u;
+            const Transition& seen = gMonitor.untraced[first + i];
+            if (rec[5] != seen.from || rec[6] != seen.to) {
+                violation("trace record %u is %u->%u, callbacks saw %u->%u",
+                          i, rec[5], rec[6], seen.from, seen.to);
+            }
+        }
+    }
+    fsm_trace_clear();
+#endif
+    gMonitor.untraced.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Simulation steps
+// -----------------------------------------------------------------------------
+static FSM gSimFsm;
+static const MachineDef* gSimMachine = NULL;
+
+static void sim_load(const MachineDef* machine) {
+    gSimMachine = machine;
+    host_pins_reset();
+    machine->build(&gSimFsm);
+    monitor_attach(&gSimFsm);
+    uint32_t before = gMonitor.enters;
+    machine->start(&gSimFsm);
+    monitor_check(false, before, false);
+}
+
+static void sim_event(uint8_t event) {
+    uint32_t before = gMonitor.enters;
+    bool transitioned = fsm_process_event(&gSimFsm, event);
+    monitor_check(transitioned, before, true);
+}
+
+static void sim_post(uint8_t event) {
+    if (!fsm_post_event(&gSimFsm, event)) {
+        // Queue full is legal, just drain it
+        sim_event(event);
+    }
+}
+
+static void sim_pending() {
+    uint32_t before = gMonitor.enters;
+    bool transitioned = fsm_process_pending(&gSimFsm);
+    monitor_check(transitioned, before, true);
+}
+
+static void sim_update() {
+    uint32_t before = gMonitor.enters;
+    fsm_update(&gSimFsm);
+    monitor_check(false, before, false);
+}
+
+static bool sim_force(uint8_t stateId) {
+    uint32_t before = gMonitor.enters;
+    bool ok = fsm_force_state(&gSimFsm, stateId);
+    monitor_check(ok, before, true);
+    return ok;
+}
+
+/**
+ * Warm reset: snapshot, rebuild from scratch, restore
+ */
+static bool sim_restart() {
+    FSMSnapshot snapshot;
+    if (!fsm_snapshot(&gSimFsm, &snapshot)) {
+        return false;
+    }
+
+    host_pins_reset();
+    gSimMachine->build(&gSimFsm);
+    monitor_attach(&gSimFsm);
+    uint32_t before = gMonitor.enters;
+    bool ok = fsm_restore(&gSimFsm, &snapshot, true);
+    monitor_check(ok, before, true);
+    return ok;
+}
+
+// -----------------------------------------------------------------------------
+// Randomized streams
+// -----------------------------------------------------------------------------
+static int run_random(const MachineDef* machine, uint32_t steps, uint32_t seed) {
+    std::mt19937 rng(seed);
+
+    sim_load(machine);
+
+    // Events the table reacts to, plus one it never handles
+    std::vector<uint8_t> events;
+    uint8_t unused = 1;
+    for (uint8_t i = 0; i < gSimFsm.transitionCount; i++) {
+        uint8_t e = gSimFsm.transitions[i].event;
+        bool known = false;
+        for (uint8_t k : events) {
+            known |= (k == e);
+        }
+        if (!known) {
+            events.push_back(e);
+        }
+        if (e >= unused) {
+            unused = e + 1;
+        }
+    }
+    events.push_back(unused);
+
+    uint32_t violationsBefore = gMonitor.violations;
+    uint32_t entersBefore = gMonitor.enters;
+    uint32_t restarts = 0;
+
+    for (gMonitor.steps = 0; gMonitor.steps < steps; gMonitor.steps++) {
+        uint32_t r = rng() % 100;
+        uint8_t event = events[rng() % events.size()];
+
+        if (r < 55) {
+            sim_event(event);
+        } else if (r < 70) {
+            sim_post(event);
+        } else if (r < 78) {
+            sim_pending();
+        } else if (r < 88) {
+            host_clock_advance_ms(rng() % 2000);
+        } else if (r < 96) {
+            sim_update();
+        } else if (r < 99) {
+            sim_force(gSimFsm.states[rng() % gSimFsm.stateCount].id);
+        } else {
+            if (!sim_restart()) {
+                violation("warm restart from a valid snapshot failed");
+            }
+            restarts++;
+        }
+    }
+    sim_pending();
+
+    uint32_t violations = gMonitor.violations - violationsBefore;
+    printf("random: machine=%s steps=%u seed=%u transitions=%u restarts=%u violations=%u\n",
+           machine->name, steps, seed, gMonitor.enters - entersBefore, restarts, violations);
+    return violations == 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Scripted streams
+// -----------------------------------------------------------------------------
+static const char* const DEFAULT_SCRIPT =
+    "machine led\n"
+    "expect RED_LED\n"
+    "expect_pin 5 1\n"
+    "expect_pin 4 0\n"
+    "wait 250\n"
+    "expect_time 250\n"
+    "event 1\n"
+    "expect GREEN_LED\n"
+    "expect_pin 5 0\n"
+    "expect_pin 4 1\n"
+    "event 7\n"                    // Unhandled event is ignored
+    "expect GREEN_LED\n"
+    "post 1\n"
+    "post 1\n"
+    "post 1\n"
+    "pending\n"
+    "expect RED_LED\n"
+    "wait 1200\n"
+    "restart\n"                    // Warm reset keeps state and time in state
+    "expect RED_LED\n"
+    "expect_time 1200\n"
+    "expect_pin 5 1\n"
+    "force 1\n"
+    "expect GREEN_LED\n"
+    "machine grid\n"
+    "expect S0 0\n"
+    "expect S4 1\n"
+    "event 2\n"
+    "expect S2 0\n"
+    "expect S6 1\n";
+
+static bool script_expect_state(const char* name, uint8_t region) {
+    if (region >= gSimFsm.regionCount) {
+        return false;
+    }
+    uint8_t current = gSimFsm.regions[region].currentState;
+    const FSMState* s = monitor_find_state(&gSimFsm, current);
+
+    char* end;
+    long id = strtol(name, &end, 0);
+    if (*end == '\0') {
+        return current == id;
+    }
+    return s != NULL && strcmp(s->name, name) == 0;
+}
+
+static int run_script_text(const char* text, const char* origin) {
+    uint32_t failures = 0;
+    uint32_t violationsBefore = gMonitor.violations;
+    unsigned lineNo = 0;
+
+    gMonitor.steps = 0;
+    while (*text != '\0') {
+        const char* eol = strchr(text, '\n');
+        size_t len = eol != NULL ? static_cast<size_t>(eol - text) : strlen(text);
+        std::string line(text, len);
+        text += eol != NULL ? len + 1 : len;
+        lineNo++;
+
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+
+        char cmd[32] = {0};
+        char arg[64] = {0};
+        long a = 0;
+        long b = 0;
+        int fields = sscanf(line.c_str(), "%31s %63s %ld", cmd, arg, &b);
+        if (fields <= 0) {
+            continue;
+        }
+        a = strtol(arg, NULL, 0);
+        gMonitor.steps++;
+
+        bool ok = true;
+        if (strcmp(cmd, "machine") == 0) {
+            const MachineDef* machine = find_machine(arg);
+            ok = machine != NULL;
+            if (ok) {
+                sim_load(machine);
+            }
+        } else if (gSimMachine == NULL) {
+            ok = false;
+        } else if (strcmp(cmd, "event") == 0) {
+            sim_event(static_cast<uint8_t>(a));
+        } else if (strcmp(cmd, "post") == 0) {
+            sim_post(static_cast<uint8_t>(a));
+        } else if (strcmp(cmd, "pending") == 0) {
+            sim_pending();
+        } else if (strcmp(cmd, "wait") == 0) {
+            host_clock_advance_ms(static_cast<uint32_t>(a));
+        } else if (strcmp(cmd, "update") == 0) {
+            sim_update();
+        } else if (strcmp(cmd, "force") == 0) {
+            ok = sim_force(static_cast<uint8_t>(a));
+        } else if (strcmp(cmd, "restart") == 0) {
+            ok = sim_restart();
+        } else if (strcmp(cmd, "expect") == 0) {
+            ok = script_expect_state(arg, fields >= 3 ? static_cast<uint8_t>(b) : 0);
+        } else if (strcmp(cmd, "expect_pin") == 0) {
+            ok = fields >= 3 && digitalRead(static_cast<uint8_t>(a)) == b;
+        } else if (strcmp(cmd, "expect_time") == 0) {
+            ok = fsm_get_region_time_in_state(&gSimFsm, fields >= 3 ? static_cast<uint8_t>(b) : 0) ==
+                 static_cast<unsigned long>(a);
+        } else {
+            fprintf(stderr, "%s:%u: unknown command '%s'\n", origin, lineNo, cmd);
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "%s:%u: FAILED: %s\n", origin, lineNo, line.c_str());
+            failures++;
+        }
+    }
+
+    uint32_t violations = gMonitor.violations - violationsBefore;
+    printf("script: %s lines=%u failures=%u violations=%u\n", origin, lineNo, failures, violations);
+    return failures == 0 && violations == 0 ? 0 : 1;
+}
+
+static int run_script_file(const char* path) {
+    FILE* f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (f == NULL) {
+        perror(path);
+        return 2;
+    }
+    std::string text;
+    char buf[512];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        text.append(buf, n);
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+    return run_script_text(text.c_str(), path);
+}
+
+// -----------------------------------------------------------------------------
+// Throughput
+// -----------------------------------------------------------------------------
+static FSM gBenchFsm;
+
+static double bench_dispatch(FSM* fsm, uint8_t maxEvent, uint32_t events, uint32_t* transitions) {
+    std::mt19937 rng(12345);
+    std::vector<uint8_t> stream(4096);
+    for (uint8_t& e : stream) {
+        e = static_cast<uint8_t>(1 + rng() % (maxEvent + 1)); // Includes one unhandled event
+    }
+
+    uint32_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < events; i++) {
+        hits += fsm_process_event(fsm, stream[i & 4095]) ? 1 : 0;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    *transitions = hits;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / events;
+}
+
+static int run_bench(uint32_t events) {
+    struct BenchCase {
+        uint8_t states;
+        uint8_t events;
+        uint8_t regions;
+    };
+    static const BenchCase CASES[] = {
+        {2, 1, 1}, {4, 2, 1}, {8, 2, 1}, {8, 4, 1}, {16, 2, 1},
+        {8, 2, 2}, {16, 2, 2}, {16, 2, 4},
+    };
+
+    printf("bench: %u events per case, trace %s, FSM_MAX_STATES=%u FSM_MAX_TRANSITIONS=%u\n",
+           events, FSM_TRACE_ENABLED ? "on" : "off", FSM_MAX_STATES, FSM_MAX_TRANSITIONS);
+    printf("%-8s %7s %7s %8s %12s %12s %9s\n",
+           "machine", "states", "events", "regions", "transitions", "ns/event", "Mev/s");
+
+    for (const BenchCase& c : CASES) {
+        if (c.states > FSM_MAX_STATES || c.states * c.events > FSM_MAX_TRANSITIONS ||
+            c.regions > FSM_MAX_REGIONS) {
+            continue;
+        }
+        build_synthetic(&gBenchFsm, c.states, c.events, c.regions);
+        synthetic_start(&gBenchFsm);
+
+        uint32_t hits;
+        double ns = bench_dispatch(&gBenchFsm, c.events, events, &hits);
+        printf("%-8s %7u %7u %8u %12u %12.1f %9.2f\n", "synth", c.states, c.events,
+               c.regions, gBenchFsm.transitionCount, ns, 1000.0 / ns);
+        (void) hits;
+    }
+
+    // The lab machine itself; its callbacks log through BINLOG, which is
+    // compiled out on the host unless built with -DBINLOG_ENABLED=1
+    lab6_1_build_led_fsm(&gBenchFsm);
+    led_start(&gBenchFsm);
+    uint32_t hits;
+    double ns = bench_dispatch(&gBenchFsm, EVENT_BUTTON_PRESS, events, &hits);
+    printf("%-8s %7u %7u %8u %12u %12.1f %9.2f\n", "led", gBenchFsm.stateCount, 1,
+           gBenchFsm.regionCount, gBenchFsm.transitionCount, ns, 1000.0 / ns);
+
+#if FSM_TRACE_ENABLED
+    fsm_trace_clear();
+#endif
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+static uint32_t arg_u32(int argc, char** argv, int index, uint32_t fallback) {
+    return index < argc ? static_cast<uint32_t>(strtoul(argv[index], NULL, 0)) : fallback;
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+
+    if (strcmp(mode, "random") == 0) {
+        const MachineDef* machine = find_machine(argc > 2 ? argv[2] : "led");
+        if (machine == NULL) {
+            fprintf(stderr, "unknown machine '%s'\n", argv[2]);
+            return 2;
+        }
+        return run_random(machine, arg_u32(argc, argv, 3, 100000), arg_u32(argc, argv, 4, 1));
+    }
+    if (strcmp(mode, "script") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "usage: %s script <file|->\n", argv[0]);
+            return 2;
+        }
+        return run_script_file(argv[2]);
+    }
+    if (strcmp(mode, "bench") == 0) {
+        return run_bench(arg_u32(argc, argv, 2, 2000000));
+    }
+    if (strcmp(mode, "all") != 0) {
+        fprintf(stderr, "usage: %s [random|script|bench] ...\n", argv[0]);
+        return 2;
+    }
+
+    int status = run_script_text(DEFAULT_SCRIPT, "<built-in>");
+    for (size_t i = 0; i < sizeof(MACHINES) / sizeof(MACHINES[0]); i++) {
+        status |= run_random(&MACHINES[i], 100000, 1);
+    }
+    status |= run_bench(1000000);
+    return status;
+}
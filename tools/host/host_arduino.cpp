@@ -0,0 +1,308 @@
+// Host implementation of the Arduino shim in tools/host/Arduino.h
+
+#include "Arduino.h"
+#include "avr/eeprom.h"
+
+// -----------------------------------------------------------------------------
+// Virtual clock
+// -----------------------------------------------------------------------------
+static uint64_t gHostMicros = 0;
+
+unsigned long millis() {
+    // Truncate to 32 bits like the AVR core so wrap-around is reproducible
+    return static_cast<uint32_t>(gHostMicros / 1000);
+}
+
+unsigned long micros() {
+    return static_cast<uint32_t>(gHostMicros);
+}
+
+void delay(unsigned long ms) {
+    host_clock_advance_ms(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    host_clock_advance_us(us);
+}
+
+void host_clock_advance_us(uint64_t us) {
+    gHostMicros += us;
+}
+
+void host_clock_advance_ms(uint32_t ms) {
+    gHostMicros += static_cast<uint64_t>(ms) * 1000;
+}
+
+void host_clock_set_us(uint64_t us) {
+    gHostMicros = us;
+}
+
+// -----------------------------------------------------------------------------
+// GPIO
+// -----------------------------------------------------------------------------
+static uint8_t gPinLevel[HOST_NUM_PINS];
+static uint8_t gPinInput[HOST_NUM_PINS];
+static uint32_t gPinWrites[HOST_NUM_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HOST_NUM_PINS && mode == INPUT_PULLUP) {
+        gPinInput[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < HOST_NUM_PINS) {
+        gPinLevel[pin] = value ? HIGH : LOW;
+        gPinWrites[pin]++;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    if (pin >= HOST_NUM_PINS) {
+        return LOW;
+    }
+    // Output pins read back their driven level
+    return gPinWrites[pin] > 0 ? gPinLevel[pin] : gPinInput[pin];
+}
+
+void host_pin_set_input(uint8_t pin, uint8_t value) {
+    if (pin < HOST_NUM_PINS) {
+        gPinInput[pin] = value ? HIGH : LOW;
+    }
+}
+
+uint32_t host_pin_write_count(uint8_t pin) {
+    return pin < HOST_NUM_PINS ? gPinWrites[pin] : 0;
+}
+
+void host_pins_reset() {
+    memset(gPinLevel, 0, sizeof(gPinLevel));
+    memset(gPinInput, 0, sizeof(gPinInput));
+    memset(gPinWrites, 0, sizeof(gPinWrites));
+}
+
+// -----------------------------------------------------------------------------
+// stdio streams
+// -----------------------------------------------------------------------------
+struct HostFdev {
+    FILE* stream;           // Address the code under test set up
+    HostFdevPut put;
+    HostFdevGet get;
+};
+
+static HostFdev gFdevs[8];
+
+void host_fdev_setup(FILE* stream, HostFdevPut put, HostFdevGet get) {
+    for (HostFdev& fdev : gFdevs) {
+        if (fdev.stream == stream || fdev.stream == NULL) {
+            fdev.stream = stream;
+            fdev.put = put;
+            fdev.get = get;
+            return;
+        }
+    }
+    fprintf(stderr, "fdev: too many streams\n");
+    abort();
+}
+
+static ssize_t fdev_read(void* cookie, char* buffer, size_t size) {
+    HostFdev* fdev = static_cast<HostFdev*>(cookie);
+    if (fdev->get == NULL || size == 0) {
+        return -1;
+    }
+    // One character per call, like the AVR stream
+    int c = fdev->get(fdev->stream);
+    if (c == _FDEV_EOF) {
+        return 0;
+    }
+    if (c < 0) {
+        return -1;
+    }
+    buffer[0] = static_cast<char>(c);
+    return 1;
+}
+
+static ssize_t fdev_write(void* cookie, const char* buffer, size_t size) {
+    HostFdev* fdev = static_cast<HostFdev*>(cookie);
+    if (fdev->put == NULL) {
+        return -1;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (fdev->put(buffer[i], fdev->stream) < 0) {
+            return i > 0 ? static_cast<ssize_t>(i) : -1;
+        }
+    }
+    return static_cast<ssize_t>(size);
+}
+
+FILE* host_fdev_open(FILE* stream, const char* mode) {
+    for (HostFdev& fdev : gFdevs) {
+        if (fdev.stream == stream) {
+            cookie_io_functions_t functions = {fdev_read, fdev_write, NULL, NULL};
+            return fopencookie(&fdev, mode, functions);
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Print
+// -----------------------------------------------------------------------------
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size-- > 0) {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::printUnsigned(unsigned long value, int base) {
+    char buf[8 * sizeof(long) + 1];
+    snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", value);
+    return write(buf);
+}
+
+size_t Print::printSigned(long value, int base) {
+    if (base != DEC) {
+        return printUnsigned(static_cast<unsigned long>(value), base);
+    }
+    char buf[8 * sizeof(long) + 2];
+    snprintf(buf, sizeof(buf), "%ld", value);
+    return write(buf);
+}
+
+size_t Print::print(double value, int digits) {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, value);
+    return write(buf);
+}
+
+// -----------------------------------------------------------------------------
+// Serial
+// -----------------------------------------------------------------------------
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t value) {
+    if (backend_ != nullptr) {
+        return backend_->write(value);
+    }
+    if (capturedLength_ < CAPTURE_SIZE) {
+        captured_[capturedLength_++] = static_cast<char>(value);
+        captured_[capturedLength_] = '\0';
+    }
+    if (echo_) {
+        fputc(value, stdout);
+    }
+    return 1;
+}
+
+int HardwareSerial::available() {
+    if (backend_ != nullptr) {
+        return backend_->available();
+    }
+    return static_cast<int>(inputTail_ - inputHead_);
+}
+
+int HardwareSerial::read() {
+    if (backend_ != nullptr) {
+        return backend_->read();
+    }
+    if (inputHead_ == inputTail_) {
+        return -1;
+    }
+    return static_cast<uint8_t>(input_[inputHead_++]);
+}
+
+int HardwareSerial::peek() {
+    if (backend_ != nullptr) {
+        return backend_->peek();
+    }
+    if (inputHead_ == inputTail_) {
+        return -1;
+    }
+    return static_cast<uint8_t>(input_[inputHead_]);
+}
+
+int HardwareSerial::availableForWrite() {
+    // Captured output never fills up
+    return backend_ != nullptr ? backend_->availableForWrite() : 64;
+}
+
+void HardwareSerial::feed(const char* data) {
+    // Compact consumed input before appending
+    if (inputHead_ > 0) {
+        memmove(input_, input_ + inputHead_, inputTail_ - inputHead_);
+        inputTail_ -= inputHead_;
+        inputHead_ = 0;
+    }
+    while (*data != '\0' && inputTail_ < INPUT_SIZE) {
+        input_[inputTail_++] = *data++;
+    }
+}
+
+void HardwareSerial::clearCaptured() {
+    capturedLength_ = 0;
+    captured_[0] = '\0';
+}
+
+// -----------------------------------------------------------------------------
+// EEPROM
+// -----------------------------------------------------------------------------
+static uint8_t gEeprom[E2END + 1];
+static bool gEepromErased = false;
+static uint32_t gEepromWrites = 0;
+
+static uint8_t* eeprom_cell(const void* address, size_t size) {
+    if (!gEepromErased) {
+        host_eeprom_reset();
+    }
+    uintptr_t offset = reinterpret_cast<uintptr_t>(address);
+    if (offset + size > sizeof(gEeprom)) {
+        fprintf(stderr, "eeprom: access 0x%lx+%lu out of range\n",
+                static_cast<unsigned long>(offset), static_cast<unsigned long>(size));
+        abort();
+    }
+    return &gEeprom[offset];
+}
+
+void eeprom_read_block(void* dst, const void* src, size_t size) {
+    memcpy(dst, eeprom_cell(src, size), size);
+}
+
+void eeprom_write_block(const void* src, void* dst, size_t size) {
+    memcpy(eeprom_cell(dst, size), src, size);
+    gEepromWrites += size;
+}
+
+void eeprom_update_block(const void* src, void* dst, size_t size) {
+    uint8_t* cell = eeprom_cell(dst, size);
+    const uint8_t* data = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < size; i++) {
+        if (cell[i] != data[i]) {
+            cell[i] = data[i];
+            gEepromWrites++;
+        }
+    }
+}
+
+uint8_t eeprom_read_byte(const uint8_t* address) {
+    return *eeprom_cell(address, 1);
+}
+
+void eeprom_write_byte(uint8_t* address, uint8_t value) {
+    eeprom_write_block(&value, address, 1);
+}
+
+void eeprom_update_byte(uint8_t* address, uint8_t value) {
+    eeprom_update_block(&value, address, 1);
+}
+
+void host_eeprom_reset() {
+    memset(gEeprom, 0xFF, sizeof(gEeprom));
+    gEepromErased = true;
+    gEepromWrites = 0;
+}
+
+uint32_t host_eeprom_write_count() {
+    return gEepromWrites;
+}
@@ -0,0 +1,189 @@
+// Pseudo-terminal Serial backend, see host_pty.h
+
+#include "host_pty.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// A line quiet this long is idle (longer than any sleep_until() overshoot)
+static const std::chrono::milliseconds IDLE_GAP(2);
+
+PtySerial::~PtySerial() {
+    close();
+}
+
+bool PtySerial::open(unsigned long baud, size_t rxSize, size_t txSize) {
+    master_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0) {
+        close();
+        return false;
+    }
+    snprintf(path_, sizeof(path_), "%s", ptsname(master_));
+
+    // No line discipline: bytes pass unchanged in both directions
+    struct termios mode;
+    if (tcgetattr(master_, &mode) == 0) {
+        cfmakeraw(&mode);
+        tcsetattr(master_, TCSANOW, &mode);
+    }
+
+    baud_ = baud;
+    rxSize_ = rxSize > 0 ? rxSize : 1;
+    txSize_ = txSize > 0 ? txSize : 1;
+    running_ = true;
+    rxThread_ = std::thread(&PtySerial::rxLoop, this);
+    txThread_ = std::thread(&PtySerial::txLoop, this);
+    return true;
+}
+
+void PtySerial::close() {
+    if (running_.exchange(false)) {
+        txData_.notify_all();
+        txSpace_.notify_all();
+        rxSpace_.notify_all();
+        rxThread_.join();
+        txThread_.join();
+    }
+    if (master_ >= 0) {
+        ::close(master_);
+        master_ = -1;
+    }
+}
+
+PtySerial::Clock::duration PtySerial::byteTime() const {
+    // Start + 8 data + stop bits
+    return baud_ > 0 ? std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::nanoseconds(10000000000ULL / baud_))
+                     : Clock::duration::zero();
+}
+
+/**
+ * End of the frame after one ending at previous. Back-to-back frames follow
+ * the previous one exactly, so late wake-ups from sleep_until() are caught
+ * up instead of stretching every frame; only an idle line restarts at now.
+ */
+PtySerial::Clock::time_point PtySerial::nextFrame(Clock::time_point previous) const {
+    Clock::time_point now = Clock::now();
+    if (previous + IDLE_GAP < now) {
+        previous = now;
+    }
+    return previous + byteTime();
+}
+
+// -----------------------------------------------------------------------------
+// Wire threads
+// -----------------------------------------------------------------------------
+void PtySerial::rxLoop() {
+    Clock::time_point wire = Clock::now();
+    uint8_t chunk[64];
+
+    while (running_) {
+        struct pollfd fd = {master_, POLLIN, 0};
+        if (poll(&fd, 1, 20) <= 0) {
+            continue;
+        }
+        ssize_t length = ::read(master_, chunk, sizeof(chunk));
+        if (length <= 0) {
+            // EIO until the far end is opened (again)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        for (ssize_t i = 0; i < length && running_; i++) {
+            if (baud_ > 0) {
+                // The byte is complete one frame time after the previous one
+                wire = nextFrame(wire);
+                std::this_thread::sleep_until(wire);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (rx_.size() >= rxSize_) {
+                if (baud_ > 0) {
+                    // A real UART has nowhere to put it
+                    rxOverruns_++;
+                    continue;
+                }
+                rxSpace_.wait(lock, [this] { return rx_.size() < rxSize_ || !running_; });
+            }
+            rx_.push_back(chunk[i]);
+            rxReady_.notify_all();
+        }
+    }
+}
+
+void PtySerial::txLoop() {
+    Clock::time_point wire = Clock::now();
+
+    while (running_) {
+        uint8_t value;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            txData_.wait(lock, [this] { return !tx_.empty() || !running_; });
+            if (!running_) {
+                break;
+            }
+            value = tx_.front();
+        }
+
+        if (baud_ > 0) {
+            wire = nextFrame(wire);
+            std::this_thread::sleep_until(wire);
+        }
+        // Nobody listening: the byte is lost, as on an unconnected UART
+        if (::write(master_, &value, 1) < 0 && errno != EIO) {
+            perror("pty write");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        tx_.pop_front();
+        txSpace_.notify_all();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// SerialBackend
+// -----------------------------------------------------------------------------
+size_t PtySerial::write(uint8_t value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (tx_.size() >= txSize_) {
+        txStalls_++;
+        txSpace_.wait(lock, [this] { return tx_.size() < txSize_ || !running_; });
+    }
+    tx_.push_back(value);
+    txData_.notify_one();
+    return 1;
+}
+
+int PtySerial::available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(rx_.size());
+}
+
+int PtySerial::read() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rx_.empty()) {
+        return -1;
+    }
+    int value = rx_.front();
+    rx_.pop_front();
+    rxSpace_.notify_all();    // Unblocks an unpaced RX thread
+    return value;
+}
+
+int PtySerial::peek() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rx_.empty() ? -1 : rx_.front();
+}
+
+int PtySerial::availableForWrite() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(txSize_ - tx_.size());
+}
+
+bool PtySerial::waitForData(uint32_t timeoutUs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return rxReady_.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] { return !rx_.empty(); });
+}
@@ -0,0 +1,84 @@
+#ifndef HOST_PTY_H
+#define HOST_PTY_H
+
+// Serial backend on a Linux pseudo-terminal
+//
+// The code under test keeps using Serial; the harness (or a terminal,
+// pyserial, tools/*.py --port) talks to the other end of the pty. Two wire
+// threads model the UART: bytes move at the emulated baud rate through RX
+// and TX rings of the AVR core's size, so a slow reader overruns the RX ring
+// and a fast writer blocks on a full TX ring, as on the board.
+
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class PtySerial : public SerialBackend {
+public:
+    ~PtySerial();
+
+    /**
+     * Open the pty (raw mode) and start the wire threads
+     * @param baud Emulated line rate, 0 for unpaced (the RX side then
+     *             applies back-pressure instead of overrunning)
+     * @param rxSize RX ring size (SERIAL_RX_BUFFER_SIZE on the board)
+     * @param txSize TX ring size (SERIAL_TX_BUFFER_SIZE on the board)
+     */
+    bool open(unsigned long baud, size_t rxSize = 64, size_t txSize = 64);
+    void close();
+
+    /**
+     * Device path for the far end (e.g. /dev/pts/5)
+     */
+    const char* path() const { return path_; }
+
+    /**
+     * Block until a byte is in the RX ring or the timeout passes
+     * (for setSerialWaitHook(), instead of spinning)
+     */
+    bool waitForData(uint32_t timeoutUs);
+
+    uint32_t rxOverruns() const { return rxOverruns_; }
+    uint32_t txStalls() const { return txStalls_; }
+
+    // SerialBackend
+    size_t write(uint8_t value) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite() override;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void rxLoop();
+    void txLoop();
+    Clock::duration byteTime() const;
+    Clock::time_point nextFrame(Clock::time_point previous) const;
+
+    int master_ = -1;
+    char path_[64] = {0};
+    unsigned long baud_ = 0;
+    size_t rxSize_ = 64;
+    size_t txSize_ = 64;
+
+    std::mutex mutex_;
+    std::condition_variable rxReady_;
+    std::condition_variable rxSpace_;
+    std::condition_variable txSpace_;
+    std::condition_variable txData_;
+    std::deque<uint8_t> rx_;
+    std::deque<uint8_t> tx_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint32_t> rxOverruns_{0};
+    std::atomic<uint32_t> txStalls_{0};
+    std::thread rxThread_;
+    std::thread txThread_;
+};
+
+#endif // HOST_PTY_H
@@ -0,0 +1,387 @@
+// End-to-end serial I/O benchmark on a pseudo-terminal
+//
+// Builds the lab serial stack natively (lib/serial_stdio on top of Serial,
+// lib/command_handler reading stdin and answering on stdout) and runs it
+// on a device thread, with Serial mapped onto a pty by PtySerial. The
+// wire is emulated at the configured baud rate with AVR-sized RX and TX
+// rings. The device side works like the lab main loops: getchar() then
+// commandHandlerProcessChar(). The wait hook sleeps on the pty instead of
+// spinning.
+//
+// A load generator opens the far end of the pty and sends "ping <n>" lines
+// open-loop at each rate of a sweep. The device answers "pong <n>". For
+// each rate it reports delivered rate, lost replies and request-to-reply
+// latency percentiles. The maximum sustainable rate is the highest rate
+// with no lost replies, at least 98% of the offered rate delivered and p99
+// within --p99-limit.
+//
+// Build (from the repo root, one command):
+//   g++ -std=gnu++11 -O2 -Wall -Wextra -pthread
+//       -Itools/host -Ilib/serial_stdio -Ilib/command_handler -Ilib/frame_codec
+//       tools/host/serial_pty_bench.cpp tools/host/host_pty.cpp tools/host/host_arduino.cpp
+//       lib/serial_stdio/serial_stdio.cpp lib/command_handler/command_handler.cpp
+//       lib/frame_codec/frame_codec.cpp
+//       -o serial_pty_bench
+//
+// Usage:
+//   serial_pty_bench [options]           rate sweep
+//   serial_pty_bench serve [options]     device only: prints the pty path for
+//                                        a terminal or pyserial, until Ctrl+C
+// Options:
+//   --baud N          emulated line rate (default 115200, 0: unpaced)
+//   --no-echo         turn off serial_stdio echo (halves the reply traffic)
+//   --rates a,b,...   commands per second (default 50,100,200,300,400,500,600,800,1000)
+//   --seconds S       duration of each rate step (default 2)
+//   --work-us N       busy time of the ping command, standing in for command cost
+//   --rx-buffer N     RX ring size (default 64, SERIAL_RX_BUFFER_SIZE)
+//   --tx-buffer N     TX ring size (default 64, SERIAL_TX_BUFFER_SIZE)
+//   --p99-limit MS    latency bound for a sustainable rate (default 50)
+//
+// The host CPU is far faster than the ATmega2560. Wire time and buffering
+// carry over to the board; command cost only does if --work-us models it.
+
+#include <Arduino.h>
+#include "host_pty.h"
+#include "serial_stdio.h"
+#include "command_handler.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+struct BenchOptions {
+    unsigned long baud = 115200;
+    bool echo = true;
+    std::vector<uint32_t> rates{50, 100, 200, 300, 400, 500, 600, 800, 1000};
+    double seconds = 2.0;
+    uint32_t workUs = 0;
+    size_t rxBuffer = 64;
+    size_t txBuffer = 64;
+    double p99LimitMs = 50.0;
+};
+
+static BenchOptions gOptions;
+static PtySerial gPty;
+static CommandHandler gHandler;
+static FILE* gConsole = nullptr;            // The real stdout, for results
+static std::atomic<bool> gDeviceRunning{false};
+
+// -----------------------------------------------------------------------------
+// Device side
+// -----------------------------------------------------------------------------
+static bool cmd_ping(void* context, const char* args) {
+    (void) context;
+    if (gOptions.workUs > 0) {
+        Clock::time_point until = Clock::now() + std::chrono::microseconds(gOptions.workUs);
+        while (Clock::now() < until) {
+        }
+    }
+    printf("pong %s\r\n", args != nullptr ? args : "");
+    return true;
+}
+
+static void wait_for_input() {
+    // Keep the virtual clock in step with real time for read timeouts
+    Clock::time_point start = Clock::now();
+    gPty.waitForData(1000);
+    host_clock_advance_us(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+static void device_init() {
+    gConsole = stdout;
+    FILE* console_err = stderr;
+
+    Serial.setBackend(&gPty);
+    initSerialStdio(gOptions.baud, gOptions.echo);
+    setSerialWaitHook(wait_for_input);
+    setSerialReadTimeout(100);
+
+    // serial_stdio pointed the standard streams at its fdev stream
+    FILE* serial = stdout;
+    stdin = host_fdev_open(serial, "r");
+    stdout = host_fdev_open(serial, "w");
+    stderr = console_err;
+    // AVR streams are unbuffered: every character reaches putchar at once
+    setvbuf(stdout, nullptr, _IONBF, 0);
+    setvbuf(stdin, nullptr, _IONBF, 0);
+
+    commandHandlerInit(&gHandler, nullptr, nullptr);
+    commandHandlerRegister(&gHandler, "ping", cmd_ping, nullptr, "Reply pong <args>");
+}
+
+static void device_loop() {
+    while (gDeviceRunning) {
+        int c = getchar();
+        if (c == EOF) {
+            clearerr(stdin);
+            continue;
+        }
+        commandHandlerProcessChar(&gHandler, static_cast<char>(c));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Load generator
+// -----------------------------------------------------------------------------
+struct RateResult {
+    uint32_t offered;
+    uint32_t sent;
+    uint32_t received;
+    double delivered;       // Replies per second
+    double p50;
+    double p90;
+    double p99;
+    double max;
+};
+
+static int open_far_end(const char* path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct termios mode;
+    if (tcgetattr(fd, &mode) == 0) {
+        cfmakeraw(&mode);
+        tcsetattr(fd, TCSANOW, &mode);
+    }
+    return fd;
+}
+
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/**
+ * Parse "pong <n>" replies out of received bytes (echo and other text skipped)
+ */
+class ReplyParser {
+public:
+    template <typename OnReply>
+    void feed(const char* data, size_t length, OnReply onReply) {
+        for (size_t i = 0; i < length; i++) {
+            char c = data[i];
+            if (c == '\r' || c == '\n') {
+                const char* line = line_.c_str();
+                const char* reply = strstr(line, "pong ");
+                if (reply != nullptr) {
+                    onReply(static_cast<uint32_t>(strtoul(reply + 5, nullptr, 10)));
+                }
+                line_.clear();
+            } else {
+                line_.push_back(c);
+            }
+        }
+    }
+
+private:
+    std::string line_;
+};
+
+static RateResult run_rate(int fd, uint32_t rate, uint32_t firstSeq) {
+    RateResult result{rate, 0, 0, 0, 0, 0, 0, 0};
+    uint32_t count = std::max<uint32_t>(1, static_cast<uint32_t>(rate * gOptions.seconds));
+    Clock::duration interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+
+    std::vector<Clock::time_point> sentAt(count);
+    std::vector<double> latencies;
+    latencies.reserve(count);
+    std::atomic<uint32_t> sent{0};
+    std::atomic<bool> sending{true};
+    Clock::time_point lastReply = Clock::now();
+    std::mutex sentMutex;
+
+    std::thread receiver([&] {
+        ReplyParser parser;
+        char chunk[256];
+        for (;;) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (poll(&pfd, 1, 20) > 0) {
+                ssize_t length = read(fd, chunk, sizeof(chunk));
+                if (length > 0) {
+                    Clock::time_point now = Clock::now();
+                    parser.feed(chunk, static_cast<size_t>(length), [&](uint32_t seq) {
+                        std::lock_guard<std::mutex> lock(sentMutex);
+                        // Late replies of an earlier rate step are ignored
+                        if (seq >= firstSeq && seq - firstSeq < sent) {
+                            std::chrono::duration<double, std::milli> latency = now - sentAt[seq - firstSeq];
+                            latencies.push_back(latency.count());
+                            lastReply = now;
+                        }
+                    });
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(sentMutex);
+            // Stop once everything came back, or replies stopped for a while
+            if (!sending && (latencies.size() >= sent || Clock::now() - lastReply > std::chrono::milliseconds(500))) {
+                break;
+            }
+        }
+    });
+
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < count; i++) {
+        std::this_thread::sleep_until(start + interval * i);
+        char line[24];
+        int length = snprintf(line, sizeof(line), "ping %u\r", firstSeq + i);
+        {
+            std::lock_guard<std::mutex> lock(sentMutex);
+            sentAt[i] = Clock::now();
+            sent = i + 1;
+            lastReply = std::max(lastReply, sentAt[i]);
+        }
+        if (write(fd, line, length) != length) {
+            break;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count() + 1.0 / rate;
+    sending = false;
+    receiver.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    result.sent = sent;
+    result.received = static_cast<uint32_t>(latencies.size());
+    result.delivered = result.received / elapsed;
+    result.p50 = percentile(latencies, 0.50);
+    result.p90 = percentile(latencies, 0.90);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.empty() ? 0.0 : latencies.back();
+    return result;
+}
+
+static bool sustainable(const RateResult& r) {
+    return r.received == r.sent && r.delivered >= 0.98 * r.offered && r.p99 <= gOptions.p99LimitMs;
+}
+
+static int run_sweep() {
+    int fd = open_far_end(gPty.path());
+    if (fd < 0) {
+        perror("open pty");
+        return 2;
+    }
+
+    fprintf(gConsole, "serial_stdio + command_handler on %s: baud %lu, echo %s, rx %zu, tx %zu, work %u us\n\n",
+            gPty.path(), gOptions.baud, gOptions.echo ? "on" : "off",
+            gOptions.rxBuffer, gOptions.txBuffer, gOptions.workUs);
+    fprintf(gConsole, "%8s %8s %8s %6s %10s %9s %9s %9s %9s\n",
+            "cmd/s", "sent", "replies", "lost", "delivered", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    uint32_t seq = 0;
+    uint32_t best = 0;
+    for (uint32_t rate : gOptions.rates) {
+        RateResult r = run_rate(fd, rate, seq);
+        seq += r.sent;
+        if (sustainable(r)) {
+            best = std::max(best, rate);
+        }
+        fprintf(gConsole, "%8u %8u %8u %6u %10.1f %9.2f %9.2f %9.2f %9.2f%s\n",
+                r.offered, r.sent, r.received, r.sent - r.received, r.delivered,
+                r.p50, r.p90, r.p99, r.max, sustainable(r) ? "" : "  *");
+        fflush(gConsole);
+    }
+    close(fd);
+
+    fprintf(gConsole, "\nRX overruns: %u, TX ring stalls: %u (putchar saw a full ring %u times)\n",
+            gPty.rxOverruns(), gPty.txStalls(), serialTxStalls());
+    if (best > 0) {
+        fprintf(gConsole, "Max sustainable rate: %u cmd/s (p99 <= %.0f ms, no lost replies)\n", best, gOptions.p99LimitMs);
+    } else {
+        fprintf(gConsole, "No tested rate was sustainable (* rows)\n");
+    }
+    return best > 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+static std::vector<uint32_t> parse_rates(const char* text) {
+    std::vector<uint32_t> rates;
+    for (char* end = nullptr; *text != '\0'; text = *end == ',' ? end + 1 : end) {
+        unsigned long rate = strtoul(text, &end, 10);
+        if (end == text) {
+            break;
+        }
+        if (rate > 0) {
+            rates.push_back(static_cast<uint32_t>(rate));
+        }
+    }
+    return rates;
+}
+
+static bool parse_options(int argc, char** argv, int first) {
+    for (int i = first; i < argc; i++) {
+        std::string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--no-echo") {
+            gOptions.echo = false;
+        } else if (option == "--baud" && hasValue) {
+            gOptions.baud = strtoul(argv[++i], nullptr, 10);
+        } else if (option == "--rates" && hasValue) {
+            gOptions.rates = parse_rates(argv[++i]);
+        } else if (option == "--seconds" && hasValue) {
+            gOptions.seconds = atof(argv[++i]);
+        } else if (option == "--work-us" && hasValue) {
+            gOptions.workUs = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (option == "--rx-buffer" && hasValue) {
+            gOptions.rxBuffer = strtoul(argv[++i], nullptr, 10);
+        } else if (option == "--tx-buffer" && hasValue) {
+            gOptions.txBuffer = strtoul(argv[++i], nullptr, 10);
+        } else if (option == "--p99-limit" && hasValue) {
+            gOptions.p99LimitMs = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return false;
+        }
+    }
+    return !gOptions.rates.empty() && gOptions.seconds > 0;
+}
+
+int main(int argc, char** argv) {
+    bool serve = argc > 1 && strcmp(argv[1], "serve") == 0;
+    if (!parse_options(argc, argv, serve ? 2 : 1)) {
+        fprintf(stderr, "usage: %s [serve] [--baud N] [--no-echo] [--rates a,b,...] [--seconds S]\n"
+                        "       [--work-us N] [--rx-buffer N] [--tx-buffer N] [--p99-limit MS]\n", argv[0]);
+        return 2;
+    }
+    if (!gPty.open(gOptions.baud, gOptions.rxBuffer, gOptions.txBuffer)) {
+        perror("pty");
+        return 2;
+    }
+
+    device_init();
+    gDeviceRunning = true;
+    std::thread device(device_loop);
+
+    int status;
+    if (serve) {
+        fprintf(gConsole, "Device on %s (Ctrl+C to stop); try: ping 1\n", gPty.path());
+        fflush(gConsole);
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        int signal;
+        sigwait(&signals, &signal);
+        status = 0;
+    } else {
+        status = run_sweep();
+    }
+
+    // The device loop notices within one read timeout
+    gDeviceRunning = false;
+    device.join();
+    gPty.close();
+    return status;
+}
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Turn telemetry frames produced by lib/telemetry into CSV.
+
+The firmware sends a descriptor frame (channel names and types, sample
+period) when streaming starts and once a second after that, so a capture
+may start anywhere in the stream; samples seen before the first
+descriptor are skipped. Sample times come from the sample number and the
+timer period. Text printed around the frames is ignored (or echoed to
+stderr with --text).
+
+Usage:
+  telemetry_decode.py capture.bin > samples.csv      # decode a raw capture
+  telemetry_decode.py --port COM5 -o samples.csv     # live, until Ctrl+C
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+from frame_codec import decode_frame
+
+FORMAT_VERSION = 1
+
+DESCRIPTOR_HEADER = struct.Struct("<BBIB")
+SAMPLE_HEADER = struct.Struct("<BIB")
+
+# lib/telemetry/telemetry.h TelemetryType
+TYPES = {
+    0: ("u8", "<B"),
+    1: ("i8", "<b"),
+    2: ("u16", "<H"),
+    3: ("i16", "<h"),
+    4: ("u32", "<I"),
+    5: ("i32", "<i"),
+    6: ("float", "<f"),
+}
+
+
+# -----------------------------------------------------------------------------
+# Stream decoding
+# -----------------------------------------------------------------------------
+class Schema:
+    def __init__(self, period_us, channels):
+        self.period_us = period_us
+        self.channels = channels
+        self.layout = struct.Struct("<" + "".join(TYPES[t][1][1] for _, t in channels))
+
+    @classmethod
+    def parse(cls, payload):
+        if len(payload) < DESCRIPTOR_HEADER.size:
+            return None
+        _, version, period_us, count = DESCRIPTOR_HEADER.unpack_from(payload, 0)
+        if version != FORMAT_VERSION:
+            return None
+        channels = []
+        pos = DESCRIPTOR_HEADER.size
+        for _ in range(count):
+            if pos + 2 > len(payload):
+                return None
+            kind, length = payload[pos], payload[pos + 1]
+            name = payload[pos + 2:pos + 2 + length].decode("ascii", errors="replace")
+            if kind not in TYPES:
+                return None
+            channels.append((name, kind))
+            pos += 2 + length
+        return cls(period_us, channels)
+
+    def same_as(self, other):
+        return other is not None and (self.period_us, self.channels) == (other.period_us, other.channels)
+
+
+class Decoder:
+    def __init__(self, out, text=None):
+        self.writer = csv.writer(out, lineterminator="\n")
+        self.out = out
+        self.text = text
+        self.chunk = bytearray()
+        self.schema = None
+        self.high = 0           # Bits of the sample number above 32
+        self.last = None        # Last unwrapped sample number
+        self.samples = 0
+        self.lost = 0
+        self.skipped = 0
+
+    def feed(self, data):
+        for byte in data:
+            if byte != 0:
+                self.chunk.append(byte)
+                continue
+            self.segment(bytes(self.chunk))
+            self.chunk = bytearray()
+
+    def finish(self):
+        if self.chunk:
+            self.segment(bytes(self.chunk))
+            self.chunk = bytearray()
+        self.out.flush()
+
+    def segment(self, data):
+        if not data:
+            return
+        payload = decode_frame(data)
+        if not payload:
+            if self.text is not None:
+                self.text.write(data.decode("ascii", errors="replace"))
+            return
+        if payload[0] == ord("D"):
+            self.descriptor(payload)
+        elif payload[0] == ord("S"):
+            self.sample_frame(payload)
+
+    def descriptor(self, payload):
+        schema = Schema.parse(payload)
+        if schema is None or schema.same_as(self.schema):
+            return
+        if self.schema is not None:
+            sys.stderr.write("telemetry: channel layout changed, new header follows\n")
+            self.last = None
+            self.high = 0
+        self.schema = schema
+        self.writer.writerow(["time_s", "sample"] + [name for name, _ in schema.channels])
+
+    def unwrap(self, number):
+        if self.last is not None:
+            candidate = self.high | number
+            if candidate < self.last:
+                self.high += 1 << 32
+        return self.high | number
+
+    def sample_frame(self, payload):
+        if self.schema is None:
+            self.skipped += 1
+            return
+        _, first, count = SAMPLE_HEADER.unpack_from(payload, 0)
+        layout = self.schema.layout
+        pos = SAMPLE_HEADER.size
+        number = self.unwrap(first)
+
+        for _ in range(count):
+            if pos + 1 + layout.size > len(payload):
+                sys.stderr.write("telemetry: sample frame does not match the descriptor\n")
+                return
+            number += payload[pos]
+            values = layout.unpack_from(payload, pos + 1)
+            pos += 1 + layout.size
+
+            if self.last is not None and number > self.last + 1:
+                self.lost += number - self.last - 1
+            self.last = number
+            self.samples += 1
+
+            row = ["%.6f" % (number * self.schema.period_us / 1e6), number]
+            row.extend("%.6g" % v if isinstance(v, float) else v for v in values)
+            self.writer.writerow(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", nargs="?", help="raw capture file (default: stdin)")
+    parser.add_argument("--port", help="read from a serial port instead of a file")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("-o", "--output", help="CSV file (default: stdout)")
+    parser.add_argument("--text", action="store_true", help="copy text outside frames to stderr")
+    args = parser.parse_args()
+
+    out = open(args.output, "w", newline="") if args.output else sys.stdout
+    decoder = Decoder(out, text=sys.stderr if args.text else None)
+
+    if args.port:
+        import serial  # pyserial
+
+        with serial.Serial(args.port, args.baud, timeout=0.1) as link:
+            try:
+                while True:
+                    decoder.feed(link.read(4096))
+            except KeyboardInterrupt:
+                pass
+    else:
+        if args.capture:
+            with open(args.capture, "rb") as f:
+                data = f.read()
+        else:
+            data = sys.stdin.buffer.read()
+        decoder.feed(data)
+    decoder.finish()
+
+    sys.stderr.write("telemetry: %d samples, %d lost, %d frames before the first descriptor\n"
+                     % (decoder.samples, decoder.lost, decoder.skipped))
+    if args.output:
+        out.close()
+    return 0 if decoder.samples > 0 or args.port else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())